@@ -0,0 +1,249 @@
+module aiplayer;
+import <algorithm>;
+import <array>;
+import <bit>;
+import <cstdlib>;
+import <functional>;
+import <memory>;
+import <string>;
+import <type_traits>;
+import <variant>;
+import <vector>;
+import board;
+import block;
+import level;
+import game;
+import command;
+import tokenreader;
+import constants;
+
+using namespace GameConstants;
+
+namespace {
+    // ~mask promotes to int; keep the result inside the board's columns
+    template <class Row>
+    Row emptyCells(Row mask, Row full) { return static_cast<Row>(~mask) & full; }
+}
+
+PieceMask PieceMask::fromBlock(const Block& block) {
+    const auto& cells = block.getCells();
+    int minRow = cells[0].first, maxRow = cells[0].first;
+    int minCol = cells[0].second, maxCol = cells[0].second;
+    for (const auto& cell : cells) {
+        minRow = std::min(minRow, cell.first);
+        maxRow = std::max(maxRow, cell.first);
+        minCol = std::min(minCol, cell.second);
+        maxCol = std::max(maxCol, cell.second);
+    }
+
+    PieceMask piece{};
+    piece.height = maxRow - minRow + 1;
+    piece.width = maxCol - minCol + 1;
+    piece.rowOffset = minRow;
+    piece.colOffset = minCol;
+    piece.rotation = block.getRotationState();
+    for (const auto& cell : cells) {
+        piece.rows[cell.first - minRow] |= static_cast<RowMask>(1u << (cell.second - minCol));
+    }
+    return piece;
+}
+
+bool PieceMask::sameShape(const PieceMask& other) const {
+    return rows == other.rows && height == other.height && width == other.width &&
+           rowOffset == other.rowOffset && colOffset == other.colOffset;
+}
+
+template <int Width, int Rows>
+BasicBitBoard<Width, Rows> BasicBitBoard<Width, Rows>::fromBoard(const Board& board) {
+    BasicBitBoard bits{};
+    for (int row = 0; row < Rows; ++row) {
+        Row mask = 0;
+        for (int col = 0; col < Width; ++col) {
+            if (board.getCell(row, col).isFilled()) mask |= static_cast<Row>(Row{1} << col);
+        }
+        bits.rows[row] = mask;
+    }
+    return bits;
+}
+
+template <int Width, int Rows>
+int BasicBitBoard<Width, Rows>::place(const PieceMask& piece, int x, int y) {
+    int shift = x + piece.colOffset;
+    int top = y + piece.rowOffset;
+    bool anyFull = false;
+    for (int i = 0; i < piece.height; ++i) {
+        rows[top + i] |= static_cast<Row>(static_cast<Row>(piece.rows[i]) << shift);
+        anyFull = anyFull || rows[top + i] == FULL;
+    }
+    if (!anyFull) return 0;
+
+    // Only rows the piece touched can have become full; compact everything above them
+    int cleared = 0;
+    int write = top + piece.height - 1;
+    for (int read = write; read >= 0; --read) {
+        if (rows[read] == FULL) {
+            ++cleared;
+            continue;
+        }
+        rows[write--] = rows[read];
+    }
+    while (write >= 0) rows[write--] = 0;
+    return cleared;
+}
+
+template <int Width, int Rows>
+Features BasicBitBoard<Width, Rows>::features(int linesCleared) const {
+    Features f{0, 0, 0, 0, linesCleared};
+    std::array<int, Width> heights{};
+
+    // Walk down from the top; `covered` holds every column with a filled cell above
+    Row covered = 0;
+    for (int row = 0; row < Rows; ++row) {
+        Row mask = rows[row];
+        Row empty = emptyCells(mask, FULL);
+
+        for (Row top = mask & static_cast<Row>(~covered); top; top &= top - 1) {
+            heights[std::countr_zero(top)] = Rows - row;
+        }
+        f.holes += std::popcount(static_cast<Row>(empty & covered));
+
+        // Open cells with a filled cell or wall on both sides
+        Row leftWall = static_cast<Row>((mask << 1) | 1u);
+        Row rightWall = static_cast<Row>((mask >> 1) | (Row{1} << (Width - 1)));
+        f.wells += std::popcount(static_cast<Row>(empty & ~covered & leftWall & rightWall));
+
+        covered |= mask;
+    }
+
+    for (int col = 0; col < Width; ++col) {
+        f.aggregateHeight += heights[col];
+        if (col > 0) f.bumpiness += std::abs(heights[col] - heights[col - 1]);
+    }
+    return f;
+}
+
+template struct BasicBitBoard<CLASSIC_BOARD.width, CLASSIC_BOARD.totalRows()>;
+template struct BasicBitBoard<STANDARD_BOARD.width, STANDARD_BOARD.totalRows()>;
+template struct BasicBitBoard<MARATHON_BOARD.width, MARATHON_BOARD.totalRows()>;
+
+AnyBitBoard makeBitBoard(const BoardGeometry& geometry) {
+    if (geometry == CLASSIC_BOARD) return ClassicBitBoard{};
+    if (geometry == STANDARD_BOARD) return StandardBitBoard{};
+    if (geometry == MARATHON_BOARD) return MarathonBitBoard{};
+    return std::monostate{};
+}
+
+LinearEvaluator::LinearEvaluator(double height, double holes, double bumpiness, double wells, double lines)
+    : heightWeight(height), holeWeight(holes), bumpinessWeight(bumpiness),
+      wellWeight(wells), lineWeight(lines) {}
+
+double LinearEvaluator::score(const Features& f) const {
+    return heightWeight * f.aggregateHeight + holeWeight * f.holes + bumpinessWeight * f.bumpiness +
+           wellWeight * f.wells + lineWeight * f.linesCleared;
+}
+
+namespace {
+    std::vector<PieceMask> buildRotations(char type) {
+        std::vector<PieceMask> rotations;
+        std::unique_ptr<Block> block = makeBlock(type, 0, INVALID_BLOCK_ID);
+        for (int turn = 0; turn < 4; ++turn) {
+            PieceMask piece = PieceMask::fromBlock(*block);
+            bool duplicate = std::any_of(rotations.begin(), rotations.end(),
+                                         [&](const PieceMask& seen) { return seen.sameShape(piece); });
+            if (!duplicate) rotations.push_back(piece);
+            block->rotateClockwise();
+        }
+        return rotations;
+    }
+}
+
+const std::vector<PieceMask>& pieceRotations(char type) {
+    // Indexed by type character; initialised once even with many threads
+    static const std::array<std::vector<PieceMask>, 128> table = [] {
+        std::array<std::vector<PieceMask>, 128> rotations;
+        for (char type : {'I', 'J', 'L', 'O', 'S', 'Z', 'T'}) rotations[type] = buildRotations(type);
+        return rotations;
+    }();
+    const std::vector<PieceMask>& rotations = table[static_cast<unsigned char>(type) & 127];
+    return rotations.empty() ? table['I'] : rotations;
+}
+
+const RotationStates& rotationStates(char type) {
+    static const std::array<RotationStates, 128> table = [] {
+        std::array<RotationStates, 128> states{};
+        for (char type : {'I', 'J', 'L', 'O', 'S', 'Z', 'T'}) {
+            std::unique_ptr<Block> block = makeBlock(type, 0, INVALID_BLOCK_ID);
+            for (int turn = 0; turn < NUM_ROTATION_STATES; ++turn) {
+                states[type][turn] = PieceMask::fromBlock(*block);
+                block->rotateClockwise();
+            }
+        }
+        return states;
+    }();
+    const RotationStates& states = table[static_cast<unsigned char>(type) & 127];
+    return states[0].height == 0 ? table['I'] : states;
+}
+
+AIPlayer::AIPlayer(Game* g, CommandInterpreter* interp, int p, std::unique_ptr<Evaluator> eval)
+    : game(g), interpreter(interp), player(p), evaluator(std::move(eval)),
+      bits(makeBitBoard(g->getGeometry())) {
+    if (!evaluator) evaluator = std::make_unique<LinearEvaluator>();
+}
+
+int AIPlayer::getPlayer() const { return player; }
+
+void AIPlayer::setPlanner(Planner p) { planner = std::move(p); }
+
+bool AIPlayer::shouldAct() const {
+    int actor = game->hasPendingEvent() ? game->peekEvent().player : game->getCurrentPlayer();
+    return actor == player;
+}
+
+Placement AIPlayer::choosePlacement() {
+    Board* board = game->getBoard(player);
+    const Block* block = board->getCurrentBlock();
+    if (!block) return Placement{-1, 0, 0, 0, 0, 0.0};
+    if (planner) return planner(*board);
+
+    const std::vector<PieceMask>& rotations = pieceRotations(block->getType());
+    const RotationStates& states = rotationStates(block->getType());
+    return std::visit([&](auto& engine) {
+        if constexpr (std::is_same_v<std::decay_t<decltype(engine)>, std::monostate>) {
+            return Placement{-1, 0, block->getX(), block->getY(), 0, 0.0};
+        } else {
+            engine = engine.fromBoard(*board);
+            return bestPlacement(engine, rotations, states, block->getX(), block->getY(),
+                                 block->getRotationState(), board->getHeavyDrops(), *evaluator);
+        }
+    }, bits);
+}
+
+void AIPlayer::playPlacement(const Placement& target, TokenReader& input) {
+    const Block* block = game->getBoard(player)->getCurrentBlock();
+    if (target.shape >= 0 && block) {
+        int turns = (target.rotation - block->getRotationState() + 4) % 4;
+        if (turns == 3) {
+            interpreter->executeCommand("counterclockwise", input);
+        } else if (turns > 0) {
+            interpreter->executeCommand(std::to_string(turns) + "clockwise", input);
+        }
+
+        // Rotation may have moved the block down under heavy; only columns matter here
+        int shift = target.x - game->getBoard(player)->getCurrentBlock()->getX();
+        if (shift < 0) {
+            interpreter->executeCommand(std::to_string(-shift) + "left", input);
+        } else if (shift > 0) {
+            interpreter->executeCommand(std::to_string(shift) + "right", input);
+        }
+    }
+    interpreter->executeCommand("drop", input);
+}
+
+void AIPlayer::takeTurn(TokenReader& input) {
+    // Heavy is the action that hurts an opponent most often
+    if (game->hasPendingEvent()) {
+        interpreter->executeCommand("heavy", input);
+        return;
+    }
+    playPlacement(choosePlacement(), input);
+}
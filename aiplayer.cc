@@ -0,0 +1,277 @@
+export module aiplayer;
+import <array>;
+import <cstdint>;
+import <functional>;
+import <memory>;
+import <type_traits>;
+import <variant>;
+import <vector>;
+import board;
+import block;
+import game;
+import command;
+import tokenreader;
+import constants;
+
+using namespace GameConstants;
+
+// Smallest unsigned type holding one row of a board `Width` columns wide
+export template <int Width>
+using RowMaskFor = std::conditional_t<(Width <= 16), std::uint16_t,
+                   std::conditional_t<(Width <= 32), std::uint32_t, std::uint64_t>>;
+
+// One classic board row as a bitmask: bit c is set if column c is filled.
+// Piece masks use it too, since no rotation is wider than four columns.
+export using RowMask = RowMaskFor<BOARD_WIDTH>;
+
+export constexpr RowMask FULL_ROW = (1u << BOARD_WIDTH) - 1;
+
+// Board features scored by an evaluator
+export struct Features {
+    int aggregateHeight;    // Sum of column heights
+    int holes;              // Empty cells with a filled cell above them
+    int bumpiness;          // Sum of height differences between neighbouring columns
+    int wells;              // Empty cells with both horizontal neighbours filled (or a wall)
+    int linesCleared;       // Rows cleared by the placement
+};
+
+// One rotation of a piece as row masks, normalized so its leftmost column is bit 0
+export struct PieceMask {
+    std::array<RowMask, CELLS_PER_BLOCK> rows;
+    int height;             // Rows used in `rows`
+    int rowOffset;          // Relative row of rows[0] (rotation can make it negative)
+    int colOffset;          // Relative column of bit 0
+    int width;
+    int rotation;           // Clockwise turns from the spawn orientation
+
+    static PieceMask fromBlock(const Block& block);
+
+    // Same cells, ignoring how many turns it took to get there
+    bool sameShape(const PieceMask& other) const;
+};
+
+// Grid occupancy as one mask per row. Feature extraction works on whole
+// rows at once with bit operations and std::popcount. The size is a template
+// parameter so every loop bound and wall mask is a constant; the engines for
+// the board presets are instantiated in the implementation unit.
+export template <int Width, int Rows>
+struct BasicBitBoard {
+    static_assert(Width > 0 && Width < 64, "a row must fit in 64 bits with room for the wall bit");
+
+    using Row = RowMaskFor<Width>;
+    static constexpr int WIDTH = Width;
+    static constexpr int ROWS = Rows;
+    static constexpr Row FULL = static_cast<Row>((std::uint64_t{1} << Width) - 1);
+
+    std::array<Row, Rows> rows;
+
+    // `board` must be Width x Rows
+    static BasicBitBoard fromBoard(const Board& board);
+
+    // True if the piece fits with its block position at (x, y)
+    bool fits(const PieceMask& piece, int x, int y) const {
+        int shift = x + piece.colOffset;
+        if (shift < 0 || shift + piece.width > Width) return false;
+        for (int i = 0; i < piece.height; ++i) {
+            int row = y + piece.rowOffset + i;
+            if (row < 0 || row >= Rows) return false;
+            if (rows[row] & (static_cast<Row>(piece.rows[i]) << shift)) return false;
+        }
+        return true;
+    }
+
+    // Lock the piece and clear full rows; returns the number of rows cleared
+    int place(const PieceMask& piece, int x, int y);
+
+    Features features(int linesCleared) const;
+};
+
+export using ClassicBitBoard = BasicBitBoard<CLASSIC_BOARD.width, CLASSIC_BOARD.totalRows()>;
+export using StandardBitBoard = BasicBitBoard<STANDARD_BOARD.width, STANDARD_BOARD.totalRows()>;
+export using MarathonBitBoard = BasicBitBoard<MARATHON_BOARD.width, MARATHON_BOARD.totalRows()>;
+
+extern template struct BasicBitBoard<CLASSIC_BOARD.width, CLASSIC_BOARD.totalRows()>;
+extern template struct BasicBitBoard<STANDARD_BOARD.width, STANDARD_BOARD.totalRows()>;
+extern template struct BasicBitBoard<MARATHON_BOARD.width, MARATHON_BOARD.totalRows()>;
+
+// The search, self-play records and broadcast frames work on the classic board
+export using BitBoard = ClassicBitBoard;
+
+// The engine for a board's size, chosen once when a seat is set up;
+// monostate for a size with no engine
+export using AnyBitBoard = std::variant<std::monostate, ClassicBitBoard, StandardBitBoard, MarathonBitBoard>;
+
+export AnyBitBoard makeBitBoard(const BoardGeometry& geometry);
+
+// Scores features; higher is better
+export class Evaluator {
+public:
+    virtual ~Evaluator() = default;
+    virtual double score(const Features& features) const = 0;
+};
+
+// Weighted sum of the features
+export class LinearEvaluator : public Evaluator {
+    double heightWeight;
+    double holeWeight;
+    double bumpinessWeight;
+    double wellWeight;
+    double lineWeight;
+
+public:
+    LinearEvaluator(double height = -0.510066, double holes = -0.35663,
+                    double bumpiness = -0.184483, double wells = -0.1, double lines = 0.760666);
+    double score(const Features& features) const override;
+};
+
+// A landing spot for the current piece
+export struct Placement {
+    int shape;              // Index into the piece's rotation list, -1 if none
+    int rotation;           // Clockwise turns from the spawn orientation
+    int x;                  // Block position once steered there
+    int y;                  // Row the block lands at
+    int linesCleared;
+    double score;
+};
+
+// Every distinct rotation of a piece type. Built once per process and
+// shared read-only by every bot and searcher.
+export const std::vector<PieceMask>& pieceRotations(char type);
+
+// Every rotation state of a piece type, indexed by clockwise turns from the
+// spawn orientation, including states that repeat a shape
+export using RotationStates = std::array<PieceMask, NUM_ROTATION_STATES>;
+export const RotationStates& rotationStates(char type);
+
+// All placements reachable by rotating at the block's position, shifting
+// sideways and dropping (score and lines are left at zero)
+export template <class Bits>
+std::vector<Placement> enumeratePlacements(const Bits& board, const std::vector<PieceMask>& rotations,
+                                           int startX, int startY) {
+    std::vector<Placement> placements;
+    for (int shape = 0; shape < static_cast<int>(rotations.size()); ++shape) {
+        const PieceMask& piece = rotations[shape];
+        if (!board.fits(piece, startX, startY)) continue;
+
+        // Sweep each way from the start until something blocks the row
+        int left = startX, right = startX;
+        while (board.fits(piece, left - 1, startY)) --left;
+        while (board.fits(piece, right + 1, startY)) ++right;
+
+        for (int x = left; x <= right; ++x) {
+            int y = startY;
+            while (board.fits(piece, x, y + 1)) ++y;
+            placements.push_back({shape, piece.rotation, x, y, 0, 0.0});
+        }
+    }
+    return placements;
+}
+
+// Placements reached by the commands AIPlayer::playPlacement() sends: the
+// rotation, then one multiplied left or right, then a drop. Each repetition
+// of a move or rotation is followed by heavyDrops moves down, as the heavy
+// level and effect apply them, so under heavy the piece sinks while it is
+// steered. Blocked steps are skipped as on the real board, and a target the
+// commands would not reach is left out. With no heavy drops this differs
+// from enumeratePlacements() only when a rotation is blocked part way.
+export template <class Bits>
+std::vector<Placement> steeredPlacements(const Bits& board, const std::vector<PieceMask>& rotations,
+                                         const RotationStates& states, int startX, int startY,
+                                         int startRotation, int heavyDrops) {
+    std::vector<Placement> placements;
+    if (!board.fits(states[startRotation], startX, startY)) return placements;
+
+    auto sink = [&](const PieceMask& piece, int x, int& y, int rows) {
+        for (int i = 0; i < rows && board.fits(piece, x, y + 1); ++i) ++y;
+    };
+    auto land = [&](int shape, int rotation, int x, int y) {
+        sink(rotations[shape], x, y, Bits::ROWS);
+        for (const Placement& seen : placements) {
+            if (seen.shape == shape && seen.x == x && seen.y == y) return;
+        }
+        placements.push_back({shape, rotation, x, y, 0, 0.0});
+    };
+
+    for (int turns = 0; turns < NUM_ROTATION_STATES; ++turns) {
+        // Three turns are sent as one counterclockwise
+        int rotation = startRotation;
+        int y = startY;
+        int steps = turns == 3 ? 1 : turns;
+        int step = turns == 3 ? NUM_ROTATION_STATES - 1 : 1;
+        for (int i = 0; i < steps; ++i) {
+            int next = (rotation + step) % NUM_ROTATION_STATES;
+            if (board.fits(states[next], startX, y)) rotation = next;
+            sink(states[rotation], startX, y, heavyDrops);
+        }
+        if (rotation != (startRotation + turns) % NUM_ROTATION_STATES) continue;
+
+        const PieceMask& piece = states[rotation];
+        int shape = 0;
+        while (shape < static_cast<int>(rotations.size()) && !rotations[shape].sameShape(piece)) ++shape;
+        if (shape == static_cast<int>(rotations.size())) continue;
+
+        // A shift of n columns walks the first n steps of this path, so the
+        // walk stops at the first blocked column
+        land(shape, rotation, startX, y);
+        for (int direction : {-1, 1}) {
+            int x = startX;
+            int row = y;
+            while (board.fits(piece, x + direction, row)) {
+                x += direction;
+                sink(piece, x, row, heavyDrops);
+                land(shape, rotation, x, row);
+            }
+        }
+    }
+    return placements;
+}
+
+// Highest-scoring placement the bot's commands reach from the piece's
+// position, or shape -1 if the piece cannot move at all
+export template <class Bits>
+Placement bestPlacement(const Bits& board, const std::vector<PieceMask>& rotations, const RotationStates& states,
+                        int startX, int startY, int startRotation, int heavyDrops, const Evaluator& evaluator) {
+    Placement best{-1, 0, startX, startY, 0, 0.0};
+    for (Placement candidate : steeredPlacements(board, rotations, states, startX, startY,
+                                                 startRotation, heavyDrops)) {
+        Bits after = board;
+        candidate.linesCleared = after.place(rotations[candidate.shape], candidate.x, candidate.y);
+        candidate.score = evaluator.score(after.features(candidate.linesCleared));
+        if (best.shape < 0 || candidate.score > best.score) best = candidate;
+    }
+    return best;
+}
+
+// Picks a placement on a seat's board in place of the one-piece search
+export using Planner = std::function<Placement(const Board& board)>;
+
+// Bot seat: plays one player's turns through the command interpreter
+export class AIPlayer {
+    Game* game;
+    CommandInterpreter* interpreter;
+    int player;
+    std::unique_ptr<Evaluator> evaluator;
+    Planner planner;
+    AnyBitBoard bits;       // Scratch engine for the seat's board size
+
+public:
+    AIPlayer(Game* g, CommandInterpreter* interp, int player,
+             std::unique_ptr<Evaluator> eval = nullptr);
+
+    int getPlayer() const;
+
+    // Placement shapes must index pieceRotations() for the piece type
+    void setPlanner(Planner p);
+
+    // True if the game is waiting on this seat (its turn or its special action)
+    bool shouldAct() const;
+
+    // Best placement for the current piece, scored by the evaluator
+    Placement choosePlacement();
+
+    // Steer the current piece to a placement from choosePlacement() and drop it
+    void playPlacement(const Placement& target, TokenReader& input);
+
+    // Answer a pending special action or place the current piece
+    void takeTurn(TokenReader& input);
+};
@@ -0,0 +1,383 @@
+// Microbenchmarks for Board hot paths and block generation
+//
+// Usage: board_bench [-json] [-time seconds] [-filter substring]
+//
+// Each benchmark runs on synthetic boards at several fill densities and
+// reports ns/op and heap allocations/op (counted by the operator new
+// replacement in tests/testsupport-impl.cc).
+import <iostream>;
+import <iomanip>;
+import <string>;
+import <vector>;
+import <memory>;
+import <algorithm>;
+import <chrono>;
+import <random>;
+import <cstdint>;
+import board;
+import block;
+import level;
+import scorekeeper;
+import constants;
+import testsupport;
+
+using namespace GameConstants;
+
+namespace {
+    using Clock = std::chrono::steady_clock;
+
+    // Fill densities (percent of visible cells) every benchmark runs at
+    const int DENSITIES[] = {0, 25, 50, 75};
+
+    // Rows packed from the bottom are filled to about this fraction
+    constexpr double PACKED_ROW_FILL = 0.85;
+
+    // Rows kept clear under the spawn point so pieces can still move
+    constexpr int SPAWN_CLEARANCE = 3;
+
+    constexpr long long MAX_OPS = 1LL << 30;
+
+    // Keeps benchmark results observable so loops are not optimized away
+    volatile long long sink = 0;
+
+    struct Result {
+        std::string name;
+        int density;
+        long long ops;
+        double nsPerOp;
+        double allocsPerOp;
+    };
+
+    // Times only the region between start() and stop(); setup outside it
+    // (such as building a batch of boards) is excluded
+    class Timer {
+        Clock::time_point begin;
+        std::uint64_t allocBegin = 0;
+
+    public:
+        Clock::duration elapsed{};
+        std::uint64_t allocations = 0;
+
+        void start() {
+            allocBegin = allocationCount();
+            begin = Clock::now();
+        }
+
+        void stop() {
+            elapsed += Clock::now() - begin;
+            allocations += allocationCount() - allocBegin;
+        }
+    };
+
+    // A board with its level and score keeper
+    struct Fixture {
+        std::unique_ptr<Level> level;
+        ScoreKeeper score;
+        std::unique_ptr<Board> board;
+
+        Fixture() : level(std::make_unique<Level2>(1)), board(std::make_unique<Board>()) {
+            board->setLevel(level.get());
+            board->setScoreKeeper(&score);
+        }
+    };
+
+    int countFilled(const Board& board, int row) {
+        int filled = 0;
+        for (int col = 0; col < BOARD_WIDTH; ++col) {
+            if (board.getCell(row, col).isFilled()) ++filled;
+        }
+        return filled;
+    }
+
+    // A piece locked into a synthetic board
+    struct Placement {
+        char type;
+        int rotations;
+        int x;
+        int y;
+    };
+
+    std::unique_ptr<Block> makePiece(Fixture& f, const Placement& p) {
+        auto block = f.level->createBlockFromType(p.type, f.board->getNextBlockId());
+        for (int r = 0; r < p.rotations; ++r) {
+            block->rotateClockwise();
+        }
+        block->setPosition(p.x, p.y);
+        return block;
+    }
+
+    // Choose random pieces packed into the bottom rows until `density` percent
+    // of the visible area is filled, never completing a row. Planned once per
+    // density so every benchmark board is the same and cheap to rebuild.
+    std::vector<Placement> planFill(int density, unsigned int seed) {
+        static const char TYPES[] = {'I', 'J', 'L', 'O', 'S', 'Z', 'T'};
+        Fixture f;
+        Board& board = *f.board;
+        std::mt19937 rng(seed);
+        std::vector<Placement> plan;
+
+        int target = density * BOARD_WIDTH * BOARD_HEIGHT / 100;
+        int rows = static_cast<int>(density * BOARD_HEIGHT / (100 * PACKED_ROW_FILL)) + 1;
+        if (rows > BOARD_HEIGHT - SPAWN_CLEARANCE) rows = BOARD_HEIGHT - SPAWN_CLEARANCE;
+        int topRow = TOTAL_ROWS - rows;
+
+        int filled = 0;
+        for (int attempt = 0; attempt < 20000 && filled < target; ++attempt) {
+            Placement p{TYPES[rng() % 7], static_cast<int>(rng() % NUM_ROTATION_STATES),
+                        static_cast<int>(rng() % BOARD_WIDTH),
+                        topRow + static_cast<int>(rng() % rows)};
+            auto block = makePiece(f, p);
+            if (!board.isValidPosition(block.get())) continue;
+
+            // Reject placements that would complete a row
+            auto cells = block->getAbsoluteCells();
+            bool completesRow = false;
+            for (const auto& [row, col] : cells) {
+                int cellsInRow = countFilled(board, row);
+                for (const auto& [r, c] : cells) {
+                    if (r == row) ++cellsInRow;
+                }
+                if (row < topRow || cellsInRow >= BOARD_WIDTH) completesRow = true;
+            }
+            if (completesRow) continue;
+
+            filled += static_cast<int>(cells.size());
+            board.setCurrentBlock(std::move(block));
+            board.lockBlock();
+            plan.push_back(p);
+        }
+        return plan;
+    }
+
+    // Lock the planned pieces, then spawn a current and next piece
+    void fillBoard(Fixture& f, const std::vector<Placement>& plan) {
+        for (const auto& p : plan) {
+            f.board->setCurrentBlock(makePiece(f, p));
+            f.board->lockBlock();
+        }
+        f.board->setCurrentBlock(f.level->createBlockFromType('T', f.board->getNextBlockId()));
+        f.board->setNextBlock(f.level->createBlockFromType('L', f.board->getNextBlockId()));
+    }
+
+    // Fill the bottom `count` rows completely (on top of the synthetic fill)
+    void fillRows(Fixture& f, int count) {
+        for (int row = TOTAL_ROWS - count; row < TOTAL_ROWS; ++row) {
+            for (int col = 0; col < BOARD_WIDTH; ++col) {
+                Cell& cell = f.board->getCell(row, col);
+                if (cell.isFilled()) continue;
+                cell.setFilled(true);
+                cell.setType('*');
+                cell.setBlockId(INVALID_BLOCK_ID);
+            }
+        }
+    }
+
+    class Runner {
+        double minSeconds;
+        std::string filter;
+        std::vector<Result> results;
+
+    public:
+        Runner(double seconds, std::string f) : minSeconds(seconds), filter(std::move(f)) {}
+
+        const std::vector<Result>& getResults() const { return results; }
+
+        // body(n, timer) performs n operations, timing only the measured part.
+        // The op count grows until the measured time reaches minSeconds.
+        template <typename Body>
+        void run(const std::string& name, int density, Body body) {
+            if (!filter.empty() && name.find(filter) == std::string::npos) return;
+
+            long long n = 1;
+            while (true) {
+                Timer timer;
+                body(n, timer);
+                double seconds = std::chrono::duration<double>(timer.elapsed).count();
+
+                if (seconds >= minSeconds || n >= MAX_OPS) {
+                    results.push_back({name, density, n, seconds * 1e9 / n,
+                                       static_cast<double>(timer.allocations) / n});
+                    return;
+                }
+                // Aim a little past the target to avoid creeping up on it
+                double scale = seconds > 0 ? 1.4 * minSeconds / seconds : 10;
+                if (scale > 10) scale = 10;
+                if (scale < 2) scale = 2;
+                n = static_cast<long long>(n * scale);
+            }
+        }
+    };
+
+    void runBoardBenchmarks(Runner& runner, int density) {
+        const auto plan = planFill(density, 1234 + density);
+
+        runner.run("Board::isValidPosition", density, [&](long long n, Timer& timer) {
+            Fixture f;
+            fillBoard(f, plan);
+            const Block* block = f.board->getCurrentBlock();
+            long long valid = 0;
+            timer.start();
+            for (long long i = 0; i < n; ++i) {
+                valid += f.board->isValidPosition(block);
+            }
+            timer.stop();
+            sink = sink + valid;
+        });
+
+        runner.run("Board::moveDown", density, [&](long long n, Timer& timer) {
+            Fixture f;
+            fillBoard(f, plan);
+            Block* block = f.board->getCurrentBlock();
+            timer.start();
+            for (long long i = 0; i < n; ++i) {
+                if (!f.board->moveDown()) block->setPosition(SPAWN_X, SPAWN_Y);
+            }
+            timer.stop();
+        });
+
+        runner.run("Board::rotate", density, [&](long long n, Timer& timer) {
+            Fixture f;
+            fillBoard(f, plan);
+            long long rotated = 0;
+            timer.start();
+            for (long long i = 0; i < n; ++i) {
+                rotated += f.board->rotate(true);
+            }
+            timer.stop();
+            sink = sink + rotated;
+        });
+
+        runner.run("Board::getGhostPosition", density, [&](long long n, Timer& timer) {
+            Fixture f;
+            fillBoard(f, plan);
+            long long rows = 0;
+            timer.start();
+            for (long long i = 0; i < n; ++i) {
+                rows += f.board->getGhostPosition().front().first;
+            }
+            timer.stop();
+            sink = sink + rows;
+        });
+
+        runner.run("Board::checkBlockRemoval", density, [&](long long n, Timer& timer) {
+            Fixture f;
+            fillBoard(f, plan);
+            timer.start();
+            for (long long i = 0; i < n; ++i) {
+                f.board->checkBlockRemoval();
+            }
+            timer.stop();
+        });
+
+        // drop and clearRows change the board, so each op gets a fresh board
+        // from a batch built outside the timed region
+        runner.run("Board::drop", density, [&](long long n, Timer& timer) {
+            constexpr long long BATCH = 1024;
+            for (long long done = 0; done < n; done += BATCH) {
+                long long count = std::min(BATCH, n - done);
+                std::vector<Fixture> fixtures(count);
+                for (auto& f : fixtures) fillBoard(f, plan);
+
+                timer.start();
+                for (auto& f : fixtures) f.board->drop();
+                timer.stop();
+            }
+        });
+
+        runner.run("Board::clearRows", density, [&](long long n, Timer& timer) {
+            constexpr long long BATCH = 1024;
+            long long cleared = 0;
+            for (long long done = 0; done < n; done += BATCH) {
+                long long count = std::min(BATCH, n - done);
+                std::vector<Fixture> fixtures(count);
+                for (auto& f : fixtures) {
+                    fillBoard(f, plan);
+                    fillRows(f, ROWS_FOR_SPECIAL_ACTION);
+                }
+
+                timer.start();
+                for (auto& f : fixtures) cleared += f.board->clearRows();
+                timer.stop();
+            }
+            sink = sink + cleared;
+        });
+    }
+
+    void runLevelBenchmarks(Runner& runner) {
+        for (int levelNum = 1; levelNum <= MAX_LEVEL; ++levelNum) {
+            runner.run("Level" + std::to_string(levelNum) + "::generateBlock", 0,
+                       [&](long long n, Timer& timer) {
+                std::unique_ptr<Level> level;
+                if (levelNum == 1) level = std::make_unique<Level1>(1);
+                else if (levelNum == 2) level = std::make_unique<Level2>(1);
+                else if (levelNum == 3) level = std::make_unique<Level3>(1);
+                else level = std::make_unique<Level4>(1);
+
+                long long types = 0;
+                timer.start();
+                for (long long i = 0; i < n; ++i) {
+                    types += level->generateBlock(static_cast<int>(i))->getType();
+                }
+                timer.stop();
+                sink = sink + types;
+            });
+        }
+    }
+
+    void printText(const std::vector<Result>& results) {
+        std::cout << std::left << std::setw(28) << "benchmark" << std::right
+                  << std::setw(8) << "density" << std::setw(12) << "ns/op"
+                  << std::setw(12) << "allocs/op" << std::setw(12) << "ops" << '\n';
+        std::cout << std::fixed;
+        for (const auto& r : results) {
+            std::cout << std::left << std::setw(28) << r.name << std::right
+                      << std::setw(7) << r.density << '%'
+                      << std::setw(12) << std::setprecision(1) << r.nsPerOp
+                      << std::setw(12) << std::setprecision(2) << r.allocsPerOp
+                      << std::setw(12) << r.ops << '\n';
+        }
+    }
+
+    void printJson(const std::vector<Result>& results) {
+        std::cout << "{\"benchmarks\": [\n";
+        for (size_t i = 0; i < results.size(); ++i) {
+            const auto& r = results[i];
+            std::cout << "  {\"name\": \"" << r.name << "\", \"density\": " << r.density
+                      << ", \"ns_per_op\": " << r.nsPerOp
+                      << ", \"allocs_per_op\": " << r.allocsPerOp
+                      << ", \"iterations\": " << r.ops << "}"
+                      << (i + 1 < results.size() ? ",\n" : "\n");
+        }
+        std::cout << "]}\n";
+    }
+}
+
+int main(int argc, char* argv[]) {
+    bool json = false;
+    double seconds = 0.2;
+    std::string filter;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "-json") {
+            json = true;
+        } else if (arg == "-time" && i + 1 < argc) {
+            seconds = std::stod(argv[++i]);
+        } else if (arg == "-filter" && i + 1 < argc) {
+            filter = argv[++i];
+        }
+    }
+
+    Runner runner(seconds, filter);
+    for (int density : DENSITIES) {
+        runBoardBenchmarks(runner, density);
+    }
+    runLevelBenchmarks(runner);
+
+    if (json) {
+        printJson(runner.getResults());
+    } else {
+        printText(runner.getResults());
+    }
+    return 0;
+}
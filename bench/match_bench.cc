@@ -0,0 +1,277 @@
+// End-to-end match benchmark: seeded two-player games played by a simple
+// placement policy through the real commands, Game::drop and switchPlayer,
+// with rendering disabled
+//
+// Usage: match_bench [-json] [-turns n] [-seed n] [-startlevel n] [-offscreen]
+//
+// -offscreen renders every turn into offscreen graphics displays (the text
+// output is discarded), so the drawing path is measured without an X server.
+//
+// Each start level (1-4 unless -startlevel is given) runs in its own child
+// process so peak RSS is reported per level.
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+import <iostream>;
+import <string>;
+import <vector>;
+import <memory>;
+import <chrono>;
+import <variant>;
+import game;
+import board;
+import block;
+import level;
+import command;
+import observer;
+import constants;
+
+using namespace GameConstants;
+
+namespace {
+    using Clock = std::chrono::steady_clock;
+
+    // Counts cleared rows on the boards it is attached to
+    class ClearCounter : public IObserver {
+    public:
+        long long lines = 0;
+
+        void notify(const BoardChange& change) override {
+            if (const auto* cleared = std::get_if<RowsCleared>(&change)) {
+                lines += cleared->count;
+            }
+        }
+    };
+
+    struct Target {
+        int rotation;
+        int x;
+    };
+
+    // Greedy placement: try every rotation and column for the current piece
+    // and prefer cleared lines, then no new holes, then a low landing spot
+    Target choosePlacement(Game& game) {
+        Board* board = game.getCurrentBoard();
+        const Block* current = board->getCurrentBlock();
+        Target best{current->getRotationState(), current->getX()};
+        int bestScore = -1000000;
+
+        for (int rotation = 0; rotation < NUM_ROTATION_STATES; ++rotation) {
+            auto piece = game.getCurrentLevel()->createBlockFromType(current->getType(), INVALID_BLOCK_ID);
+            for (int r = 0; r < rotation; ++r) {
+                piece->rotateClockwise();
+            }
+
+            for (int x = -CELLS_PER_BLOCK; x < BOARD_WIDTH; ++x) {
+                piece->setPosition(x, current->getY());
+                if (!board->isValidPosition(piece.get())) continue;
+
+                do {
+                    piece->move(0, 1);
+                } while (board->isValidPosition(piece.get()));
+                piece->move(0, -1);
+
+                auto cells = piece->getAbsoluteCells();
+                auto inPiece = [&](int row, int col) {
+                    for (const auto& [r, c] : cells) {
+                        if (r == row && c == col) return true;
+                    }
+                    return false;
+                };
+
+                int lines = 0;
+                int holes = 0;
+                int top = TOTAL_ROWS;
+                for (const auto& [row, col] : cells) {
+                    int filled = 0;
+                    for (int c = 0; c < BOARD_WIDTH; ++c) {
+                        if (board->getCell(row, c).isFilled() || inPiece(row, c)) ++filled;
+                    }
+                    // Count each full row once, at its leftmost piece cell
+                    if (filled == BOARD_WIDTH) {
+                        bool first = true;
+                        for (const auto& [r, c] : cells) {
+                            if (r == row && c < col) first = false;
+                        }
+                        if (first) ++lines;
+                    }
+                    if (row + 1 < TOTAL_ROWS && !inPiece(row + 1, col) &&
+                        !board->getCell(row + 1, col).isFilled()) {
+                        ++holes;
+                    }
+                    if (row < top) top = row;
+                }
+
+                int score = lines * 100 - holes * 20 + top;
+                if (score > bestScore) {
+                    bestScore = score;
+                    best = {rotation, x};
+                }
+                piece->setPosition(x, current->getY());
+            }
+        }
+        return best;
+    }
+
+    // Steer the current piece with the real commands (so heavy drops apply)
+    void playTurn(Game& game) {
+        static LeftCommand left;
+        static RightCommand right;
+        static RotateClockwiseCommand clockwise;
+        const CommandArgs noArgs;
+
+        Target target = choosePlacement(game);
+        Board* board = game.getCurrentBoard();
+
+        int turns = (target.rotation - board->getCurrentBlock()->getRotationState()
+                     + NUM_ROTATION_STATES) % NUM_ROTATION_STATES;
+        for (int i = 0; i < turns; ++i) {
+            clockwise.execute(&game, noArgs);
+        }
+
+        // Moves stop early if blocked or if heavy drops have landed the piece
+        for (int moves = 0; moves < BOARD_WIDTH; ++moves) {
+            int x = board->getCurrentBlock()->getX();
+            if (x == target.x) break;
+            if (x < target.x) right.execute(&game, noArgs);
+            else left.execute(&game, noArgs);
+            if (board->getCurrentBlock()->getX() == x) break;
+        }
+
+        game.drop();
+    }
+
+    struct Result {
+        int level;
+        long long turns;
+        long long games;
+        long long lines;
+        double seconds;
+        long peakRssKb;
+    };
+
+    Result runMatch(int level, unsigned int seed, long long turns, bool offscreen) {
+        Game game(seed, level, "biquadris_sequence1.txt", "biquadris_sequence2.txt", !offscreen,
+                  nullptr, CLASSIC_BOARD, NUM_PLAYERS, offscreen);
+        game.setHeadless(!offscreen);
+        std::streambuf* console = std::cout.rdbuf();
+        if (offscreen) std::cout.rdbuf(nullptr);
+
+        // Rotate through the special actions so every effect is exercised
+        int nextAction = 0;
+        game.setSpecialActionPolicy([&nextAction](int) {
+            static const char* ACTIONS[] = {"blind", "heavy", "force"};
+            static const char FORCED[] = {'Z', 'S', 'O'};
+            int i = nextAction++ % 3;
+            return SpecialActionChoice{ACTIONS[i], FORCED[i]};
+        });
+
+        ClearCounter counter;
+        Board* watched1 = nullptr;
+        Board* watched2 = nullptr;
+        long long games = 0;
+
+        auto start = Clock::now();
+        for (long long turn = 0; turn < turns; ++turn) {
+            // Boards are recreated on restart; follow the new ones
+            if (game.getCurrentBoard() != watched1 && game.getCurrentBoard() != watched2) {
+                watched1 = game.getCurrentBoard();
+                watched2 = game.getOpponentBoard();
+                watched1->attach(&counter);
+                watched2->attach(&counter);
+            }
+
+            playTurn(game);
+            if (offscreen) game.render();
+
+            if (game.shouldStopExecutingCommands()) {
+                game.clearStopExecutionFlag();
+                ++games;
+            } else {
+                game.switchPlayer();
+            }
+        }
+        double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+        std::cout.rdbuf(console);
+
+        rusage usage{};
+        getrusage(RUSAGE_SELF, &usage);
+        return {level, turns, games, counter.lines, seconds, usage.ru_maxrss};
+    }
+
+    void printResult(const Result& r, bool json, bool first) {
+        double turnsPerSecond = r.turns / r.seconds;
+        double linesPerSecond = r.lines / r.seconds;
+        if (json) {
+            std::cout << (first ? "" : ",\n")
+                      << "  {\"start_level\": " << r.level << ", \"turns\": " << r.turns
+                      << ", \"games\": " << r.games << ", \"lines\": " << r.lines
+                      << ", \"seconds\": " << r.seconds
+                      << ", \"turns_per_sec\": " << turnsPerSecond
+                      << ", \"lines_per_sec\": " << linesPerSecond
+                      << ", \"peak_rss_kb\": " << r.peakRssKb << "}";
+        } else {
+            std::cout << "level " << r.level << ": " << r.turns << " turns, " << r.games
+                      << " games, " << r.lines << " lines in " << r.seconds << " s | "
+                      << static_cast<long long>(turnsPerSecond) << " turns/s, "
+                      << static_cast<long long>(linesPerSecond) << " lines/s, peak RSS "
+                      << r.peakRssKb << " KB\n";
+        }
+    }
+}
+
+int main(int argc, char* argv[]) {
+    bool json = false;
+    long long turns = 20000;
+    unsigned int seed = 1;
+    int onlyLevel = 0;
+    bool offscreen = false;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "-json") {
+            json = true;
+        } else if (arg == "-turns" && i + 1 < argc) {
+            turns = std::stoll(argv[++i]);
+        } else if (arg == "-seed" && i + 1 < argc) {
+            seed = std::stoul(argv[++i]);
+        } else if (arg == "-startlevel" && i + 1 < argc) {
+            onlyLevel = std::stoi(argv[++i]);
+            if (onlyLevel < 1) onlyLevel = 1;
+            if (onlyLevel > MAX_LEVEL) onlyLevel = MAX_LEVEL;
+        } else if (arg == "-offscreen") {
+            offscreen = true;
+        }
+    }
+
+    if (json) std::cout << "{\"matches\": [\n";
+
+    bool first = true;
+    for (int level = 1; level <= MAX_LEVEL; ++level) {
+        if (onlyLevel != 0 && level != onlyLevel) continue;
+
+        // A fresh process per level keeps peak RSS from carrying over
+        std::cout.flush();
+        pid_t pid = fork();
+        if (pid == 0) {
+            printResult(runMatch(level, seed, turns, offscreen), json, first);
+            std::cout.flush();
+            _exit(0);
+        }
+        if (pid < 0) {
+            std::cerr << "fork failed; running level " << level << " in process\n";
+            printResult(runMatch(level, seed, turns, offscreen), json, first);
+        } else {
+            int status = 0;
+            waitpid(pid, &status, 0);
+            if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+                std::cerr << "level " << level << " benchmark failed\n";
+                return 1;
+            }
+        }
+        first = false;
+    }
+
+    if (json) std::cout << "\n]}\n";
+    return 0;
+}
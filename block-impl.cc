@@ -16,6 +16,7 @@ int Block::getX() const { return posX; }
 int Block::getY() const { return posY; }
 int Block::getBlockId() const { return blockId; }
 int Block::getLevelGenerated() const { return levelGenerated; }
+int Block::getRotationState() const { return rotationState; }
 const std::vector<std::pair<int, int>> &Block::getCells() const { return cells; }
 
 // Get absolute cell positions
@@ -22,6 +22,7 @@ public:
     int getY() const;
     int getBlockId() const;
     int getLevelGenerated() const;
+    int getRotationState() const;
     const std::vector<std::pair<int, int>> &getCells() const;
 
     // Get absolute cell positions
@@ -1,8 +1,10 @@
 module board;
+import <cstdint>;
 import <vector>;
 import <map>;
 import <memory>;
 import <algorithm>;
+import <string_view>;
 import cell;
 import block;
 import blocks;
@@ -11,23 +13,193 @@ import observer;
 import scorekeeper;
 import level;
 import effect;
+import instrument;
+import serial;
 
 using namespace GameConstants;
 
-Board::Board() : level(nullptr), score(nullptr), nextBlockId(0), blocksSinceLastClear(0),
-          blindActive(false), heavyCount(0) {
-    // Initialize grid (18 rows x 11 cols based on constants)
-    grid.resize(TOTAL_ROWS, std::vector<Cell>(BOARD_WIDTH));
+namespace {
+    // Piece types in key-table order; anything else shares the last slot
+    constexpr std::string_view PIECE_TYPES = "IJLOSZT*";
+    constexpr int TYPE_SLOTS = 9;
+
+    struct ZobristKeys {
+        std::uint64_t cells[MAX_TOTAL_ROWS][MAX_BOARD_WIDTH];  // Sized for the largest preset
+        std::uint64_t current[TYPE_SLOTS][4];
+        std::uint64_t next[TYPE_SLOTS][4];
+        std::uint64_t blind;
+        std::uint64_t heavy;
+    };
+
+    // Fixed splitmix64 stream, so hashes are stable across runs and builds
+    constexpr ZobristKeys makeZobristKeys() {
+        ZobristKeys keys{};
+        std::uint64_t state = 0x9e3779b97f4a7c15ULL;
+        auto nextKey = [&state] {
+            std::uint64_t z = (state += 0x9e3779b97f4a7c15ULL);
+            z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+            z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+            return z ^ (z >> 31);
+        };
+        for (auto& row : keys.cells) for (auto& key : row) key = nextKey();
+        for (auto& type : keys.current) for (auto& key : type) key = nextKey();
+        for (auto& type : keys.next) for (auto& key : type) key = nextKey();
+        keys.blind = nextKey();
+        keys.heavy = nextKey();
+        return keys;
+    }
+
+    constexpr ZobristKeys ZOBRIST = makeZobristKeys();
+
+    int typeSlot(char type) {
+        auto pos = PIECE_TYPES.find(type);
+        return pos == std::string_view::npos ? TYPE_SLOTS - 1 : static_cast<int>(pos);
+    }
+
+    std::uint64_t currentKey(const Block* block) {
+        return block ? ZOBRIST.current[typeSlot(block->getType())][block->getRotationState() & 3] : 0;
+    }
+
+    std::uint64_t nextKey(const Block* block) {
+        return block ? ZOBRIST.next[typeSlot(block->getType())][block->getRotationState() & 3] : 0;
+    }
+
+    // Piece type, level, id, position and rotation; a lone 0 for no piece
+    void saveBlock(ByteWriter& out, const Block* block) {
+        if (!block) {
+            out.u8(0);
+            return;
+        }
+        out.u8(static_cast<std::uint8_t>(block->getType()));
+        out.u8(static_cast<std::uint8_t>(block->getLevelGenerated()));
+        out.i32(block->getBlockId());
+        out.i8(block->getX());
+        out.i8(block->getY());
+        out.u8(static_cast<std::uint8_t>(block->getRotationState()));
+    }
+
+    // A piece or cell type a save file may name
+    bool isPieceType(char type) {
+        return type != 0 && PIECE_TYPES.find(type) != std::string_view::npos;
+    }
+
+    bool inBounds(const Block* block, const BoardGeometry& geometry) {
+        for (auto [row, col] : block->getAbsoluteCells()) {
+            if (row < 0 || row >= geometry.totalRows() || col < 0 || col >= geometry.width) return false;
+        }
+        return true;
+    }
 }
 
-Board::~Board() {
-    // Clean up all active effects to prevent memory leaks
-    for (Effect* effect : activeEffects) {
-        delete effect;
+namespace {
+    using Grid = std::vector<std::vector<Cell>>;
+
+    // The grid scans with the board size as template arguments, so their
+    // loops have constant bounds. Rows are scanned whole rather than left
+    // early, which a constant width turns into straight-line compares. Size
+    // 0 reads it from the geometry instead, for boards that are not a preset.
+    template<int Width, int Rows>
+    struct GridCore {
+        static int width(const BoardGeometry& geometry) {
+            if constexpr (Width > 0) return Width;
+            else return geometry.width;
+        }
+
+        static int rows(const BoardGeometry& geometry) {
+            if constexpr (Rows > 0) return Rows;
+            else return geometry.totalRows();
+        }
+
+        // True if every cell of the block is on the grid and free or its own
+        static bool fits(const Grid& grid, const BoardGeometry& geometry, const Block& block) {
+            for (auto [row, col] : block.getAbsoluteCells()) {
+                if (row < 0 || row >= rows(geometry) || col < 0 || col >= width(geometry)) return false;
+                const Cell& cell = grid[row][col];
+                if (cell.isFilled() && cell.getBlockId() != block.getBlockId()) return false;
+            }
+            return true;
+        }
+
+        // Lowest full row at or above fromRow, or -1
+        static int findFullRow(const Grid& grid, const BoardGeometry& geometry, int fromRow) {
+            for (int row = fromRow; row >= 0; --row) {
+                const std::vector<Cell>& cells = grid[row];
+                bool full = true;
+                for (int col = 0; col < width(geometry); ++col) full &= cells[col].isFilled();
+                if (full) return row;
+            }
+            return -1;
+        }
+
+        // True if any cell still belongs to the block
+        static bool holdsBlock(const Grid& grid, const BoardGeometry& geometry, int blockId) {
+            for (int row = 0; row < rows(geometry); ++row) {
+                const std::vector<Cell>& cells = grid[row];
+                bool found = false;
+                for (int col = 0; col < width(geometry); ++col) found |= cells[col].getBlockId() == blockId;
+                if (found) return true;
+            }
+            return false;
+        }
+
+        // Zobrist keys of the filled cells in rows [0, lastRow]
+        static std::uint64_t rowsKey(const Grid& grid, const BoardGeometry& geometry, int lastRow) {
+            std::uint64_t key = 0;
+            for (int row = 0; row <= lastRow; ++row) {
+                for (int col = 0; col < width(geometry); ++col) {
+                    if (grid[row][col].isFilled()) key ^= ZOBRIST.cells[row][col];
+                }
+            }
+            return key;
+        }
+
+        // Row a block dropped down column col from the top of the visible
+        // area comes to rest in (one above it if that row is already filled)
+        static int landingRow(const Grid& grid, const BoardGeometry& geometry, int col) {
+            for (int row = geometry.reserve; row < rows(geometry); ++row) {
+                if (grid[row][col].isFilled()) return row - 1;
+            }
+            return rows(geometry) - 1;
+        }
+    };
+}
+
+struct BoardKernels {
+    bool (*fits)(const Grid&, const BoardGeometry&, const Block&);
+    int (*findFullRow)(const Grid&, const BoardGeometry&, int);
+    bool (*holdsBlock)(const Grid&, const BoardGeometry&, int);
+    std::uint64_t (*rowsKey)(const Grid&, const BoardGeometry&, int);
+    int (*landingRow)(const Grid&, const BoardGeometry&, int);
+};
+
+namespace {
+    template struct GridCore<CLASSIC_BOARD.width, CLASSIC_BOARD.totalRows()>;
+    template struct GridCore<STANDARD_BOARD.width, STANDARD_BOARD.totalRows()>;
+    template struct GridCore<MARATHON_BOARD.width, MARATHON_BOARD.totalRows()>;
+    template struct GridCore<0, 0>;
+
+    template<int Width, int Rows>
+    constexpr BoardKernels KERNELS{&GridCore<Width, Rows>::fits, &GridCore<Width, Rows>::findFullRow,
+                                   &GridCore<Width, Rows>::holdsBlock, &GridCore<Width, Rows>::rowsKey,
+                                   &GridCore<Width, Rows>::landingRow};
+
+    const BoardKernels* kernelsFor(const BoardGeometry& geometry) {
+        if (geometry == CLASSIC_BOARD) return &KERNELS<CLASSIC_BOARD.width, CLASSIC_BOARD.totalRows()>;
+        if (geometry == STANDARD_BOARD) return &KERNELS<STANDARD_BOARD.width, STANDARD_BOARD.totalRows()>;
+        if (geometry == MARATHON_BOARD) return &KERNELS<MARATHON_BOARD.width, MARATHON_BOARD.totalRows()>;
+        return &KERNELS<0, 0>;
     }
-    activeEffects.clear();
 }
 
+Board::Board(const BoardGeometry& geometry)
+    : geometry(geometry), kernels(kernelsFor(geometry)), level(nullptr), score(nullptr), nextBlockId(0),
+      blocksSinceLastClear(0), blindActive(false), heavyCount(0), zobrist(0) {
+    // Reserve rows sit above the visible area (18 rows x 11 cols on the classic board)
+    grid.resize(geometry.totalRows(), std::vector<Cell>(geometry.width));
+}
+
+const BoardGeometry& Board::getGeometry() const { return geometry; }
+
 void Board::attach(IObserver* observer) {
     displays.push_back(observer);
 }
@@ -39,12 +211,23 @@ void Board::detach(IObserver* observer) {
     );
 }
 
-void Board::notifyObservers() {
+void Board::notifyObservers(const BoardChange& change) {
     for (auto* observer : displays) {
-        observer->update();
+        observer->notify(change);
     }
 }
 
+void Board::notifyPieceMoved() {
+    if (!currentBlock) return;
+    notifyObservers(PieceMoved{currentBlock->getType(), currentBlock->getX(),
+                               currentBlock->getY(), currentBlock->getRotationState()});
+}
+
+// XOR every filled cell in rows [0, lastRow] into the hash
+void Board::hashRows(int lastRow) {
+    zobrist ^= kernels->rowsKey(grid, geometry, lastRow);
+}
+
 void Board::setLevel(Level* l) { level = l; }
 
 void Board::setScoreKeeper(ScoreKeeper* s) { score = s; }
@@ -61,38 +244,27 @@ const Block* Board::getCurrentBlock() const { return currentBlock.get(); }
 
 Block* Board::getNextBlock() { return nextBlock.get(); }
 
+const Block* Board::getNextBlock() const { return nextBlock.get(); }
+
 void Board::setCurrentBlock(std::unique_ptr<Block> block) {
+    zobrist ^= currentKey(currentBlock.get()) ^ currentKey(block.get());
     currentBlock = std::move(block);
+    notifyPieceMoved();
 }
 
 void Board::setNextBlock(std::unique_ptr<Block> block) {
+    zobrist ^= nextKey(nextBlock.get()) ^ nextKey(block.get());
     nextBlock = std::move(block);
+    if (nextBlock) notifyObservers(NextPieceChanged{nextBlock->getType()});
 }
 
 std::unique_ptr<Block> Board::takeNextBlock() {
+    zobrist ^= nextKey(nextBlock.get());
     return std::move(nextBlock);
 }
 
 bool Board::isValidPosition(const Block* block) const {
-    if (!block) return false;
-
-    auto cells = block->getAbsoluteCells();
-    for (const auto& cell : cells) {
-        int row = cell.first;
-        int col = cell.second;
-
-        // Check boundaries
-        if (row < 0 || row >= TOTAL_ROWS || col < 0 || col >= BOARD_WIDTH) {
-            return false;
-        }
-
-        // Check if cell is already occupied by a different block
-        if (grid[row][col].isFilled() &&
-            grid[row][col].getBlockId() != block->getBlockId()) {
-            return false;
-        }
-    }
-    return true;
+    return block && kernels->fits(grid, geometry, *block);
 }
 
 bool Board::moveLeft() {
@@ -103,6 +275,7 @@ bool Board::moveLeft() {
         currentBlock->move(1, 0);  // Revert
         return false;
     }
+    notifyPieceMoved();
     return true;
 }
 
@@ -114,6 +287,7 @@ bool Board::moveRight() {
         currentBlock->move(-1, 0);  // Revert
         return false;
     }
+    notifyPieceMoved();
     return true;
 }
 
@@ -125,12 +299,14 @@ bool Board::moveDown() {
         currentBlock->move(0, -1);  // Revert
         return false;
     }
+    notifyPieceMoved();
     return true;
 }
 
 bool Board::rotate(bool clockwise) {
     if (!currentBlock) return false;
 
+    std::uint64_t before = currentKey(currentBlock.get());
     if (clockwise) {
         currentBlock->rotateClockwise();
     } else {
@@ -146,22 +322,29 @@ bool Board::rotate(bool clockwise) {
         }
         return false;
     }
+    zobrist ^= before ^ currentKey(currentBlock.get());
+    notifyPieceMoved();
     return true;
 }
 
 void Board::lockBlock() {
     if (!currentBlock) return;
 
+    CellsChanged change{};
     auto cells = currentBlock->getAbsoluteCells();
     for (const auto& cell : cells) {
         int row = cell.first;
         int col = cell.second;
+        if (!grid[row][col].isFilled()) zobrist ^= ZOBRIST.cells[row][col];
         grid[row][col].setFilled(true);
         grid[row][col].setType(currentBlock->getType());
         grid[row][col].setBlockId(currentBlock->getBlockId());
+        if (change.count < CELLS_PER_BLOCK) change.cells[change.count++] = cell;
     }
+    notifyObservers(change);
 
     // Store in active blocks
+    zobrist ^= currentKey(currentBlock.get());
     activeBlocks[currentBlock->getBlockId()] = std::move(currentBlock);
 }
 
@@ -209,84 +392,80 @@ std::vector<std::pair<int, int>> Board::getGhostPosition() const {
 void Board::dropCenterBlock(std::unique_ptr<Block> block) {
     if (!block) return;
 
-    int centerCol = BOARD_WIDTH / 2;  // Column 5 for 11-wide board
-
-    // Start from the top and drop down until we hit something
-    int dropRow = RESERVE_ROWS;  // Start at top of visible area
+    int centerCol = geometry.centerColumn();  // Column 5 for 11-wide board
 
-    // Find where the block should land (first filled cell from top)
-    for (int row = RESERVE_ROWS; row < TOTAL_ROWS; ++row) {
-        if (grid[row][centerCol].isFilled()) {
-            // Land on top of this filled cell
-            dropRow = row - 1;
-            break;
-        }
-        dropRow = row;  // Can fall to this row
-    }
+    // Land on the first filled cell from the top of the visible area
+    int dropRow = kernels->landingRow(grid, geometry, centerCol);
 
     // Set block position to where it landed
     block->setPosition(centerCol, dropRow);
 
     // Place all cells of the block (should be just 1 cell for SingleBlock)
+    CellsChanged change{};
     for (const auto& [relRow, relCol] : block->getCells()) {
         int absRow = block->getY() + relRow;
         int absCol = block->getX() + relCol;
 
-        if (absRow >= 0 && absRow < TOTAL_ROWS &&
-            absCol >= 0 && absCol < BOARD_WIDTH) {
+        if (absRow >= 0 && absRow < geometry.totalRows() &&
+            absCol >= 0 && absCol < geometry.width) {
+            if (!grid[absRow][absCol].isFilled()) zobrist ^= ZOBRIST.cells[absRow][absCol];
             grid[absRow][absCol].setFilled(true);
             grid[absRow][absCol].setType(block->getType());
             grid[absRow][absCol].setBlockId(block->getBlockId());
+            if (change.count < CELLS_PER_BLOCK) change.cells[change.count++] = {absRow, absCol};
         }
     }
+    notifyObservers(change);
 
     // Store in active blocks
     activeBlocks[block->getBlockId()] = std::move(block);
 }
 
 int Board::clearRows() {
+    Instrument::ScopedTimer timer(Instrument::Phase::ClearRows);
     int cleared = 0;
-
-    for (int row = TOTAL_ROWS - 1; row >= 0; --row) {
-        bool full = true;
-        for (int col = 0; col < BOARD_WIDTH; ++col) {
-            if (!grid[row][col].isFilled()) {
-                full = false;
-                break;
-            }
+    int lowestCleared = -1;
+    std::uint64_t rowMask = 0;
+
+    // A cleared row pulls the next one down into its place, so the scan resumes at the same index
+    for (int row = kernels->findFullRow(grid, geometry, geometry.totalRows() - 1); row >= 0;
+         row = kernels->findFullRow(grid, geometry, row)) {
+        // Everything from the lowest full row up moves; rehash it once the clearing is done
+        if (cleared == 0) {
+            lowestCleared = row;
+            hashRows(row);
         }
 
-        if (full) {
-            // Remove this row
-            grid.erase(grid.begin() + row);
-            // Add new empty row at top
-            grid.insert(grid.begin(), std::vector<Cell>(BOARD_WIDTH));
-            cleared++;
-            row++;  // Check same row again since rows shifted
-        }
+        // Rows above already shifted down by one per clear so far
+        rowMask |= std::uint64_t{1} << (row - cleared);
+
+        // Remove this row
+        grid.erase(grid.begin() + row);
+        // Add new empty row at top
+        grid.insert(grid.begin(), std::vector<Cell>(geometry.width));
+        cleared++;
     }
 
+    if (cleared > 0) {
+        hashRows(lowestCleared);
+        notifyObservers(RowsCleared{rowMask, cleared});
+    }
+    Instrument::count(Instrument::Counter::LinesCleared, cleared);
     return cleared;
 }
 
+void Board::addScore(int points) {
+    if (!score || points == 0) return;
+    score->addScore(points);
+    notifyObservers(ScoreChanged{score->getCurrentScore(), points});
+}
+
 void Board::checkBlockRemoval() {
+    Instrument::ScopedTimer timer(Instrument::Phase::BlockRemoval);
     std::vector<int> blocksToRemove;
 
     for (auto& [blockId, block] : activeBlocks) {
-        bool stillExists = false;
-        for (int row = 0; row < TOTAL_ROWS; ++row) {
-            for (int col = 0; col < BOARD_WIDTH; ++col) {
-                if (grid[row][col].getBlockId() == blockId) {
-                    stillExists = true;
-                    break;
-                }
-            }
-            if (stillExists) break;
-        }
-
-        if (!stillExists) {
-            blocksToRemove.push_back(blockId);
-        }
+        if (!kernels->holdsBlock(grid, geometry, blockId)) blocksToRemove.push_back(blockId);
     }
 
     // Remove blocks and award points
@@ -294,7 +473,7 @@ void Board::checkBlockRemoval() {
         if (score && activeBlocks.count(blockId)) {
             int levelGen = activeBlocks[blockId]->getLevelGenerated();
             int points = score->calculateBlockRemovalPoints(levelGen);
-            score->addScore(points);
+            addScore(points);
         }
         activeBlocks.erase(blockId);
     }
@@ -320,59 +499,77 @@ bool Board::replaceCurrentBlock(char type) {
     if (!newBlock) return false;
 
     // Replace current block
+    zobrist ^= currentKey(currentBlock.get()) ^ currentKey(newBlock.get());
     currentBlock = std::move(newBlock);
+    notifyPieceMoved();
     return true;
 }
 
-void Board::setBlindActive(bool active) { blindActive = active; }
+std::uint64_t Board::hash() const { return zobrist; }
 
-void Board::incrementHeavy() { heavyCount++; }
+std::uint64_t Board::computeHash() const {
+    std::uint64_t h = currentKey(currentBlock.get()) ^ nextKey(nextBlock.get());
+    h ^= kernels->rowsKey(grid, geometry, geometry.totalRows() - 1);
+    if (blindActive) h ^= ZOBRIST.blind;
+    if (heavyCount > 0) h ^= ZOBRIST.heavy;
+    return h;
+}
 
-void Board::decrementHeavy() { if (heavyCount > 0) heavyCount--; }
+void Board::setBlindActive(bool active) {
+    if (blindActive == active) return;
+    blindActive = active;
+    zobrist ^= ZOBRIST.blind;
+    notifyObservers(EffectToggled{Effect::Type::Blind, active});
+}
+
+void Board::incrementHeavy() {
+    heavyCount++;
+    if (heavyCount == 1) {
+        zobrist ^= ZOBRIST.heavy;
+        notifyObservers(EffectToggled{Effect::Type::Heavy, true});
+    }
+}
+
+void Board::decrementHeavy() {
+    if (heavyCount == 0) return;
+    heavyCount--;
+    if (heavyCount == 0) {
+        zobrist ^= ZOBRIST.heavy;
+        notifyObservers(EffectToggled{Effect::Type::Heavy, false});
+    }
+}
 
 bool Board::hasBlindEffect() const { return blindActive; }
 
 bool Board::hasHeavyEffect() const { return heavyCount > 0; }
 
-void Board::addEffect(Effect* effect) {
-    activeEffects.push_back(effect);
+int Board::getHeavyDrops() const {
+    return (level && level->isHeavy() ? LEVEL_HEAVY_DROP : 0) + (hasHeavyEffect() ? HEAVY_EXTRA_DROP : 0);
+}
 
-    // Apply effect immediately based on type
-    auto effectType = effect->getType();
+void Board::addEffect(const Effect& effect) {
+    if (!activeEffects.add(effect)) return;
 
-    if (effectType == Effect::Type::Blind) {
+    // Apply effect immediately based on type
+    if (effect.type == Effect::Type::Blind) {
         setBlindActive(true);
-    } else if (effectType == Effect::Type::Heavy) {
+    } else if (effect.type == Effect::Type::Heavy) {
         incrementHeavy();
     }
     // Force is not handled as an ongoing effect - it immediately replaces current block
 }
 
 void Board::updateEffects() {
-    for (auto* effect : activeEffects) {
-        effect->update();
-    }
-
-    // Remove expired effects
-    auto it = activeEffects.begin();
-    while (it != activeEffects.end()) {
-        if ((*it)->isExpired()) {
-            // Unapply effect before deletion
-            auto effectType = (*it)->getType();
-
-            if (effectType == Effect::Type::Blind) {
-                setBlindActive(false);
-            } else if (effectType == Effect::Type::Heavy) {
-                decrementHeavy();
-            }
-            // Force is not handled as an ongoing effect
-
-            delete *it;
-            it = activeEffects.erase(it);
-        } else {
-            ++it;
+    Instrument::ScopedTimer timer(Instrument::Phase::EffectUpdate);
+    // Advance effects in place; expired ones are swap-removed after unapplying
+    activeEffects.update([this](const Effect& effect) {
+        if (effect.type == Effect::Type::Blind) {
+            setBlindActive(false);
+        } else if (effect.type == Effect::Type::Heavy) {
+            for (int i = 0; i < effect.stacks; ++i) decrementHeavy();
         }
-    }
+        // Force is not handled as an ongoing effect
+    });
 }
 
 int Board::getNextBlockId() { return nextBlockId++; }
@@ -382,3 +579,126 @@ int Board::getBlocksSinceLastClear() const { return blocksSinceLastClear; }
 void Board::incrementBlocksSinceLastClear() { blocksSinceLastClear++; }
 
 void Board::resetBlocksSinceLastClear() { blocksSinceLastClear = 0; }
+
+std::unique_ptr<Block> Board::loadBlock(ByteReader& in) {
+    char type = static_cast<char>(in.u8());
+    if (type == 0) return nullptr;
+
+    int levelGenerated = in.u8();
+    int id = in.i32();
+    int x = in.i8();
+    int y = in.i8();
+    int rotation = in.u8();
+    if (!isPieceType(type) || levelGenerated > MAX_LEVEL || rotation >= NUM_ROTATION_STATES) {
+        in.fail();
+        return nullptr;
+    }
+
+    // Rotation depends only on the number of quarter turns, so replaying them reproduces the cells
+    std::unique_ptr<Block> block = type == CENTER_BLOCK_CHAR ? std::make_unique<SingleBlock>(levelGenerated, id)
+                                                             : makeBlock(type, levelGenerated, id);
+    for (int i = 0; i < rotation; ++i) block->rotateClockwise();
+    block->setPosition(x, y);
+    return block;
+}
+
+void Board::save(ByteWriter& out) const {
+    // One type byte per cell (0 if empty), then the block ids of the filled cells
+    for (const auto& row : grid) {
+        for (const Cell& cell : row) out.u8(cell.isFilled() ? static_cast<std::uint8_t>(cell.getType()) : 0);
+    }
+    for (const auto& row : grid) {
+        for (const Cell& cell : row) {
+            if (cell.isFilled()) out.i32(cell.getBlockId());
+        }
+    }
+
+    saveBlock(out, currentBlock.get());
+    saveBlock(out, nextBlock.get());
+
+    // Only the level and id of a locked block matter once it is in the grid
+    out.u32(static_cast<std::uint32_t>(activeBlocks.size()));
+    for (const auto& [id, block] : activeBlocks) {
+        out.i32(id);
+        out.u8(static_cast<std::uint8_t>(block->getType()));
+        out.u8(static_cast<std::uint8_t>(block->getLevelGenerated()));
+    }
+
+    out.u8(static_cast<std::uint8_t>(activeEffects.size()));
+    for (int i = 0; i < activeEffects.size(); ++i) {
+        const Effect& effect = activeEffects[i];
+        out.u8(static_cast<std::uint8_t>(effect.type));
+        out.i32(effect.turnsLeft);
+        out.i32(effect.stacks);
+        out.i32(effect.extraDrop);
+        out.u8(static_cast<std::uint8_t>(effect.blockType));
+    }
+
+    out.i32(nextBlockId);
+    out.i32(blocksSinceLastClear);
+    out.u8(blindActive);
+    out.i32(heavyCount);
+}
+
+bool Board::load(ByteReader& in) {
+    for (auto& row : grid) {
+        for (Cell& cell : row) {
+            char type = static_cast<char>(in.u8());
+            if (type != 0 && !isPieceType(type)) in.fail();
+            cell.setFilled(type != 0);
+            cell.setType(type != 0 ? type : EMPTY_CELL);
+        }
+    }
+    for (auto& row : grid) {
+        for (Cell& cell : row) {
+            if (cell.isFilled()) cell.setBlockId(in.i32());
+        }
+    }
+
+    // The current piece may legitimately overlap (a replaced piece keeps its
+    // spot), but both pieces must be on the grid: the current one is locked
+    // into it and the next one is read by isGameOver()
+    currentBlock = loadBlock(in);
+    nextBlock = loadBlock(in);
+    if (currentBlock && !inBounds(currentBlock.get(), geometry)) in.fail();
+    if (!nextBlock || !inBounds(nextBlock.get(), geometry)) in.fail();
+
+    std::uint32_t blockCount = in.u32();
+    for (std::uint32_t i = 0; i < blockCount && in.ok(); ++i) {
+        int id = in.i32();
+        char type = static_cast<char>(in.u8());
+        int levelGenerated = in.u8();
+        if (!isPieceType(type) || levelGenerated > MAX_LEVEL) in.fail();
+        activeBlocks[id] = type == CENTER_BLOCK_CHAR ? std::make_unique<SingleBlock>(levelGenerated, id)
+                                                     : makeBlock(type, levelGenerated, id);
+    }
+
+    int effectCount = in.u8();
+    for (int i = 0; i < effectCount && in.ok(); ++i) {
+        Effect effect{};
+        int type = in.u8();
+        effect.turnsLeft = in.i32();
+        effect.stacks = in.i32();
+        effect.extraDrop = in.i32();
+        effect.blockType = static_cast<char>(in.u8());
+        if (type > static_cast<int>(Effect::Type::Force) || effect.stacks < 1) in.fail();
+        effect.type = static_cast<Effect::Type>(type);
+
+        // One entry per type, so adding them in order rebuilds the table exactly
+        if (!activeEffects.add(effect)) in.fail();
+    }
+
+    nextBlockId = in.i32();
+    blocksSinceLastClear = in.i32();
+    blindActive = in.u8() != 0;
+    heavyCount = in.i32();
+
+    // Blind and heavy are applied by their effects, so the flags must agree with the table
+    int heavyStacks = 0;
+    for (int i = 0; i < activeEffects.size(); ++i) {
+        if (activeEffects[i].type == Effect::Type::Heavy) heavyStacks = activeEffects[i].stacks;
+    }
+    if (blindActive != activeEffects.has(Effect::Type::Blind) || heavyCount != heavyStacks) in.fail();
+    zobrist = computeHash();
+    return in.ok();
+}
@@ -1,4 +1,5 @@
 export module board;
+import <cstdint>;
 import <vector>;
 import <map>;
 import <memory>;
@@ -9,17 +10,23 @@ import observer;
 import scorekeeper;
 import level;
 import effect;
+import serial;
 
 using namespace GameConstants;
 
+// Grid scans compiled for the board's size, chosen once per board
+struct BoardKernels;
+
 export class Board : public ISubject {
+    BoardGeometry geometry;
+    const BoardKernels* kernels;
     std::vector<std::vector<Cell>> grid;
     std::unique_ptr<Block> currentBlock;
     std::unique_ptr<Block> nextBlock;
     Level* level;
     ScoreKeeper* score;
     std::vector<IObserver*> displays;
-    std::vector<Effect*> activeEffects;
+    EffectTable activeEffects;
     std::map<int, std::unique_ptr<Block>> activeBlocks;
     int nextBlockId;
     int blocksSinceLastClear;
@@ -28,14 +35,23 @@ export class Board : public ISubject {
     bool blindActive;
     int heavyCount;
 
+    // Zobrist hash of occupied cells, current/next piece and effect flags
+    std::uint64_t zobrist;
+
+    void notifyPieceMoved();
+    void hashRows(int lastRow);
+    static std::unique_ptr<Block> loadBlock(ByteReader& in);
+
 public:
-    Board();
-    ~Board();
+    explicit Board(const BoardGeometry& geometry = CLASSIC_BOARD);
+
+    // Playfield size, fixed for the board's lifetime
+    const BoardGeometry& getGeometry() const;
 
     // Observer pattern methods
     void attach(IObserver* observer);
     void detach(IObserver* observer);
-    void notifyObservers();
+    void notifyObservers(const BoardChange& change);
 
     // Setters for dependencies
     void setLevel(Level* l);
@@ -50,6 +66,7 @@ public:
     Block* getCurrentBlock();
     const Block* getCurrentBlock() const;
     Block* getNextBlock();
+    const Block* getNextBlock() const;
     void setCurrentBlock(std::unique_ptr<Block> block);
     void setNextBlock(std::unique_ptr<Block> block);
     std::unique_ptr<Block> takeNextBlock();
@@ -78,6 +95,9 @@ public:
     // Clear full rows and return count
     int clearRows();
 
+    // Award points to this board's player
+    void addScore(int points);
+
     // Check if any blocks have been completely removed
     void checkBlockRemoval();
 
@@ -87,6 +107,21 @@ public:
     // Replace current block with specified type
     bool replaceCurrentBlock(char type);
 
+    // Position identity, kept up to date by every Board mutator. Covers
+    // occupied cells, the current piece's type and rotation, the next
+    // piece's type and the blind/heavy flags; not piece position or score.
+    // Writes through getCell() bypass it.
+    std::uint64_t hash() const;
+
+    // Recomputes hash() from scratch (for tests and debugging)
+    std::uint64_t computeHash() const;
+
+    // Save file state: grid, pieces, blocks still on the grid, effects and
+    // counters. load() fills a freshly constructed board without notifying
+    // observers and returns false on invalid input.
+    void save(ByteWriter& out) const;
+    bool load(ByteReader& in);
+
     // Effect state management
     void setBlindActive(bool active);
     void incrementHeavy();
@@ -96,8 +131,12 @@ public:
     bool hasBlindEffect() const;
     bool hasHeavyEffect() const;
 
+    // Rows a move, rotation or down pulls the piece down afterwards: one for
+    // a heavy level plus HEAVY_EXTRA_DROP for the heavy effect
+    int getHeavyDrops() const;
+
     // Effect management
-    void addEffect(Effect* effect);
+    void addEffect(const Effect& effect);
     void updateEffects();
 
     // Block ID management
@@ -0,0 +1,267 @@
+module broadcast;
+import <array>;
+import <bit>;
+import <cstdint>;
+import <memory>;
+import <string>;
+import <string_view>;
+import <variant>;
+import <vector>;
+import observer;
+import board;
+import block;
+import level;
+import scorekeeper;
+import game;
+import aiplayer;
+import constants;
+
+using namespace GameConstants;
+
+namespace {
+    void putU8(std::string& out, std::uint8_t v) { out.push_back(static_cast<char>(v)); }
+
+    void putU16(std::string& out, std::uint16_t v) {
+        putU8(out, static_cast<std::uint8_t>(v));
+        putU8(out, static_cast<std::uint8_t>(v >> 8));
+    }
+
+    void putU32(std::string& out, std::uint32_t v) {
+        putU16(out, static_cast<std::uint16_t>(v));
+        putU16(out, static_cast<std::uint16_t>(v >> 16));
+    }
+
+    void putI32(std::string& out, std::int32_t v) { putU32(out, static_cast<std::uint32_t>(v)); }
+
+    void putPiece(std::string& out, const BoardView& v) {
+        putU8(out, static_cast<std::uint8_t>(v.type));
+        putU8(out, static_cast<std::uint8_t>(static_cast<std::int8_t>(v.x)));
+        putU8(out, static_cast<std::uint8_t>(static_cast<std::int8_t>(v.y)));
+        putU8(out, static_cast<std::uint8_t>(v.rotation));
+    }
+
+    void putSnapshot(std::string& out, const BoardView& v) {
+        for (RowMask row : v.rows) putU16(out, row);
+        putPiece(out, v);
+        putU8(out, static_cast<std::uint8_t>(v.next));
+        putI32(out, v.score);
+        putI32(out, v.highScore);
+        putU8(out, static_cast<std::uint8_t>(v.level));
+        putU8(out, v.flags);
+    }
+
+    RowMask rowMask(const Board& board, int row) {
+        RowMask mask = 0;
+        for (int col = 0; col < BOARD_WIDTH; ++col) {
+            if (board.getCell(row, col).isFilled()) mask |= static_cast<RowMask>(1u << col);
+        }
+        return mask;
+    }
+
+    void readPiece(const Board& board, BoardView& view) {
+        if (const Block* block = board.getCurrentBlock()) {
+            view.type = block->getType();
+            view.x = block->getX();
+            view.y = block->getY();
+            view.rotation = block->getRotationState();
+        } else {
+            view.type = ' ';
+            view.x = view.y = view.rotation = 0;
+        }
+    }
+
+    char nextType(const Board& board) {
+        const Block* next = board.getNextBlock();
+        return next ? next->getType() : ' ';
+    }
+
+    std::uint8_t effectFlags(const Board& board) {
+        return (board.hasHeavyEffect() ? 1 : 0) | (board.hasBlindEffect() ? 2 : 0);
+    }
+}
+
+Frame makeFrame(MessageType type, std::string_view payload) {
+    std::string frame;
+    frame.reserve(5 + payload.size());
+    putU8(frame, static_cast<std::uint8_t>(type));
+    putU32(frame, static_cast<std::uint32_t>(payload.size()));
+    frame.append(payload);
+    return std::make_shared<const std::string>(std::move(frame));
+}
+
+Frame makeHello(std::uint8_t seat, std::uint32_t matchId) {
+    std::string payload;
+    putU8(payload, seat);
+    putU32(payload, matchId);
+    return makeFrame(MessageType::Hello, payload);
+}
+
+BoardView captureView(Game& game, int player) {
+    Board* board = game.getBoard(player);
+    BoardView view;
+    view.rows = BitBoard::fromBoard(*board).rows;
+    readPiece(*board, view);
+    view.next = nextType(*board);
+    view.score = game.getScore(player)->getCurrentScore();
+    view.highScore = game.getScore(player)->getHighScore();
+    view.level = game.getLevel(player)->getLevelNumber();
+    view.flags = effectFlags(*board);
+    return view;
+}
+
+// BoardFeed implementation
+void BoardFeed::follow(Board* b) {
+    board = b;
+    board->attach(this);
+    dirtyRows = 0;
+    pieceDirty = nextDirty = false;
+}
+
+void BoardFeed::unfollow() {
+    if (board) board->detach(this);
+    board = nullptr;
+}
+
+Board* BoardFeed::getBoard() const { return board; }
+
+void BoardFeed::notify(const BoardChange& change) {
+    if (auto* cells = std::get_if<CellsChanged>(&change)) {
+        for (int i = 0; i < cells->count; ++i) dirtyRows |= 1u << cells->cells[i].first;
+    } else if (auto* rows = std::get_if<RowsCleared>(&change)) {
+        // Everything above the lowest cleared row moved down
+        dirtyRows |= (2u << (std::bit_width(rows->rowMask) - 1)) - 1;
+    } else if (std::holds_alternative<PieceMoved>(change)) {
+        pieceDirty = true;
+    } else if (std::holds_alternative<NextPieceChanged>(change)) {
+        nextDirty = true;
+    }
+}
+
+std::uint8_t BoardFeed::take(BoardView& view, std::uint32_t& changedRows) {
+    std::uint8_t changed = 0;
+    changedRows = 0;
+
+    for (std::uint32_t rows = dirtyRows; rows; rows &= rows - 1) {
+        int row = std::countr_zero(rows);
+        RowMask mask = rowMask(*board, row);
+        if (mask != view.rows[row]) {
+            view.rows[row] = mask;
+            changedRows |= 1u << row;
+        }
+    }
+    if (changedRows) changed |= DELTA_ROWS;
+
+    if (pieceDirty) {
+        BoardView before = view;
+        readPiece(*board, view);
+        if (before.type != view.type || before.x != view.x || before.y != view.y ||
+            before.rotation != view.rotation) changed |= DELTA_PIECE;
+    }
+    if (nextDirty) {
+        char next = nextType(*board);
+        if (next != view.next) changed |= DELTA_NEXT;
+        view.next = next;
+    }
+
+    dirtyRows = 0;
+    pieceDirty = nextDirty = false;
+    return changed;
+}
+
+// MatchBroadcast implementation
+MatchBroadcast::MatchBroadcast(Game& g) : game(g) {
+    for (int player = 0; player < 2; ++player) feeds[player].follow(game.getBoard(player));
+    captureKeyframe();
+}
+
+MatchBroadcast::~MatchBroadcast() {
+    // Boards replaced by a restart since the last publish() are already gone
+    for (int player = 0; player < 2; ++player) {
+        if (feeds[player].getBoard() == game.getBoard(player)) feeds[player].unfollow();
+    }
+}
+
+void MatchBroadcast::captureKeyframe() {
+    sentCurrent = game.getCurrentPlayer();
+    sentActing = game.hasPendingEvent() ? game.peekEvent().player : sentCurrent;
+
+    std::string payload;
+    putU8(payload, static_cast<std::uint8_t>(sentCurrent));
+    putU8(payload, static_cast<std::uint8_t>(sentActing));
+    for (int player = 0; player < 2; ++player) {
+        sent[player] = captureView(game, player);
+        putSnapshot(payload, sent[player]);
+    }
+    keyframe = makeFrame(MessageType::Snapshot, payload);
+    sinceKeyframe.clear();
+}
+
+Frame MatchBroadcast::publish() {
+    // Restart builds new boards; the old ones (and our attachment) are gone
+    if (game.getBoard(PLAYER_ONE) != feeds[PLAYER_ONE].getBoard()) {
+        for (int player = 0; player < 2; ++player) feeds[player].follow(game.getBoard(player));
+        captureKeyframe();
+        return keyframe;
+    }
+
+    int current = game.getCurrentPlayer();
+    int acting = game.hasPendingEvent() ? game.peekEvent().player : current;
+
+    std::string payload;
+    putU8(payload, static_cast<std::uint8_t>(current));
+    putU8(payload, static_cast<std::uint8_t>(acting));
+    bool any = current != sentCurrent || acting != sentActing;
+
+    for (int player = 0; player < 2; ++player) {
+        BoardView& view = sent[player];
+        std::uint32_t changedRows;
+        std::uint8_t changed = feeds[player].take(view, changedRows);
+
+        // Score, level and effects are a handful of reads; no need to observe them
+        const Board& board = *game.getBoard(player);
+        const ScoreKeeper& score = *game.getScore(player);
+        int level = game.getLevel(player)->getLevelNumber();
+        std::uint8_t flags = effectFlags(board);
+        if (score.getCurrentScore() != view.score || score.getHighScore() != view.highScore) {
+            changed |= DELTA_SCORE;
+            view.score = score.getCurrentScore();
+            view.highScore = score.getHighScore();
+        }
+        if (level != view.level || flags != view.flags) {
+            changed |= DELTA_STATUS;
+            view.level = level;
+            view.flags = flags;
+        }
+
+        putU8(payload, changed);
+        if (changed & DELTA_ROWS) {
+            putU32(payload, changedRows);
+            for (std::uint32_t rows = changedRows; rows; rows &= rows - 1) {
+                putU16(payload, view.rows[std::countr_zero(rows)]);
+            }
+        }
+        if (changed & DELTA_PIECE) putPiece(payload, view);
+        if (changed & DELTA_NEXT) putU8(payload, static_cast<std::uint8_t>(view.next));
+        if (changed & DELTA_SCORE) {
+            putI32(payload, view.score);
+            putI32(payload, view.highScore);
+        }
+        if (changed & DELTA_STATUS) {
+            putU8(payload, static_cast<std::uint8_t>(view.level));
+            putU8(payload, view.flags);
+        }
+        any = any || changed;
+    }
+    if (!any) return nullptr;
+
+    sentCurrent = current;
+    sentActing = acting;
+    Frame frame = makeFrame(MessageType::Delta, payload);
+    sinceKeyframe.push_back(frame);
+    if (sinceKeyframe.size() >= KEYFRAME_INTERVAL) captureKeyframe();
+    return frame;
+}
+
+const Frame& MatchBroadcast::getKeyframe() const { return keyframe; }
+
+const std::vector<Frame>& MatchBroadcast::getDeltasSinceKeyframe() const { return sinceKeyframe; }
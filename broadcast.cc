@@ -0,0 +1,119 @@
+export module broadcast;
+import <array>;
+import <cstdint>;
+import <memory>;
+import <string>;
+import <string_view>;
+import <vector>;
+import observer;
+import board;
+import game;
+import aiplayer;
+import constants;
+
+using namespace GameConstants;
+
+// Wire protocol. Clients send newline-terminated command lines, exactly as
+// typed at the prompt. The server sends framed binary messages:
+//
+//   u8 type, u32 payload length, payload          (little-endian)
+//
+//   Hello     u8 seat (SPECTATOR_SEAT when watching), u32 match id
+//   Snapshot  u8 current player, u8 acting player, then per player:
+//             u16 row[TOTAL_ROWS] (bit c = column c filled), piece,
+//             char next, i32 score, i32 high score, u8 level, u8 flags
+//   Delta     u8 current player, u8 acting player, then per player:
+//             u8 changed (DELTA_* bits) followed by the changed fields in
+//             bit order; rows are a u32 row mask then one u16 per set bit
+//   Text      UTF-8 message for the player
+//
+// piece is char type, i8 x, i8 y, u8 rotation (type ' ' if none); flags
+// are 1 = heavy, 2 = blind. A Snapshot follows Hello and every restart;
+// everything else is a Delta against the previous message.
+export enum class MessageType : std::uint8_t { Hello = 1, Snapshot = 2, Delta = 3, Text = 4 };
+
+export constexpr std::uint8_t DELTA_ROWS = 1;
+export constexpr std::uint8_t DELTA_PIECE = 2;
+export constexpr std::uint8_t DELTA_NEXT = 4;
+export constexpr std::uint8_t DELTA_SCORE = 8;
+export constexpr std::uint8_t DELTA_STATUS = 16;   // Level and flags
+
+export constexpr std::uint8_t SPECTATOR_SEAT = 255;
+
+// One encoded message, header included. Frames are never modified once
+// built, so every connection that sends one shares the same buffer.
+export using Frame = std::shared_ptr<const std::string>;
+
+export Frame makeFrame(MessageType type, std::string_view payload);
+export Frame makeHello(std::uint8_t seat, std::uint32_t matchId);
+
+// What a client last saw of one board
+export struct BoardView {
+    std::array<RowMask, TOTAL_ROWS> rows{};
+    char type = ' ';
+    int x = 0;
+    int y = 0;
+    int rotation = 0;
+    char next = ' ';
+    int score = 0;
+    int highScore = 0;
+    int level = 0;
+    std::uint8_t flags = 0;
+};
+
+export BoardView captureView(Game& game, int player);
+
+// Collects which parts of one board changed since they were last taken
+export class BoardFeed : public IObserver {
+    Board* board = nullptr;
+    std::uint32_t dirtyRows = 0;    // Bit r: row r may differ
+    bool pieceDirty = false;
+    bool nextDirty = false;
+
+public:
+    // Start following a board; the previous one must already be gone or unfollowed
+    void follow(Board* b);
+    void unfollow();
+    Board* getBoard() const;
+
+    void notify(const BoardChange& change) override;
+
+    // Apply the flagged rows, piece and next piece to `view` and clear the
+    // flags. Returns the DELTA_* bits that really changed; changedRows gets
+    // the rows that did.
+    std::uint8_t take(BoardView& view, std::uint32_t& changedRows);
+};
+
+// Encodes one match's state once per turn for every viewer: the two seats
+// and any number of spectators all queue the same frames. A keyframe
+// (Snapshot) is kept for late joiners and refreshed every KEYFRAME_INTERVAL
+// deltas, so joining costs at most that many frames.
+export class MatchBroadcast {
+    Game& game;
+    std::array<BoardFeed, 2> feeds;
+    std::array<BoardView, 2> sent;
+    int sentCurrent = -1;
+    int sentActing = -1;
+
+    Frame keyframe;
+    std::vector<Frame> sinceKeyframe;
+
+    void captureKeyframe();
+
+public:
+    static constexpr std::size_t KEYFRAME_INTERVAL = 64;
+
+    explicit MatchBroadcast(Game& g);
+    ~MatchBroadcast();
+
+    MatchBroadcast(const MatchBroadcast&) = delete;
+    MatchBroadcast& operator=(const MatchBroadcast&) = delete;
+
+    // Frame for whatever changed since the last call (a Snapshot after a
+    // restart), or null if nothing did
+    Frame publish();
+
+    // Frames that bring a new viewer up to date, in order
+    const Frame& getKeyframe() const;
+    const std::vector<Frame>& getDeltasSinceKeyframe() const;
+};
@@ -0,0 +1,138 @@
+module canvas;
+import <string>;
+import <string_view>;
+import <vector>;
+import constants;
+
+using namespace std;
+
+Canvas::Canvas(int width, int height) : canvas_width(width), canvas_height(height) {}
+
+int Canvas::getWidth() const { return canvas_width; }
+
+int Canvas::getHeight() const { return canvas_height; }
+
+void Canvas::setWindowTitle(string) {}
+
+void Canvas::processEvents(vector<int>&) {}
+
+int Canvas::connectionFd() const { return -1; }
+
+// Outline covering x to x + width and y to y + height inclusive, like XDrawRectangle
+void Canvas::drawRectangle(int x, int y, int width, int height, int colour) {
+  drawLine(x, y, x + width, y, colour);
+  drawLine(x + width, y, x + width, y + height, colour);
+  drawLine(x + width, y + height, x, y + height, colour);
+  drawLine(x, y + height, x, y, colour);
+}
+
+void Canvas::drawStringBlack(int x, int y, string_view msg) {
+  drawString(x, y, msg, Black);
+}
+
+void Canvas::drawStringBlackBold(int x, int y, string_view msg) {
+  drawString(x, y, msg, White);
+  drawString(x + 1, y, msg, White);
+  drawString(x, y + 1, msg, White);
+  drawString(x + 1, y + 1, msg, White);
+}
+
+void Canvas::drawLogo(int x, int y, int width, int height) {
+  using namespace GameConstants;
+
+  int blockWidth = width / LOGO_NUM_LETTERS;
+
+  for (int i = 0; i < LOGO_NUM_LETTERS; i++) {
+    int blockX = x + i * blockWidth;
+
+    fillRectangle(blockX, y, blockWidth - LOGO_BLOCK_BORDER, height, LOGO_COLORS[i]);
+    drawRectangle(blockX, y, blockWidth - LOGO_BLOCK_BORDER, height, White);
+
+    int textX = blockX + blockWidth / 2 - LOGO_TEXT_X_OFFSET;
+    int textY = y + height / 2 + LOGO_TEXT_Y_OFFSET;
+    drawString(textX, textY, string_view(LOGO_TEXT + i, 1), White);
+  }
+}
+
+void Canvas::drawArrowKeys(int x, int y, int keySize) {
+  int gap = 5;
+
+  int centerX = x + keySize + gap;
+  fillArc(centerX, y, keySize, keySize, 0, 360, Black);
+  drawArc(centerX, y, keySize, keySize, 0, 360, White);
+
+  CanvasPoint upTriangle[3] = {
+    {centerX + keySize/2, y + 10},
+    {centerX + keySize/2 - 8, y + 22},
+    {centerX + keySize/2 + 8, y + 22},
+  };
+  fillPolygon(upTriangle, 3, White);
+
+  int centerY = y + keySize + gap;
+  fillArc(centerX, centerY + keySize + gap, keySize, keySize, 0, 360, Black);
+  drawArc(centerX, centerY + keySize + gap, keySize, keySize, 0, 360, White);
+
+  int downY = centerY + keySize + gap;
+  CanvasPoint downTriangle[3] = {
+    {centerX + keySize/2, downY + 25},
+    {centerX + keySize/2 - 8, downY + 13},
+    {centerX + keySize/2 + 8, downY + 13},
+  };
+  fillPolygon(downTriangle, 3, White);
+
+  fillArc(x, centerY, keySize, keySize, 0, 360, Black);
+  drawArc(x, centerY, keySize, keySize, 0, 360, White);
+
+  CanvasPoint leftTriangle[3] = {
+    {x + 10, centerY + keySize/2},
+    {x + 22, centerY + keySize/2 - 8},
+    {x + 22, centerY + keySize/2 + 8},
+  };
+  fillPolygon(leftTriangle, 3, White);
+
+  int rightX = centerX + keySize + gap;
+  fillArc(rightX, centerY, keySize, keySize, 0, 360, Black);
+  drawArc(rightX, centerY, keySize, keySize, 0, 360, White);
+
+  CanvasPoint rightTriangle[3] = {
+    {rightX + 25, centerY + keySize/2},
+    {rightX + 13, centerY + keySize/2 - 8},
+    {rightX + 13, centerY + keySize/2 + 8},
+  };
+  fillPolygon(rightTriangle, 3, White);
+}
+
+void Canvas::drawRoundedRectangle(int x, int y, int width, int height, int radius, int color) {
+  int diameter = radius * 2;
+  int lineWidth = 2;
+
+  drawLine(x + radius + 1, y, x + width - radius - 1, y, color, lineWidth);
+  drawLine(x + width, y + radius + 1, x + width, y + height - radius - 1, color, lineWidth);
+  drawLine(x + width - radius - 1, y + height, x + radius + 1, y + height, color, lineWidth);
+  drawLine(x, y + height - radius - 1, x, y + radius + 1, color, lineWidth);
+
+  drawArc(x, y, diameter, diameter, 90, 90, color, lineWidth);
+  drawArc(x + width - diameter, y, diameter, diameter, 0, 90, color, lineWidth);
+  drawArc(x + width - diameter, y + height - diameter, diameter, diameter, 270, 90, color, lineWidth);
+  drawArc(x, y + height - diameter, diameter, diameter, 180, 90, color, lineWidth);
+}
+
+void Canvas::drawTetrisBackground(int width, int height) {
+  int blockSize = 25;
+  int colors[] = {MidnightBlue, NavyBlue, RoyalBlue, MediumBlue};
+
+  for (int y = 0; y < height; y += blockSize) {
+    for (int x = 0; x < width; x += blockSize) {
+      int colorIndex = ((x / blockSize) + (y / blockSize) * 3) % 4;
+      fillRectangle(x, y, blockSize, blockSize, colors[colorIndex]);
+    }
+  }
+
+  int patternOffset = blockSize / 2;
+  for (int y = patternOffset; y < height; y += blockSize * 2) {
+    for (int x = patternOffset; x < width; x += blockSize * 2) {
+      int colorIndex = ((x / (blockSize * 2)) + (y / (blockSize * 2)) * 3) % 4;
+      fillRectangle(x, y, blockSize, blockSize, colors[colorIndex]);
+    }
+  }
+}
@@ -0,0 +1,60 @@
+export module canvas;
+import <string>;
+import <string_view>;
+import <vector>;
+
+// A corner of a filled polygon
+export struct CanvasPoint {
+  int x;
+  int y;
+};
+
+// Drawing backend for the graphics display. Backends implement the
+// primitives and the composite shapes are built from them, so an X window
+// and an offscreen image draw the same picture. Drawing goes to a back
+// buffer, which present() shows.
+export class Canvas {
+ protected:
+  int canvas_width, canvas_height;
+
+ public:
+  Canvas(int width, int height);
+  virtual ~Canvas() = default;
+  Canvas(const Canvas&) = delete;
+  Canvas &operator=(const Canvas&) = delete;
+
+  enum {White=0, Black, Red, Green, Blue, Cyan, Yellow, Magenta, Orange, Brown, DarkGreen, DarkCyan, MidnightBlue, NavyBlue, RoyalBlue, MediumBlue};
+
+  static constexpr int NUM_COLOURS = 16;
+  static constexpr const char* LOGO_TEXT = "BIQUADRIS";
+  static constexpr int LOGO_NUM_LETTERS = 9;
+  static constexpr int LOGO_COLORS[9] = {Red, Orange, Brown, DarkGreen, DarkCyan, Blue, Magenta, Magenta, Red};
+
+  int getWidth() const;
+  int getHeight() const;
+
+  // Primitives. Text is drawn with y on its baseline. Arcs follow the
+  // ellipse inscribed in the box, with angles in degrees counterclockwise
+  // from three o'clock (as in X).
+  virtual void fillRectangle(int x, int y, int width, int height, int colour=Black) = 0;
+  virtual void drawString(int x, int y, std::string_view msg, int colour=White) = 0;
+  virtual void drawLine(int x1, int y1, int x2, int y2, int colour, int lineWidth=1) = 0;
+  virtual void drawArc(int x, int y, int width, int height, int startAngle, int arcAngle, int colour, int lineWidth=1) = 0;
+  virtual void fillArc(int x, int y, int width, int height, int startAngle, int arcAngle, int colour) = 0;
+  virtual void fillPolygon(const CanvasPoint* points, int count, int colour) = 0;
+  virtual void present() = 0;
+  virtual void setWindowTitle(std::string title);
+
+  // Input, for backends shown in a window (none by default)
+  virtual void processEvents(std::vector<int>& keys);
+  virtual int connectionFd() const;
+
+  // Composite shapes
+  void drawRectangle(int x, int y, int width, int height, int colour);
+  void drawStringBlack(int x, int y, std::string_view msg);
+  void drawStringBlackBold(int x, int y, std::string_view msg);
+  void drawLogo(int x, int y, int width, int height);
+  void drawArrowKeys(int x, int y, int keySize);
+  void drawTetrisBackground(int width, int height);
+  void drawRoundedRectangle(int x, int y, int width, int height, int radius, int color);
+};
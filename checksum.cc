@@ -0,0 +1,7 @@
+module;
+#include <cstddef>
+export module checksum;
+import <cstdint>;
+
+// CRC-32 with the polynomial zlib and PNG use
+export std::uint32_t crc32(const void* data, std::size_t size);
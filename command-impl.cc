@@ -1,204 +1,256 @@
 module command;
 import <iostream>;
 import <string>;
+import <string_view>;
 import <map>;
 import <vector>;
 import <memory>;
 import <algorithm>;
 import <cctype>;
-import <fstream>;
+import <charconv>;
+import <functional>;
 import game;
 import board;
 import level;
+import tokenreader;
 import constants;
+import instrument;
 
 using namespace GameConstants;
 
 // Command base class implementation
+int Command::argCount() const { return 0; }
+
 bool Command::canMultiply() const { return true; }
 
+bool Command::answersSpecialAction() const { return false; }
+
 // LeftCommand implementation
-void LeftCommand::execute(Game* game) {
+void LeftCommand::execute(Game* game, const CommandArgs&) {
     Board* board = game->getCurrentBoard();
     board->moveLeft();
 
     // Apply heavy effect if active (from level or special action)
-    // Level heavy = 1 drop, Heavy effect = 2 drops, they add together
-    Level* level = game->getCurrentLevel();
-    int heavyDrops = 0;
-    if (level->isHeavy()) heavyDrops += 1;
-    if (board->hasHeavyEffect()) heavyDrops += HEAVY_EXTRA_DROP;
-
+    int heavyDrops = board->getHeavyDrops();
     for (int i = 0; i < heavyDrops; ++i) {
         board->moveDown();
     }
 }
 
 // RightCommand implementation
-void RightCommand::execute(Game* game) {
+void RightCommand::execute(Game* game, const CommandArgs&) {
     Board* board = game->getCurrentBoard();
     board->moveRight();
 
     // Apply heavy effect if active (from level or special action)
-    // Level heavy = 1 drop, Heavy effect = 2 drops, they add together
-    Level* level = game->getCurrentLevel();
-    int heavyDrops = 0;
-    if (level->isHeavy()) heavyDrops += 1;
-    if (board->hasHeavyEffect()) heavyDrops += HEAVY_EXTRA_DROP;
-
+    int heavyDrops = board->getHeavyDrops();
     for (int i = 0; i < heavyDrops; ++i) {
         board->moveDown();
     }
 }
 
 // DownCommand implementation
-void DownCommand::execute(Game* game) {
+void DownCommand::execute(Game* game, const CommandArgs&) {
     Board* board = game->getCurrentBoard();
     board->moveDown();
 
     // Apply heavy effect if active (from level or special action)
-    // Level heavy = 1 drop, Heavy effect = 2 drops, they add together
-    Level* level = game->getCurrentLevel();
-    int heavyDrops = 0;
-    if (level->isHeavy()) heavyDrops += 1;
-    if (board->hasHeavyEffect()) heavyDrops += HEAVY_EXTRA_DROP;
-
+    int heavyDrops = board->getHeavyDrops();
     for (int i = 0; i < heavyDrops; ++i) {
         board->moveDown();
     }
 }
 
 // DropCommand implementation
-void DropCommand::execute(Game* game) {
+void DropCommand::execute(Game* game, const CommandArgs&) {
     game->drop();
 }
 
 // RotateClockwiseCommand implementation
-void RotateClockwiseCommand::execute(Game* game) {
+void RotateClockwiseCommand::execute(Game* game, const CommandArgs&) {
     Board* board = game->getCurrentBoard();
     board->rotate(true);
 
     // Apply heavy effect if active (from level or special action)
-    // Level heavy = 1 drop, Heavy effect = 2 drops, they add together
-    Level* level = game->getCurrentLevel();
-    int heavyDrops = 0;
-    if (level->isHeavy()) heavyDrops += 1;
-    if (board->hasHeavyEffect()) heavyDrops += HEAVY_EXTRA_DROP;
-
+    int heavyDrops = board->getHeavyDrops();
     for (int i = 0; i < heavyDrops; ++i) {
         board->moveDown();
     }
 }
 
 // RotateCounterClockwiseCommand implementation
-void RotateCounterClockwiseCommand::execute(Game* game) {
+void RotateCounterClockwiseCommand::execute(Game* game, const CommandArgs&) {
     Board* board = game->getCurrentBoard();
     board->rotate(false);
 
     // Apply heavy effect if active (from level or special action)
-    // Level heavy = 1 drop, Heavy effect = 2 drops, they add together
-    Level* level = game->getCurrentLevel();
-    int heavyDrops = 0;
-    if (level->isHeavy()) heavyDrops += 1;
-    if (board->hasHeavyEffect()) heavyDrops += HEAVY_EXTRA_DROP;
-
+    int heavyDrops = board->getHeavyDrops();
     for (int i = 0; i < heavyDrops; ++i) {
         board->moveDown();
     }
 }
 
 // LevelUpCommand implementation
-void LevelUpCommand::execute(Game* game) {
+void LevelUpCommand::execute(Game* game, const CommandArgs&) {
     game->levelUp();
 }
 
 // LevelDownCommand implementation
-void LevelDownCommand::execute(Game* game) {
+void LevelDownCommand::execute(Game* game, const CommandArgs&) {
     game->levelDown();
 }
 
 // RandomCommand implementation
-void RandomCommand::execute(Game* game) {
+void RandomCommand::execute(Game* game, const CommandArgs&) {
     game->getCurrentLevel()->setRandom(true);
 }
 
 bool RandomCommand::canMultiply() const { return false; }
 
 // NoRandomCommand implementation
-void NoRandomCommand::execute(Game* game) {
-    std::string filename;
-    std::cin >> filename;
+void NoRandomCommand::execute(Game* game, const CommandArgs& args) {
     game->getCurrentLevel()->setRandom(false);
-    game->getCurrentLevel()->setNonRandom(filename);
+    game->getCurrentLevel()->setNonRandom(args[0]);
 }
 
+int NoRandomCommand::argCount() const { return 1; }
+
 bool NoRandomCommand::canMultiply() const { return false; }
 
 // RestartCommand implementation
-void RestartCommand::execute(Game* game) {
+void RestartCommand::execute(Game* game, const CommandArgs&) {
     game->restart();
 }
 
 bool RestartCommand::canMultiply() const { return false; }
 
+// SaveCommand implementation
+void SaveCommand::execute(Game* game, const CommandArgs& args) {
+    if (game->saveFile(args[0])) std::cout << "Game saved to " << args[0] << "\n";
+}
+
+int SaveCommand::argCount() const { return 1; }
+
+bool SaveCommand::canMultiply() const { return false; }
+
+// LoadCommand implementation
+void LoadCommand::execute(Game* game, const CommandArgs& args) {
+    if (game->loadFile(args[0])) std::cout << "Game loaded from " << args[0] << "\n";
+}
+
+int LoadCommand::argCount() const { return 1; }
+
+bool LoadCommand::canMultiply() const { return false; }
+
 // SequenceCommand implementation
-void SequenceCommand::execute(Game* game) {
+void SequenceCommand::execute(Game*, const CommandArgs&) {
     // Actual execution handled in CommandInterpreter
 }
 
+int SequenceCommand::argCount() const { return 1; }
+
 bool SequenceCommand::canMultiply() const { return false; }
 
 // IBlockCommand implementation
-void IBlockCommand::execute(Game* game) {
+void IBlockCommand::execute(Game* game, const CommandArgs&) {
     game->getCurrentBoard()->replaceCurrentBlock('I');
 }
 
 bool IBlockCommand::canMultiply() const { return false; }
 
 // JBlockCommand implementation
-void JBlockCommand::execute(Game* game) {
+void JBlockCommand::execute(Game* game, const CommandArgs&) {
     game->getCurrentBoard()->replaceCurrentBlock('J');
 }
 
 bool JBlockCommand::canMultiply() const { return false; }
 
 // LBlockCommand implementation
-void LBlockCommand::execute(Game* game) {
+void LBlockCommand::execute(Game* game, const CommandArgs&) {
     game->getCurrentBoard()->replaceCurrentBlock('L');
 }
 
 bool LBlockCommand::canMultiply() const { return false; }
 
 // OBlockCommand implementation
-void OBlockCommand::execute(Game* game) {
+void OBlockCommand::execute(Game* game, const CommandArgs&) {
     game->getCurrentBoard()->replaceCurrentBlock('O');
 }
 
 bool OBlockCommand::canMultiply() const { return false; }
 
 // SBlockCommand implementation
-void SBlockCommand::execute(Game* game) {
+void SBlockCommand::execute(Game* game, const CommandArgs&) {
     game->getCurrentBoard()->replaceCurrentBlock('S');
 }
 
 bool SBlockCommand::canMultiply() const { return false; }
 
 // ZBlockCommand implementation
-void ZBlockCommand::execute(Game* game) {
+void ZBlockCommand::execute(Game* game, const CommandArgs&) {
     game->getCurrentBoard()->replaceCurrentBlock('Z');
 }
 
 bool ZBlockCommand::canMultiply() const { return false; }
 
 // TBlockCommand implementation
-void TBlockCommand::execute(Game* game) {
+void TBlockCommand::execute(Game* game, const CommandArgs&) {
     game->getCurrentBoard()->replaceCurrentBlock('T');
 }
 
 bool TBlockCommand::canMultiply() const { return false; }
 
+// BlindCommand implementation
+void BlindCommand::execute(Game* game, const CommandArgs&) {
+    game->answerSpecialAction("blind");
+}
+
+bool BlindCommand::canMultiply() const { return false; }
+
+bool BlindCommand::answersSpecialAction() const { return true; }
+
+// HeavyCommand implementation
+void HeavyCommand::execute(Game* game, const CommandArgs&) {
+    game->answerSpecialAction("heavy");
+}
+
+bool HeavyCommand::canMultiply() const { return false; }
+
+bool HeavyCommand::answersSpecialAction() const { return true; }
+
+// ForceCommand implementation
+void ForceCommand::execute(Game* game, const CommandArgs& args) {
+    game->answerSpecialAction("force", args[0].empty() ? '\0' : args[0][0]);
+}
+
+int ForceCommand::argCount() const { return 1; }
+
+bool ForceCommand::canMultiply() const { return false; }
+
+bool ForceCommand::answersSpecialAction() const { return true; }
+
+// TargetCommand implementation
+void TargetCommand::execute(Game* game, const CommandArgs& args) {
+    // Players are numbered from 1 on screen; anything but a number becomes 0, which the game rejects
+    int player = 0;
+    for (char c : args[0]) {
+        if (c < '0' || c > '9' || player > MAX_PLAYERS) {
+            player = 0;
+            break;
+        }
+        player = player * 10 + (c - '0');
+    }
+    if (game->targetSpecialAction(player - 1)) std::cout << "Special action aimed at Player " << player << "\n";
+}
+
+int TargetCommand::argCount() const { return 1; }
+
+bool TargetCommand::canMultiply() const { return false; }
+
+bool TargetCommand::answersSpecialAction() const { return true; }
+
 // HelpCommand implementation
-void HelpCommand::execute(Game*) {
+void HelpCommand::execute(Game*, const CommandArgs&) {
     std::cout << "╔════════════════════════════════════════╗\n";
     std::cout << "║      BIQUADRIS COMMANDS HELP           ║\n";
     std::cout << "╠════════════════════════════════════════╣\n";
@@ -222,11 +274,21 @@ void HelpCommand::execute(Game*) {
     std::cout << "║                                        ║\n";
     std::cout << "║ TESTING:                               ║\n";
     std::cout << "║  I,J,L,O,S,Z,T - Replace block         ║\n";
-    std::cout << "║  sequence file - Run commands from file║\n";
+    std::cout << "║  sequence/s f - Run commands from file ║\n";
+    std::cout << "║                                        ║\n";
+    std::cout << "║ SPECIAL ACTIONS (after 2+ rows):       ║\n";
+    std::cout << "║  blind, heavy  - Penalize opponent     ║\n";
+    std::cout << "║  force X       - Force opponent block  ║\n";
+    std::cout << "║  target N      - Aim it at player N    ║\n";
     std::cout << "║                                        ║\n";
     std::cout << "║ GAME:                                  ║\n";
     std::cout << "║  restart       - Restart game          ║\n";
+    std::cout << "║  save file     - Save match to file    ║\n";
+    std::cout << "║  load file     - Resume saved match    ║\n";
     std::cout << "║  help/h        - Show this help        ║\n";
+    if constexpr (Instrument::ENABLED) {
+        std::cout << "║  stats         - Show timing stats     ║\n";
+    }
     std::cout << "║                                        ║\n";
     std::cout << "║ TIP: Use numbers before commands!      ║\n";
     std::cout << "║      Example: 3left, 2down             ║\n";
@@ -235,6 +297,13 @@ void HelpCommand::execute(Game*) {
 
 bool HelpCommand::canMultiply() const { return false; }
 
+// StatsCommand implementation
+void StatsCommand::execute(Game*, const CommandArgs&) {
+    Instrument::printStats(std::cout);
+}
+
+bool StatsCommand::canMultiply() const { return false; }
+
 // CommandInterpreter implementation
 CommandInterpreter::CommandInterpreter(Game* g) : game(g) {
     registerCommands();
@@ -254,8 +323,16 @@ void CommandInterpreter::registerCommands() {
     commands["random"] = std::make_unique<RandomCommand>();
     commands["norandom"] = std::make_unique<NoRandomCommand>();
     commands["restart"] = std::make_unique<RestartCommand>();
+    commands["save"] = std::make_unique<SaveCommand>();
+    commands["load"] = std::make_unique<LoadCommand>();
     commands["sequence"] = std::make_unique<SequenceCommand>();
+    commands["s"] = std::make_unique<SequenceCommand>();   // "s" meant sequence before save existed
     commands["help"] = std::make_unique<HelpCommand>();
+    commands["h"] = std::make_unique<HelpCommand>();
+    commands["blind"] = std::make_unique<BlindCommand>();
+    commands["heavy"] = std::make_unique<HeavyCommand>();
+    commands["force"] = std::make_unique<ForceCommand>();
+    commands["target"] = std::make_unique<TargetCommand>();
     commands["I"] = std::make_unique<IBlockCommand>();
     commands["J"] = std::make_unique<JBlockCommand>();
     commands["L"] = std::make_unique<LBlockCommand>();
@@ -263,83 +340,127 @@ void CommandInterpreter::registerCommands() {
     commands["S"] = std::make_unique<SBlockCommand>();
     commands["Z"] = std::make_unique<ZBlockCommand>();
     commands["T"] = std::make_unique<TBlockCommand>();
+
+    // Only registered when instrumented, so normal builds keep the shorter prefixes
+    if constexpr (Instrument::ENABLED) {
+        commands["stats"] = std::make_unique<StatsCommand>();
+    }
 }
 
-std::string CommandInterpreter::matchCommand(const std::string& prefix) {
-    std::vector<std::string> matches;
+std::string_view CommandInterpreter::matchCommand(std::string_view prefix) const {
+    Instrument::ScopedTimer timer(Instrument::Phase::MatchCommand);
 
-    for (const auto& [name, cmd] : commands) {
-        if (name.substr(0, prefix.size()) == prefix) {
-            matches.push_back(name);
-        }
+    // Commands sharing a prefix are contiguous in the sorted map
+    auto first = commands.lower_bound(prefix);
+    auto it = first;
+    int matches = 0;
+    while (it != commands.end() && std::string_view(it->first).starts_with(prefix)) {
+        ++matches;
+        ++it;
     }
 
     // Return the match if it's unique
-    if (matches.size() == 1) {
-        return matches[0];
+    if (matches == 1) {
+        return first->first;
     }
 
     // If exact match exists, use it
-    if (commands.count(prefix)) {
-        return prefix;
+    if (first != commands.end() && first->first == prefix) {
+        return first->first;
     }
 
-    return "";  // No unique match
+    return {};  // No unique match
 }
 
-void CommandInterpreter::executeCommand(const std::string& input) {
+void CommandInterpreter::executeCommand(std::string_view token, TokenReader& input) {
+    Instrument::ScopedTimer timer(Instrument::Phase::Command);
+
     // Parse multiplier and command
     int multiplier = 1;
-    std::string commandStr = input;
+    std::string_view commandStr = token;
 
     // Check for multiplier prefix
     size_t i = 0;
-    while (i < input.size() && std::isdigit(input[i])) {
+    while (i < token.size() && std::isdigit(static_cast<unsigned char>(token[i]))) {
         i++;
     }
 
+    // A count too large for an int is rejected like an unknown command
     if (i > 0) {
-        multiplier = std::stoi(input.substr(0, i));
-        commandStr = input.substr(i);
+        auto [end, error] = std::from_chars(token.data(), token.data() + i, multiplier);
+        if (error != std::errc()) {
+            std::cout << "Invalid command, use 'help' or 'h' for a list of commands" << "\n";
+            return;
+        }
+        commandStr = token.substr(i);
     }
 
     // Match command
-    std::string fullCommand = matchCommand(commandStr);
+    std::string_view fullCommand = matchCommand(commandStr);
 
-    if (fullCommand.empty() || !commands.count(fullCommand)) {
+    if (fullCommand.empty()) {
         std::cout << "Invalid command, use 'help' or 'h' for a list of commands" << "\n";
         return;
     }
 
-    Command* cmd = commands[fullCommand].get();
+    Command* cmd = commands.find(fullCommand)->second.get();
+    Instrument::count(Instrument::Counter::Commands);
+    timer.setDetail(fullCommand);
+
+    // Read argument tokens before the command token is invalidated
+    CommandArgs args;
+    for (int a = 0; a < cmd->argCount(); ++a) {
+        std::string_view arg;
+        if (!input.next(arg)) {
+            std::cout << "Missing argument for " << fullCommand << "\n";
+            return;
+        }
+        args.emplace_back(arg);
+    }
+
+    execute({cmd, fullCommand}, args, multiplier);
+}
+
+ResolvedCommand CommandInterpreter::resolve(std::string_view name) const {
+    std::string_view fullCommand = matchCommand(name);
+    if (fullCommand.empty()) return {};
+    return {commands.find(fullCommand)->second.get(), fullCommand};
+}
+
+void CommandInterpreter::execute(const ResolvedCommand& resolved, const CommandArgs& args, int multiplier) {
+    Command* cmd = resolved.command;
+    std::string_view fullCommand = resolved.name;
+
+    // A pending special action must be answered before play continues
+    if (game->hasPendingEvent() && !cmd->answersSpecialAction()) {
+        game->promptPendingEvent();
+        return;
+    }
 
     // Special handling for sequence command
-    if (fullCommand == "sequence") {
-        std::string filename;
-        std::cin >> filename;
-        executeSequenceFile(filename);
+    if (fullCommand == "sequence" || fullCommand == "s") {
+        executeSequenceFile(args[0]);
         return;  // Don't render yet, sequence commands will render
     }
 
     // Execute command (respecting multiplier if allowed)
-    bool gameWasRestarted = false;
+    int gamesFinished = game->getGamesFinished();
     if (cmd->canMultiply()) {
         for (int j = 0; j < multiplier; ++j) {
-            cmd->execute(game);
-            // Stop executing if game restarted due to game over
-            if (game->shouldStopExecutingCommands()) {
-                gameWasRestarted = true;
-                break;
-            }
+            cmd->execute(game, args);
+            // Stop executing once the player is out or the game restarted
+            if (game->shouldStopExecutingCommands()) break;
+            // Stop at a special action so it is answered before the next drop
+            if (game->hasPendingEvent()) break;
         }
         // Clear the stop flag after processing
         game->clearStopExecutionFlag();
     } else {
-        cmd->execute(game);
+        cmd->execute(game, args);
     }
 
     // Note: Drop command switches players (unless game was restarted)
-    if (fullCommand == "drop" && !gameWasRestarted) {
+    if (fullCommand == "drop" && game->getGamesFinished() == gamesFinished) {
         game->switchPlayer();
     }
 
@@ -348,14 +469,14 @@ void CommandInterpreter::executeCommand(const std::string& input) {
 }
 
 void CommandInterpreter::executeSequenceFile(const std::string& filename) {
-    std::ifstream file(filename);
-    if (!file) {
+    TokenReader file(filename);
+    if (!file.isOpen()) {
         std::cerr << "Error: Could not open sequence file: " << filename << "\n";
         return;
     }
 
-    std::string command;
-    while (file >> command) {
-        executeCommand(command);
+    std::string_view command;
+    while (file.next(command)) {
+        executeCommand(command, file);
     }
 }
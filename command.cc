@@ -1,147 +1,227 @@
 export module command;
 import <string>;
+import <string_view>;
 import <map>;
 import <vector>;
 import <memory>;
+import <functional>;
 import game;
+import tokenreader;
+
+// Argument tokens read after a command name
+export using CommandArgs = std::vector<std::string>;
 
 // Abstract Command class
 export class Command {
 public:
     virtual ~Command() = default;
-    virtual void execute(Game* game) = 0;
+    virtual void execute(Game* game, const CommandArgs& args) = 0;
+    virtual int argCount() const;
     virtual bool canMultiply() const;
+    virtual bool answersSpecialAction() const;
 };
 
 // Movement commands
 export class LeftCommand : public Command {
 public:
-    void execute(Game* game) override;
+    void execute(Game* game, const CommandArgs& args) override;
 };
 
 export class RightCommand : public Command {
 public:
-    void execute(Game* game) override;
+    void execute(Game* game, const CommandArgs& args) override;
 };
 
 export class DownCommand : public Command {
 public:
-    void execute(Game* game) override;
+    void execute(Game* game, const CommandArgs& args) override;
 };
 
 export class DropCommand : public Command {
 public:
-    void execute(Game* game) override;
+    void execute(Game* game, const CommandArgs& args) override;
 };
 
 // Rotation commands
 export class RotateClockwiseCommand : public Command {
 public:
-    void execute(Game* game) override;
+    void execute(Game* game, const CommandArgs& args) override;
 };
 
 export class RotateCounterClockwiseCommand : public Command {
 public:
-    void execute(Game* game) override;
+    void execute(Game* game, const CommandArgs& args) override;
 };
 
 // Level commands
 export class LevelUpCommand : public Command {
 public:
-    void execute(Game* game) override;
+    void execute(Game* game, const CommandArgs& args) override;
 };
 
 export class LevelDownCommand : public Command {
 public:
-    void execute(Game* game) override;
+    void execute(Game* game, const CommandArgs& args) override;
 };
 
 // Random mode commands
 export class RandomCommand : public Command {
 public:
-    void execute(Game* game) override;
+    void execute(Game* game, const CommandArgs& args) override;
     bool canMultiply() const override;
 };
 
 export class NoRandomCommand : public Command {
 public:
-    void execute(Game* game) override;
+    void execute(Game* game, const CommandArgs& args) override;
     bool canMultiply() const override;
+    int argCount() const override;
 };
 
 // Restart command
 export class RestartCommand : public Command {
 public:
-    void execute(Game* game) override;
+    void execute(Game* game, const CommandArgs& args) override;
+    bool canMultiply() const override;
+};
+
+// Save and load commands - write the match to a file and resume it
+export class SaveCommand : public Command {
+public:
+    void execute(Game* game, const CommandArgs& args) override;
+    bool canMultiply() const override;
+    int argCount() const override;
+};
+
+export class LoadCommand : public Command {
+public:
+    void execute(Game* game, const CommandArgs& args) override;
     bool canMultiply() const override;
+    int argCount() const override;
 };
 
 // Sequence command - execute commands from file
 export class SequenceCommand : public Command {
 public:
-    void execute(Game* game) override;
+    void execute(Game* game, const CommandArgs& args) override;
     bool canMultiply() const override;
+    int argCount() const override;
 };
 
 // Test commands - replace current block with specified type
 export class IBlockCommand : public Command {
 public:
-    void execute(Game* game) override;
+    void execute(Game* game, const CommandArgs& args) override;
     bool canMultiply() const override;
 };
 
 export class JBlockCommand : public Command {
 public:
-    void execute(Game* game) override;
+    void execute(Game* game, const CommandArgs& args) override;
     bool canMultiply() const override;
 };
 
 export class LBlockCommand : public Command {
 public:
-    void execute(Game* game) override;
+    void execute(Game* game, const CommandArgs& args) override;
     bool canMultiply() const override;
 };
 
 export class OBlockCommand : public Command {
 public:
-    void execute(Game* game) override;
+    void execute(Game* game, const CommandArgs& args) override;
     bool canMultiply() const override;
 };
 
 export class SBlockCommand : public Command {
 public:
-    void execute(Game* game) override;
+    void execute(Game* game, const CommandArgs& args) override;
     bool canMultiply() const override;
 };
 
 export class ZBlockCommand : public Command {
 public:
-    void execute(Game* game) override;
+    void execute(Game* game, const CommandArgs& args) override;
     bool canMultiply() const override;
 };
 
 export class TBlockCommand : public Command {
 public:
-    void execute(Game* game) override;
+    void execute(Game* game, const CommandArgs& args) override;
+    bool canMultiply() const override;
+};
+
+// Special action commands - answer a pending special action
+export class BlindCommand : public Command {
+public:
+    void execute(Game* game, const CommandArgs& args) override;
+    bool canMultiply() const override;
+    bool answersSpecialAction() const override;
+};
+
+export class HeavyCommand : public Command {
+public:
+    void execute(Game* game, const CommandArgs& args) override;
     bool canMultiply() const override;
+    bool answersSpecialAction() const override;
+};
+
+export class ForceCommand : public Command {
+public:
+    void execute(Game* game, const CommandArgs& args) override;
+    bool canMultiply() const override;
+    bool answersSpecialAction() const override;
+    int argCount() const override;
+};
+
+// Picks which player the pending special action hits (games of three or more)
+export class TargetCommand : public Command {
+public:
+    void execute(Game* game, const CommandArgs& args) override;
+    bool canMultiply() const override;
+    bool answersSpecialAction() const override;
+    int argCount() const override;
 };
 
 // Help command
 export class HelpCommand : public Command {
 public:
-    void execute(Game*) override;
+    void execute(Game*, const CommandArgs&) override;
     bool canMultiply() const override;
 };
 
+// Stats command - prints hot-path timing stats (instrumented builds only)
+export class StatsCommand : public Command {
+public:
+    void execute(Game*, const CommandArgs&) override;
+    bool canMultiply() const override;
+};
+
+// A command looked up once, so callers such as key bindings can run it
+// without parsing or prefix matching
+export struct ResolvedCommand {
+    Command* command = nullptr;     // Null if the name matched nothing
+    std::string_view name;          // Full name; refers into the interpreter's table
+};
+
 // Command Interpreter
 export class CommandInterpreter {
-    std::map<std::string, std::unique_ptr<Command>> commands;
+    std::map<std::string, std::unique_ptr<Command>, std::less<>> commands;
     Game* game;
 
 public:
     CommandInterpreter(Game* g);
     void registerCommands();
-    std::string matchCommand(const std::string& prefix);
-    void executeCommand(const std::string& input);
+    std::string_view matchCommand(std::string_view prefix) const;
+
+    // Execute one command token; argument tokens are read from input
+    void executeCommand(std::string_view token, TokenReader& input);
+
+    // Look up a command by full name or unique prefix
+    ResolvedCommand resolve(std::string_view name) const;
+
+    // Run a resolved command as executeCommand does once it has parsed the
+    // token and read the arguments (args must hold argCount() of them)
+    void execute(const ResolvedCommand& resolved, const CommandArgs& args, int multiplier = 1);
     void executeSequenceFile(const std::string& filename);
 };
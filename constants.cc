@@ -7,6 +7,24 @@ export namespace GameConstants {
     constexpr int BOARD_HEIGHT = 15;
     constexpr int RESERVE_ROWS = 3;
     constexpr int TOTAL_ROWS = BOARD_HEIGHT + RESERVE_ROWS;  
+
+    // Playfield size and blind region of one board. The classic board uses
+    // the constants in this file; the variant modes are picked with -board.
+    // Blind rows are 0-indexed from the visible area, like BLIND_ROW_START.
+    struct BoardGeometry {
+        const char* name;
+        int width;
+        int height;
+        int reserve;
+        int blindColStart, blindColEnd;
+        int blindRowStart, blindRowEnd;
+
+        constexpr int totalRows() const { return height + reserve; }
+        constexpr int centerColumn() const { return width / 2; }
+        constexpr bool operator==(const BoardGeometry& other) const {
+            return width == other.width && height == other.height && reserve == other.reserve;
+        }
+    };
     
     // Properties of block
     constexpr int CELLS_PER_BLOCK = 4;
@@ -26,11 +44,39 @@ export namespace GameConstants {
     constexpr int BLIND_COL_END = 8;     
     constexpr int BLIND_ROW_START = 2;   
     constexpr int BLIND_ROW_END = 11;    
-    
+
+    // Board presets
+    constexpr BoardGeometry CLASSIC_BOARD{"classic", BOARD_WIDTH, BOARD_HEIGHT, RESERVE_ROWS,
+                                           BLIND_COL_START, BLIND_COL_END, BLIND_ROW_START, BLIND_ROW_END};
+    constexpr BoardGeometry STANDARD_BOARD{"standard", 10, 20, RESERVE_ROWS, 2, 7, 3, 16};
+    constexpr BoardGeometry MARATHON_BOARD{"marathon", 16, 30, RESERVE_ROWS, 3, 12, 5, 24};
+    constexpr BoardGeometry BOARD_PRESETS[] = {CLASSIC_BOARD, STANDARD_BOARD, MARATHON_BOARD};
+
+    // Largest preset, for tables sized at compile time
+    constexpr int MAX_BOARD_WIDTH = 16;
+    constexpr int MAX_TOTAL_ROWS = 33;
+
     // Heavy effect settings
     constexpr int HEAVY_EXTRA_DROP = 2;
     constexpr int LEVEL_HEAVY_DROP = 1;
-    
+
+    // Effect table capacity (one slot per effect type)
+    constexpr int MAX_ACTIVE_EFFECTS = 3;
+    
+    // Real-time mode: the simulation steps at a fixed rate and the current
+    // piece falls one row every GRAVITY_TICKS[level] steps
+    constexpr int REALTIME_TICK_HZ = 60;
+    constexpr int GRAVITY_TICKS[MAX_LEVEL + 1] = {48, 36, 24, 15, 8};
+    constexpr int MAX_CATCH_UP_TICKS = 5;   // Steps replayed after a stall before the clock resets
+
+    // Key codes for keyboard play: printable keys are their character,
+    // arrows come after the character range
+    constexpr int KEY_LEFT = 256;
+    constexpr int KEY_RIGHT = 257;
+    constexpr int KEY_UP = 258;
+    constexpr int KEY_DOWN = 259;
+    constexpr int KEY_CODE_COUNT = 260;
+
     // Special action threshold
     constexpr int ROWS_FOR_SPECIAL_ACTION = 2;
     
@@ -153,7 +199,8 @@ export namespace GameConstants {
     
     constexpr int PLAYER_ONE = 0;
     constexpr int PLAYER_TWO = 1;
-    constexpr int NUM_PLAYERS = 2;
+    constexpr int NUM_PLAYERS = 2;      // Default; free-for-all games take up to MAX_PLAYERS
+    constexpr int MAX_PLAYERS = 16;
 
     constexpr int INVALID_BLOCK_ID = -1;
     constexpr int INITIAL_BLOCK_ID = 0;
@@ -165,4 +212,5 @@ export namespace GameConstants {
     constexpr int NEXT_PREVIEW_ROWS = 3;  // Number of rows for next block preview
     constexpr int NEXT_PREVIEW_COLS = 4;  // Number of columns for next block preview
     constexpr int NEXT_PREVIEW_SPACING = 15;  // Spacing after next block preview
+    constexpr int TEXT_TILE_COLUMNS = 4;  // Boards per band when tiling more players
 }
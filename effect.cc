@@ -1,80 +1,105 @@
 export module effect;
+import <array>;
 import constants;
 
 using namespace GameConstants;
 
-// Abstract Effect class
+// Effect value stored inline in the board's effect table
 // Effects are markers that Board uses to modify its own state
-export class Effect {
-public:
-    virtual ~Effect() {}
-    virtual bool isExpired() const = 0;
-    virtual void update() = 0;
-
+export struct Effect {
     // Type identification for Board to know how to apply/unapply
-    enum class Type { Blind, Heavy, Force };
-    virtual Type getType() const = 0;
-};
+    enum class Type : unsigned char { Blind, Heavy, Force };
 
-// Blind effect - obscures part of opponent's display
-export class BlindEffect : public Effect {
-    int turnsLeft;
-
-public:
-    BlindEffect(int turns = 1) : turnsLeft(turns) {}
+    static constexpr int PERMANENT = -1;
 
-    Type getType() const override { return Effect::Type::Blind; }
+    Type type;
+    int turnsLeft;      // Turns until expiry, or PERMANENT
+    int stacks;         // Times this effect was applied while active
+    int extraDrop;      // Heavy: extra rows dropped after each move
+    char blockType;     // Force: block type the opponent must play
 
-    bool isExpired() const override {
-        return turnsLeft <= 0;
-    }
+    bool isExpired() const { return turnsLeft == 0; }
 
-    void update() override {
+    void update() {
         if (turnsLeft > 0) {
             turnsLeft--;
         }
     }
+
+    // Force effect expires once used
+    void markUsed() { turnsLeft = 0; }
 };
 
+// Blind effect - obscures part of opponent's display
+export constexpr Effect makeBlindEffect(int turns = 1) {
+    return Effect{Effect::Type::Blind, turns, 1, 0, '\0'};
+}
+
 // Heavy effect - makes blocks drop extra after each move
-export class HeavyEffect : public Effect {
-    int extraDropAmount;
+// Heavy effect never expires once active (permanent penalty)
+export constexpr Effect makeHeavyEffect(int drops = HEAVY_EXTRA_DROP) {
+    return Effect{Effect::Type::Heavy, Effect::PERMANENT, 1, drops, '\0'};
+}
+
+// Force effect - forces next block to be a specific type
+export constexpr Effect makeForceEffect(char type) {
+    return Effect{Effect::Type::Force, Effect::PERMANENT, 1, 0, type};
+}
+
+// Fixed-capacity table of active effects, stored by value inside Board.
+// An effect of a type that is already active is merged into the existing
+// entry, so one slot per effect type is always enough.
+export class EffectTable {
+    std::array<Effect, MAX_ACTIVE_EFFECTS> effects;
+    int count;
 
 public:
-    HeavyEffect(int drops = HEAVY_EXTRA_DROP) : extraDropAmount(drops) {}
+    EffectTable() : effects{}, count(0) {}
 
-    Type getType() const override { return Effect::Type::Heavy; }
+    int size() const { return count; }
+    const Effect& operator[](int i) const { return effects[i]; }
 
-    bool isExpired() const override {
-        // Heavy effect never expires once active (permanent penalty)
+    bool has(Effect::Type type) const {
+        for (int i = 0; i < count; ++i) {
+            if (effects[i].type == type) return true;
+        }
         return false;
     }
 
-    void update() override {
-        // No update needed - permanent effect
-    }
-
-    int getExtraDropAmount() const { return extraDropAmount; }
-};
-
-// Force effect - forces next block to be a specific type
-export class ForceEffect : public Effect {
-    char blockType;
-    bool used;
-
-public:
-    ForceEffect(char type) : blockType(type), used(false) {}
-
-    Type getType() const override { return Effect::Type::Force; }
+    // Returns false if the table is full
+    bool add(const Effect& effect) {
+        for (int i = 0; i < count; ++i) {
+            Effect& active = effects[i];
+            if (active.type != effect.type) continue;
+
+            active.stacks += effect.stacks;
+            if (active.turnsLeft != Effect::PERMANENT &&
+                (effect.turnsLeft == Effect::PERMANENT || effect.turnsLeft > active.turnsLeft)) {
+                active.turnsLeft = effect.turnsLeft;
+            }
+            return true;
+        }
 
-    bool isExpired() const override {
-        return used;
+        if (count == MAX_ACTIVE_EFFECTS) return false;
+        effects[count++] = effect;
+        return true;
     }
 
-    void update() override {
-        // No update needed - expires when used
+    // Advance every effect by one turn. Expired effects are passed to
+    // onExpired, then swap-removed with the last entry.
+    template <typename OnExpired>
+    void update(OnExpired onExpired) {
+        int i = 0;
+        while (i < count) {
+            effects[i].update();
+            if (effects[i].isExpired()) {
+                onExpired(effects[i]);
+                effects[i] = effects[--count];
+            } else {
+                ++i;
+            }
+        }
     }
 
-    void markUsed() { used = true; }
-    char getBlockType() const { return blockType; }
+    void clear() { count = 0; }
 };
@@ -1,6 +1,12 @@
 export module game;
+import <chrono>;
+import <cstdint>;
 import <memory>;
 import <string>;
+import <string_view>;
+import <vector>;
+import <deque>;
+import <functional>;
 import board;
 import block;
 import level;
@@ -8,52 +14,193 @@ import scorekeeper;
 import effect;
 import textdisplay;
 import graphicsdisplay;
+import raster;
 import constants;
 
 using namespace GameConstants;
 
+// Events raised during play that must be answered before play continues
+export enum class GameEventType { SpecialAction };
+
+export struct GameEvent {
+    GameEventType type;
+    int player;     // Player who raised the event
+    int target;     // Player a special action hits, or -1 for the next player in turn order
+};
+
+// Answer to a special action request (action is "blind", "heavy" or "force")
+export struct SpecialActionChoice {
+    std::string action;
+    char blockType;
+    int target = -1;    // As GameEvent::target
+};
+
+// Headless callback used to answer special actions without user input
+export using SpecialActionPolicy = std::function<SpecialActionChoice(int player)>;
+
+// One finished game, reported just before the automatic restart. The
+// vectors hold one entry per player.
+export struct GameSummary {
+    unsigned int seed;
+    int startLevel;
+    int winner;                         // The last player still in
+    std::vector<int> scores;
+    std::vector<int> levels;            // Levels at the end
+    std::vector<int> linesCleared;
+    std::vector<int> blocksDropped;
+    std::chrono::milliseconds duration;
+};
+
+export using GameOverHandler = std::function<void(const GameSummary& summary)>;
+
+// Save file layout (little-endian):
+//
+//   char magic[4] "BQSV", u16 SAVE_VERSION, u16 sizeof(std::mt19937)
+//   u8 board width, u8 board height, u8 reserve rows, u8 player count
+//   u32 seed, u8 start level, str script 1, str script 2
+//   u8 current player, u8 running, u8 event count,
+//     per event u8 type, u8 player, i8 target
+//   u32 milliseconds played, then per player:
+//     u8 eliminated, i32 lines cleared, i32 blocks dropped,
+//     i32 score, i32 high score, i32 wins
+//     level: u8 number, u8 random, str sequence file, u32 sequence index,
+//            generator state (levels 1-4)
+//     board: u8 type per cell (0 = empty), i32 block id per filled cell,
+//            current and next piece, locked blocks, effects, counters
+//
+// str is a u16 length and the characters. The generator state is the
+// engine's object representation, so files move only between builds using
+// the same standard library; the size in the header catches a mismatch.
+// A save loads only into a game with the same board size and player count.
+export constexpr std::uint16_t SAVE_VERSION = 3;
+
 export class Game {
-    std::unique_ptr<Board> board1;
-    std::unique_ptr<Board> board2;
-    std::unique_ptr<Level> level1;
-    std::unique_ptr<Level> level2;
-    std::unique_ptr<ScoreKeeper> score1;
-    std::unique_ptr<ScoreKeeper> score2;
-    std::unique_ptr<TextDisplay> textDisplay1;
-    std::unique_ptr<TextDisplay> textDisplay2;
-    std::unique_ptr<GraphicsDisplay> graphicsDisplay1;
-    std::unique_ptr<GraphicsDisplay> graphicsDisplay2;
+    // Everything one player owns. Seats sit side by side in one vector, so
+    // adding a player costs only its own entry.
+    struct Seat {
+        std::unique_ptr<Board> board;
+        std::unique_ptr<Level> level;
+        std::unique_ptr<ScoreKeeper> score;
+        std::unique_ptr<TextDisplay> textDisplay;
+        std::unique_ptr<GraphicsDisplay> graphicsDisplay;
+        int linesCleared = 0;           // Tallies for the game in progress
+        int blocksDropped = 0;
+        bool eliminated = false;        // Topped out while others play on
+    };
 
+    std::vector<Seat> seats;
     int currentPlayer;
     bool isRunning;
     bool textOnly;
+    bool offscreen;                 // Graphics drawn into images rather than X windows
+    bool headless;
     bool shouldStopExecution;
     unsigned int randomSeed;
     std::string scriptFile1;
     std::string scriptFile2;
+    std::string prompt;             // Shown under the boards when no special action is pending
     int startLevel;
+    std::deque<GameEvent> pendingEvents;
+    SpecialActionPolicy specialActionPolicy;
+    GameOverHandler gameOverHandler;
+    SequenceCache* sequenceCache;   // Shared sequence files, or null to read them per level
+    BoardGeometry geometry;         // Size of every board
+    std::chrono::steady_clock::time_point startTime;
+    int gamesFinished;              // Games ended by topping out since construction
+    GameSummary lastSummary;        // The latest of them
+
+    std::unique_ptr<Level> makeLevel(int levelNum, int player) const;
+    void attachDisplays();
+    void spawnInitialBlocks();
+    void renderBand(int first, int last) const;
 
 public:
     Game(unsigned int seed = 0, int level = 0,
          const std::string& script1 = "biquadris_sequence1.txt",
          const std::string& script2 = "biquadris_sequence2.txt",
-         bool textMode = false);
+         bool textMode = false,
+         SequenceCache* cache = nullptr,
+         const BoardGeometry& boardGeometry = CLASSIC_BOARD,
+         int players = NUM_PLAYERS,
+         bool offscreen = false);
 
     void createLevels(int levelNum);
     Board* getCurrentBoard();
-    Board* getOpponentBoard();
+    Board* getOpponentBoard();      // The next player's, the default special action target
     Level* getCurrentLevel();
     ScoreKeeper* getCurrentScore();
+    const BoardGeometry& getGeometry() const;
+
+    // Per-player access (0 to getPlayerCount() - 1)
+    int getCurrentPlayer() const;
+    int getPlayerCount() const;
+    Board* getBoard(int player);
+    ScoreKeeper* getScore(int player);
+    Level* getLevel(int player);
     void spawnNextBlock(Board* board);
+
+    // Turn order: players take turns in seat order, skipping anyone
+    // eliminated. With more than two players, topping out eliminates the
+    // player and the game ends when one is left.
+    bool isEliminated(int player) const;
+    int getBlocksDropped(int player) const;     // In the game in progress
+    int getPlayersLeft() const;
+    int nextPlayer(int player) const;
     void switchPlayer();
     bool drop();
     void render();
     void restart();
     bool isGameRunning() const;
-    void applySpecialAction(const std::string& action, char blockType = 'I');
+    void applySpecialAction(const std::string& action, char blockType, int sourcePlayer, int targetPlayer);
+
+    // Event queue
+    bool hasPendingEvent() const;
+    const GameEvent& peekEvent() const;
+    void promptPendingEvent() const;
+    bool answerSpecialAction(const std::string& action, char blockType = '\0');
+
+    // Aim the pending special action at another player still in the game
+    bool targetSpecialAction(int target);
+    void setSpecialActionPolicy(SpecialActionPolicy policy);
+
+    // Called when a game ends by a player topping out (not on restart commands)
+    void setGameOverHandler(GameOverHandler handler);
+
+    // Games ended by topping out since construction, and the summary of the
+    // latest. Drivers compare the count across a turn to notice a game over,
+    // since the automatic restart has already reset the boards and scores.
+    int getGamesFinished() const;
+    const GameSummary& getLastSummary() const;
+
+    // Save the whole match. save() appends to `out`, so a checkpoint can reuse
+    // one buffer every turn. load() replaces the match with a saved one and
+    // returns false, leaving the match untouched, if the data is invalid.
+    void save(std::string& out) const;
+    bool load(std::string_view data);
+
+    // File versions of the above; print the reason and return false on failure
+    bool saveFile(const std::string& filename) const;
+    bool loadFile(const std::string& filename);
+
+    // Headless mode: no rendering, beeps or effect messages (benchmarks, self-play)
+    void setHeadless(bool enabled);
+
+    // Graphics window input (nothing in text mode): the connections to wait
+    // on, and the key presses queued since the last call as KEY_* codes or
+    // characters. Exposes are repainted from the windows' back buffers.
+    void getWindowFds(std::vector<int>& fds) const;
+    void processWindowEvents(std::vector<int>& keys);
+
+    // Write a player's last graphics frame to an image file (offscreen
+    // graphics only); prints the reason and returns false on failure
+    bool saveFrame(int player, const std::string& filename, ImageFormat format, int scale = 1) const;
+
+    // Replace the command prompt (real-time mode shows its keys instead)
+    void setPrompt(std::string_view text);
+
     void levelUp();
     void levelDown();
-    void createPlayerLevel(int player, int levelNum);
+    void createPlayerLevel(int player, int levelNum);   // player is 0-based
     bool shouldStopExecutingCommands() const;
     void clearStopExecutionFlag();
 };
@@ -1,26 +1,36 @@
 module graphicsdisplay;
+import <cstdint>;
 import <memory>;
 import <string>;
+import <vector>;
+import <utility>;
+import <variant>;
+import <bit>;
 import <algorithm>;
+import <iostream>;
 import observer;
+import effect;
 import board;
 import block;
+import canvas;
+import raster;
 import xwindow;
+import instrument;
 import constants;
 
 using namespace GameConstants;
 
 int GraphicsDisplay::getColor(char type) const {
     switch (type) {
-        case 'I': return Xwindow::Cyan;
-        case 'J': return Xwindow::Blue;
-        case 'L': return Xwindow::Orange;
-        case 'O': return Xwindow::Yellow;
-        case 'S': return Xwindow::Green;
-        case 'Z': return Xwindow::Red;
-        case 'T': return Xwindow::Magenta;
-        case '*': return Xwindow::Brown;
-        default: return Xwindow::White;
+        case 'I': return Canvas::Cyan;
+        case 'J': return Canvas::Blue;
+        case 'L': return Canvas::Orange;
+        case 'O': return Canvas::Yellow;
+        case 'S': return Canvas::Green;
+        case 'Z': return Canvas::Red;
+        case 'T': return Canvas::Magenta;
+        case '*': return Canvas::Brown;
+        default: return Canvas::White;
     }
 }
 
@@ -30,10 +40,10 @@ void GraphicsDisplay::draw3DBlock(int row, int col, int color) {
 
     window->fillRectangle(x + BLOCK_3D_INSET, y + BLOCK_3D_INSET,
                         blockSize - BLOCK_3D_INSET * 2, blockSize - BLOCK_3D_INSET * 2, color);
-    window->fillRectangle(x, y, blockSize, BLOCK_3D_INSET, Xwindow::White);
-    window->fillRectangle(x, y, BLOCK_3D_INSET, blockSize, Xwindow::White);
-    window->fillRectangle(x, y + blockSize - BLOCK_3D_SHADOW, blockSize, BLOCK_3D_SHADOW, Xwindow::Black);
-    window->fillRectangle(x + blockSize - BLOCK_3D_SHADOW, y, BLOCK_3D_SHADOW, blockSize, Xwindow::Black);
+    window->fillRectangle(x, y, blockSize, BLOCK_3D_INSET, Canvas::White);
+    window->fillRectangle(x, y, BLOCK_3D_INSET, blockSize, Canvas::White);
+    window->fillRectangle(x, y + blockSize - BLOCK_3D_SHADOW, blockSize, BLOCK_3D_SHADOW, Canvas::Black);
+    window->fillRectangle(x + blockSize - BLOCK_3D_SHADOW, y, BLOCK_3D_SHADOW, blockSize, Canvas::Black);
 }
 
 void GraphicsDisplay::drawGhostBlock(int row, int col, int color) {
@@ -53,7 +63,7 @@ void GraphicsDisplay::drawGhostBlock(int row, int col, int color) {
     // Keep interior black (transparent look)
     window->fillRectangle(x + BLOCK_3D_INSET, y + BLOCK_3D_INSET,
                         blockSize - BLOCK_3D_INSET - BLOCK_3D_SHADOW,
-                        blockSize - BLOCK_3D_INSET - BLOCK_3D_SHADOW, Xwindow::Black);
+                        blockSize - BLOCK_3D_INSET - BLOCK_3D_SHADOW, Canvas::Black);
 }
 
 void GraphicsDisplay::drawEmptyCell(int row, int col) {
@@ -61,11 +71,11 @@ void GraphicsDisplay::drawEmptyCell(int row, int col) {
     int y = offsetY + row * blockSize;
 
     window->fillRectangle(x + EMPTY_CELL_INSET, y + EMPTY_CELL_INSET,
-                        blockSize - EMPTY_CELL_INSET * 2, blockSize - EMPTY_CELL_INSET * 2, Xwindow::Black);
+                        blockSize - EMPTY_CELL_INSET * 2, blockSize - EMPTY_CELL_INSET * 2, Canvas::Black);
 
     // Draw grid lines for all rows (including reserve rows)
     // Reserve rows use a dimmer color to distinguish them
-    int gridColor = (row < RESERVE_ROWS) ? Xwindow::DarkCyan : Xwindow::White;
+    int gridColor = (row < board->getGeometry().reserve) ? Canvas::DarkCyan : Canvas::White;
 
     window->fillRectangle(x, y, blockSize, GRID_LINE_THICKNESS, gridColor);
     window->fillRectangle(x, y, GRID_LINE_THICKNESS, blockSize, gridColor);
@@ -73,39 +83,99 @@ void GraphicsDisplay::drawEmptyCell(int row, int col) {
     window->fillRectangle(x + blockSize - GRID_LINE_THICKNESS, y, GRID_LINE_THICKNESS, blockSize, gridColor);
 }
 
-GraphicsDisplay::GraphicsDisplay(Board* b, std::string name, int width, int height)
-    : board(b), window(std::make_unique<Xwindow>(width, height)),
-      blockSize(GRAPHICS_BLOCK_SIZE), blindMode(false), playerName(name),
-      cachedLevel(0), cachedScore(0), cachedHighScore(0) {
+namespace {
+    constexpr std::uint64_t rowBit(int row) { return std::uint64_t{1} << row; }
 
-    int boardWidth = BOARD_WIDTH * blockSize;
+    constexpr std::uint64_t blindRows(const BoardGeometry& geometry) {
+        return (rowBit(geometry.reserve + geometry.blindRowEnd + 1) - 1) &
+               ~(rowBit(geometry.reserve + geometry.blindRowStart) - 1);
+    }
+
+    constexpr std::uint64_t allRows(const BoardGeometry& geometry) { return rowBit(geometry.totalRows()) - 1; }
+
+    // The reserve/visible separator straddles these two rows
+    constexpr std::uint64_t separatorRows(const BoardGeometry& geometry) {
+        return rowBit(geometry.reserve - 1) | rowBit(geometry.reserve);
+    }
+
+    // Larger boards shrink their cells to keep the classic board's footprint
+    constexpr int blockSizeFor(const BoardGeometry& geometry) {
+        int byHeight = GRAPHICS_BLOCK_SIZE * TOTAL_ROWS / geometry.totalRows();
+        int byWidth = GRAPHICS_BLOCK_SIZE * BOARD_WIDTH / geometry.width;
+        return std::min({GRAPHICS_BLOCK_SIZE, byHeight, byWidth});
+    }
+}
+
+GraphicsDisplay::GraphicsDisplay(Board* b, std::string name, bool drawOffscreen, int width, int height)
+    : board(b), offscreen(nullptr),
+      blockSize(blockSizeFor(b->getGeometry())), blindMode(false), playerName(name),
+      cachedLevel(0), cachedScore(0), cachedHighScore(0),
+      fullRedraw(true), panelDirty(true), overlayStale(true),
+      dirtyRows(allRows(b->getGeometry())), overlayRows(0), pieceType(' ') {
+
+    int boardWidth = board->getGeometry().width * blockSize;
     offsetX = (width - boardWidth) / 2;
     headerHeight = HEADER_HEIGHT;
     offsetY = ARCADE_TOP_BEZEL + PLAYER_NAME_SPACING;
+    if (drawOffscreen) {
+        auto image = std::make_unique<RasterCanvas>(width, height);
+        offscreen = image.get();
+        window = std::move(image);
+    } else {
+        window = std::make_unique<Xwindow>(width, height);
+    }
     window->setWindowTitle(playerName);
 }
 
-void GraphicsDisplay::update() {
-    renderWithInfo(cachedLevel, cachedScore, cachedHighScore);
+void GraphicsDisplay::notify(const BoardChange& change) {
+    if (auto* cells = std::get_if<CellsChanged>(&change)) {
+        for (int i = 0; i < cells->count; ++i) {
+            dirtyRows |= rowBit(cells->cells[i].first);
+        }
+        overlayStale = true;
+    }
+    else if (auto* rows = std::get_if<RowsCleared>(&change)) {
+        // Every row at or above the lowest cleared row has shifted
+        dirtyRows |= rowBit(std::bit_width(rows->rowMask)) - 1;
+        overlayStale = true;
+    }
+    else if (std::holds_alternative<PieceMoved>(change)) {
+        overlayStale = true;
+    }
+    else if (std::holds_alternative<NextPieceChanged>(change)) {
+        panelDirty = true;
+    }
+    else if (auto* effect = std::get_if<EffectToggled>(&change)) {
+        if (effect->effect == Effect::Type::Blind) setBlindMode(effect->active);
+    }
+    else if (std::holds_alternative<ScoreChanged>(change)) {
+        panelDirty = true;
+    }
 }
 
 void GraphicsDisplay::setGameInfo(int level, int score, int highScore) {
+    if (level != cachedLevel || score != cachedScore || highScore != cachedHighScore) {
+        panelDirty = true;
+    }
     cachedLevel = level;
     cachedScore = score;
     cachedHighScore = highScore;
 }
 
 void GraphicsDisplay::setBlindMode(bool blind) {
+    if (blindMode == blind) return;
     blindMode = blind;
+    dirtyRows |= blindRows(board->getGeometry());
 }
 
 void GraphicsDisplay::setBoard(Board* b) {
     board = b;
+    blindMode = board->hasBlindEffect();
+    fullRedraw = true;
+    overlayStale = true;
 }
-void GraphicsDisplay::render() {
-    const auto& grid = board->getGrid();
-    Block* current = board->getCurrentBlock();
 
+void GraphicsDisplay::drawFrame() {
     window->drawTetrisBackground(GRAPHICS_WINDOW_WIDTH, GRAPHICS_WINDOW_HEIGHT);
 
     std::string gameboyText = "Nintendo";
@@ -115,7 +185,7 @@ void GraphicsDisplay::render() {
     int pillX = GRAPHICS_WINDOW_WIDTH - pillWidth - GAMEBOY_TEXT_MARGIN;
     int pillY = GRAPHICS_WINDOW_HEIGHT - pillHeight - GAMEBOY_TEXT_MARGIN;
     
-    window->drawRoundedRectangle(pillX, pillY, pillWidth, pillHeight, NINTENDO_PILL_RADIUS, Xwindow::White);
+    window->drawRoundedRectangle(pillX, pillY, pillWidth, pillHeight, NINTENDO_PILL_RADIUS, Canvas::White);
     
     int gameboyTextX = pillX + (pillWidth - gameboyTextWidth) / 2 + NINTENDO_TEXT_X_OFFSET;
     int gameboyTextY = pillY + NINTENDO_PILL_PADDING_Y + CHAR_WIDTH_GAMEBOY;
@@ -129,109 +199,117 @@ void GraphicsDisplay::render() {
 
     int screenX = offsetX - ARCADE_SCREEN_PADDING;
     int screenY = ARCADE_TOP_BEZEL - ARCADE_SCREEN_PADDING;
-    int screenW = BOARD_WIDTH * blockSize + ARCADE_SCREEN_PADDING * 2;
-    int screenH = TOTAL_ROWS * blockSize + ARCADE_SCREEN_PADDING * 2 + PLAYER_NAME_SPACING;
+    int screenW = board->getGeometry().width * blockSize + ARCADE_SCREEN_PADDING * 2;
+    int screenH = board->getGeometry().totalRows() * blockSize + ARCADE_SCREEN_PADDING * 2 + PLAYER_NAME_SPACING;
     
     window->fillRectangle(screenX - ARCADE_BEZEL_THICKNESS, screenY - ARCADE_BEZEL_THICKNESS,
-                        screenW + ARCADE_BEZEL_THICKNESS * 2, ARCADE_BEZEL_THICKNESS, Xwindow::Orange);
+                        screenW + ARCADE_BEZEL_THICKNESS * 2, ARCADE_BEZEL_THICKNESS, Canvas::Orange);
     window->fillRectangle(screenX - ARCADE_BEZEL_THICKNESS, screenY - ARCADE_BEZEL_THICKNESS,
-                        ARCADE_BEZEL_THICKNESS, screenH + ARCADE_BEZEL_THICKNESS * 2, Xwindow::Orange);
+                        ARCADE_BEZEL_THICKNESS, screenH + ARCADE_BEZEL_THICKNESS * 2, Canvas::Orange);
     window->fillRectangle(screenX - ARCADE_BEZEL_THICKNESS, screenY + screenH,
-                        screenW + ARCADE_BEZEL_THICKNESS * 2, ARCADE_BEZEL_THICKNESS, Xwindow::Orange);
+                        screenW + ARCADE_BEZEL_THICKNESS * 2, ARCADE_BEZEL_THICKNESS, Canvas::Orange);
     window->fillRectangle(screenX + screenW, screenY - ARCADE_BEZEL_THICKNESS,
-                        ARCADE_BEZEL_THICKNESS, screenH + ARCADE_BEZEL_THICKNESS * 2, Xwindow::Orange);
+                        ARCADE_BEZEL_THICKNESS, screenH + ARCADE_BEZEL_THICKNESS * 2, Canvas::Orange);
     
     window->fillRectangle(screenX - SCREEN_INNER_BEZEL, screenY - SCREEN_INNER_BEZEL, 
-                        screenW + SCREEN_INNER_BEZEL * 2, SCREEN_INNER_BEZEL, Xwindow::White);
+                        screenW + SCREEN_INNER_BEZEL * 2, SCREEN_INNER_BEZEL, Canvas::White);
     window->fillRectangle(screenX - SCREEN_INNER_BEZEL, screenY - SCREEN_INNER_BEZEL, 
-                        SCREEN_INNER_BEZEL, screenH + SCREEN_INNER_BEZEL * 2, Xwindow::White);
+                        SCREEN_INNER_BEZEL, screenH + SCREEN_INNER_BEZEL * 2, Canvas::White);
     window->fillRectangle(screenX - SCREEN_INNER_BEZEL, screenY + screenH, 
-                        screenW + SCREEN_INNER_BEZEL * 2, SCREEN_INNER_BEZEL, Xwindow::White);
+                        screenW + SCREEN_INNER_BEZEL * 2, SCREEN_INNER_BEZEL, Canvas::White);
     window->fillRectangle(screenX + screenW, screenY - SCREEN_INNER_BEZEL, 
-                        SCREEN_INNER_BEZEL, screenH + SCREEN_INNER_BEZEL * 2, Xwindow::White);
+                        SCREEN_INNER_BEZEL, screenH + SCREEN_INNER_BEZEL * 2, Canvas::White);
     
-    window->fillRectangle(screenX, screenY, screenW, screenH, Xwindow::Black);
+    window->fillRectangle(screenX, screenY, screenW, screenH, Canvas::Black);
 
     int textWidth = playerName.length() * CHAR_WIDTH_STANDARD;
     int nameX = (GRAPHICS_WINDOW_WIDTH - textWidth) / 2 + TEXT_BASELINE_OFFSET;
     int nameY = screenY + PLAYER_NAME_Y_OFFSET;
     window->drawString(nameX, nameY, playerName);
 
-    auto display = grid;
+}
 
-    // Overlay ghost piece first (lowercase letters)
+void GraphicsDisplay::updateOverlay() {
+    Block* current = board->getCurrentBlock();
+    ghostCells.clear();
+    pieceCells.clear();
     if (current) {
-        auto ghostCells = board->getGhostPosition();
-        for (const auto& cell : ghostCells) {
-            int row = cell.first;
-            int col = cell.second;
-            if (row >= 0 && row < TOTAL_ROWS && col >= 0 && col < BOARD_WIDTH) {
-                display[row][col].setType(tolower(current->getType()));
-                display[row][col].setFilled(true);
-            }
-        }
+        ghostCells = board->getGhostPosition();
+        pieceCells = current->getAbsoluteCells();
+        pieceType = current->getType();
     }
 
-    // Overlay current block (overwrites ghost if at same position)
-    if (current) {
-        auto cells = current->getAbsoluteCells();
-        for (const auto& cell : cells) {
-            int row = cell.first;
-            int col = cell.second;
-            if (row >= 0 && row < TOTAL_ROWS && col >= 0 && col < BOARD_WIDTH) {
-                display[row][col].setType(current->getType());
-                display[row][col].setFilled(true);
-            }
-        }
+    int totalRows = board->getGeometry().totalRows();
+    std::uint64_t rows = 0;
+    for (const auto& cell : ghostCells) {
+        if (cell.first >= 0 && cell.first < totalRows) rows |= rowBit(cell.first);
+    }
+    for (const auto& cell : pieceCells) {
+        if (cell.first >= 0 && cell.first < totalRows) rows |= rowBit(cell.first);
     }
+    dirtyRows |= rows | overlayRows;
+    overlayRows = rows;
+    overlayStale = false;
+}
+
+void GraphicsDisplay::drawRows(std::uint64_t rows) {
+    const auto& grid = board->getGrid();
+    const BoardGeometry& geometry = board->getGeometry();
+
+    for (int row = 0; row < geometry.totalRows(); ++row) {
+        if (!(rows & rowBit(row))) continue;
+
+        for (int col = 0; col < geometry.width; ++col) {
+            // Current block overwrites the ghost, which overwrites the grid
+            bool isPiece = false;
+            bool isGhost = false;
+            for (const auto& cell : pieceCells) {
+                if (cell.first == row && cell.second == col) isPiece = true;
+            }
+            for (const auto& cell : ghostCells) {
+                if (cell.first == row && cell.second == col) isGhost = true;
+            }
 
-    for (int row = 0; row < TOTAL_ROWS; ++row) {
-        for (int col = 0; col < BOARD_WIDTH; ++col) {
-            if (display[row][col].isFilled()) {
-                char cellType = display[row][col].getType();
-
-                // Check if this is a ghost cell (lowercase)
-                if (cellType >= 'a' && cellType <= 'z') {
-                    // Ghost piece - draw as outline only
-                    char upperType = toupper(cellType);
-                    int color = getColor(upperType);
-                    drawGhostBlock(row, col, color);
-                } else {
-                    // Regular filled cell
-                    int color = getColor(cellType);
-                    draw3DBlock(row, col, color);
-                }
+            if (isPiece) {
+                draw3DBlock(row, col, getColor(pieceType));
+            } else if (isGhost) {
+                // Ghost piece - draw as outline only
+                drawGhostBlock(row, col, getColor(pieceType));
+            } else if (grid[row][col].isFilled()) {
+                draw3DBlock(row, col, getColor(grid[row][col].getType()));
             } else {
                 drawEmptyCell(row, col);
             }
         }
     }
+}
 
-    // Draw white box overlay for blind effect
+void GraphicsDisplay::drawBlindOverlay() {
     if (blindMode) {
-        int blindStartRow = RESERVE_ROWS + BLIND_ROW_START;
-        int blindEndRow = RESERVE_ROWS + BLIND_ROW_END;
-        int blindStartCol = BLIND_COL_START;
-        int blindEndCol = BLIND_COL_END;
+        const BoardGeometry& geometry = board->getGeometry();
+        int blindStartRow = geometry.reserve + geometry.blindRowStart;
+        int blindEndRow = geometry.reserve + geometry.blindRowEnd;
+        int blindStartCol = geometry.blindColStart;
+        int blindEndCol = geometry.blindColEnd;
         
         int blindX = offsetX + blindStartCol * blockSize;
         int blindY = offsetY + blindStartRow * blockSize;
         int blindWidth = (blindEndCol - blindStartCol + 1) * blockSize;
         int blindHeight = (blindEndRow - blindStartRow + 1) * blockSize;
         
-        window->fillRectangle(blindX, blindY, blindWidth, blindHeight, Xwindow::White);
+        window->fillRectangle(blindX, blindY, blindWidth, blindHeight, Canvas::White);
     }
-    
-    // Draw separator line between reserve rows and visible play area
-    int separatorY = offsetY + RESERVE_ROWS * blockSize;
-    int boardPixelWidth = BOARD_WIDTH * blockSize;
-    window->fillRectangle(offsetX, separatorY - 1, boardPixelWidth, 2, Xwindow::Yellow);
 }
 
-void GraphicsDisplay::renderWithInfo(int level, int score, int highScore) {
-    render();
+void GraphicsDisplay::drawSeparator() {
+    // Separator line between reserve rows and visible play area
+    int separatorY = offsetY + board->getGeometry().reserve * blockSize;
+    int boardPixelWidth = board->getGeometry().width * blockSize;
+    window->fillRectangle(offsetX, separatorY - 1, boardPixelWidth, 2, Canvas::Yellow);
+}
 
-    int boardHeight = TOTAL_ROWS * blockSize;
+void GraphicsDisplay::drawInfoPanel(int level, int score, int highScore) {
+    int boardHeight = board->getGeometry().totalRows() * blockSize;
     int bottomPanelY = ARCADE_TOP_BEZEL + boardHeight + ARCADE_SCREEN_PADDING * 2 + PLAYER_NAME_SPACING + SCREEN_TO_PANEL_GAP;
 
     int leftPanelX = ARCADE_SIDE_MARGIN;
@@ -239,18 +317,18 @@ void GraphicsDisplay::renderWithInfo(int level, int score, int highScore) {
     int totalPanelHeight = PANEL_HEADER_HEIGHT + PANEL_PREVIEW_SECTION_HEIGHT;
 
     window->fillRectangle(leftPanelX - PANEL_OUTER_BORDER, bottomPanelY - PANEL_OUTER_BORDER, 
-                        SIDE_PANEL_WIDTH + PANEL_OUTER_BORDER * 2, totalPanelHeight + PANEL_OUTER_BORDER * 2, Xwindow::Orange);
+                        SIDE_PANEL_WIDTH + PANEL_OUTER_BORDER * 2, totalPanelHeight + PANEL_OUTER_BORDER * 2, Canvas::Orange);
     window->fillRectangle(leftPanelX - PANEL_MIDDLE_BORDER, bottomPanelY - PANEL_MIDDLE_BORDER, 
-                        SIDE_PANEL_WIDTH + PANEL_MIDDLE_BORDER * 2, totalPanelHeight + PANEL_MIDDLE_BORDER * 2, Xwindow::DarkCyan);
+                        SIDE_PANEL_WIDTH + PANEL_MIDDLE_BORDER * 2, totalPanelHeight + PANEL_MIDDLE_BORDER * 2, Canvas::DarkCyan);
     window->fillRectangle(leftPanelX - PANEL_BORDER_THICKNESS, bottomPanelY - PANEL_BORDER_THICKNESS,
-                        SIDE_PANEL_WIDTH + PANEL_BORDER_THICKNESS * 2, totalPanelHeight + PANEL_BORDER_THICKNESS * 2, Xwindow::Black);
+                        SIDE_PANEL_WIDTH + PANEL_BORDER_THICKNESS * 2, totalPanelHeight + PANEL_BORDER_THICKNESS * 2, Canvas::Black);
 
-    window->fillRectangle(leftPanelX, bottomPanelY, SIDE_PANEL_WIDTH, PANEL_HEADER_HEIGHT, Xwindow::DarkCyan);
+    window->fillRectangle(leftPanelX, bottomPanelY, SIDE_PANEL_WIDTH, PANEL_HEADER_HEIGHT, Canvas::DarkCyan);
     int nextTextX = leftPanelX + (SIDE_PANEL_WIDTH - NEXT_TEXT_WIDTH) / 2 + TEXT_BASELINE_OFFSET;
     window->drawString(nextTextX, bottomPanelY + PANEL_HEADER_HEIGHT / 2 + TEXT_BASELINE_OFFSET, "NEXT");
 
     int contentSectionY = bottomPanelY + PANEL_HEADER_HEIGHT;
-    window->fillRectangle(leftPanelX, contentSectionY, SIDE_PANEL_WIDTH, PANEL_BORDER_THICKNESS, Xwindow::White);
+    window->fillRectangle(leftPanelX, contentSectionY, SIDE_PANEL_WIDTH, PANEL_BORDER_THICKNESS, Canvas::White);
     
     Block* next = board->getNextBlock();
     if (next) {
@@ -259,8 +337,8 @@ void GraphicsDisplay::renderWithInfo(int level, int score, int highScore) {
         int previewHeight = previewSize - NEXT_PREVIEW_HEIGHT_REDUCTION;
 
         window->fillRectangle(previewX - PREVIEW_BOX_BORDER, previewY - PREVIEW_BOX_BORDER, 
-                            previewSize + PREVIEW_BOX_BORDER * 2, previewHeight + PREVIEW_BOX_BORDER * 2, Xwindow::White);
-        window->fillRectangle(previewX, previewY, previewSize, previewHeight, Xwindow::Black);
+                            previewSize + PREVIEW_BOX_BORDER * 2, previewHeight + PREVIEW_BOX_BORDER * 2, Canvas::White);
+        window->fillRectangle(previewX, previewY, previewSize, previewHeight, Canvas::Black);
 
         auto cells = next->getCells();
         int color = getColor(next->getType());
@@ -287,12 +365,12 @@ void GraphicsDisplay::renderWithInfo(int level, int score, int highScore) {
             window->fillRectangle(x + PREVIEW_BOX_BORDER, y + PREVIEW_BOX_BORDER, 
                                 blockSize / PREVIEW_BLOCK_SCALE - PREVIEW_BOX_BORDER * 2, 
                                 blockSize / PREVIEW_BLOCK_SCALE - PREVIEW_BOX_BORDER * 2, color);
-            window->fillRectangle(x, y, blockSize / PREVIEW_BLOCK_SCALE, PREVIEW_BOX_BORDER, Xwindow::White);
-            window->fillRectangle(x, y, PREVIEW_BOX_BORDER, blockSize / PREVIEW_BLOCK_SCALE, Xwindow::White);
+            window->fillRectangle(x, y, blockSize / PREVIEW_BLOCK_SCALE, PREVIEW_BOX_BORDER, Canvas::White);
+            window->fillRectangle(x, y, PREVIEW_BOX_BORDER, blockSize / PREVIEW_BLOCK_SCALE, Canvas::White);
             window->fillRectangle(x, y + blockSize / PREVIEW_BLOCK_SCALE - PREVIEW_BOX_BORDER, 
-                                blockSize / PREVIEW_BLOCK_SCALE, PREVIEW_BOX_BORDER, Xwindow::Black);
+                                blockSize / PREVIEW_BLOCK_SCALE, PREVIEW_BOX_BORDER, Canvas::Black);
             window->fillRectangle(x + blockSize / PREVIEW_BLOCK_SCALE - PREVIEW_BOX_BORDER, y, 
-                                PREVIEW_BOX_BORDER, blockSize / PREVIEW_BLOCK_SCALE, Xwindow::Black);
+                                PREVIEW_BOX_BORDER, blockSize / PREVIEW_BLOCK_SCALE, Canvas::Black);
         }
         
         int statsX = previewX + previewSize + NEXT_STATS_OFFSET;
@@ -304,9 +382,14 @@ void GraphicsDisplay::renderWithInfo(int level, int score, int highScore) {
     }
 
     window->fillRectangle(leftPanelX - PANEL_BORDER_THICKNESS, bottomPanelY - PANEL_BORDER_THICKNESS,
-                        CORNER_ACCENT_SIZE, PREVIEW_BOX_BORDER, Xwindow::Yellow);
+                        CORNER_ACCENT_SIZE, PREVIEW_BOX_BORDER, Canvas::Yellow);
     window->fillRectangle(leftPanelX - PANEL_BORDER_THICKNESS, bottomPanelY - PANEL_BORDER_THICKNESS,
-                        PREVIEW_BOX_BORDER, CORNER_ACCENT_SIZE, Xwindow::Yellow);
+                        PREVIEW_BOX_BORDER, CORNER_ACCENT_SIZE, Canvas::Yellow);
+}
+
+void GraphicsDisplay::drawDecorations() {
+    int boardHeight = board->getGeometry().totalRows() * blockSize;
+    int bottomPanelY = ARCADE_TOP_BEZEL + boardHeight + ARCADE_SCREEN_PADDING * 2 + PLAYER_NAME_SPACING + SCREEN_TO_PANEL_GAP;
 
     int rightPanelX = GRAPHICS_WINDOW_WIDTH - ARCADE_SIDE_MARGIN - CONTROL_PANEL_WIDTH;
     int arrowX = rightPanelX + (CONTROL_PANEL_WIDTH - (CONTROL_KEY_SIZE * 3 + CONTROL_KEY_GAP * 2)) / 2;
@@ -316,7 +399,58 @@ void GraphicsDisplay::renderWithInfo(int level, int score, int highScore) {
     int logoX = LOGO_MARGIN;
     int logoY = GRAPHICS_WINDOW_HEIGHT - LOGO_HEIGHT - LOGO_MARGIN;
     window->drawLogo(logoX, logoY, LOGO_WIDTH, LOGO_HEIGHT);
+}
+
+void GraphicsDisplay::render() {
+    drawFrame();
+    updateOverlay();
+    drawRows(allRows(board->getGeometry()));
+    drawBlindOverlay();
+    drawSeparator();
+    dirtyRows = 0;
+}
+
+void GraphicsDisplay::renderWithInfo(int level, int score, int highScore) {
+    Instrument::ScopedTimer timer(Instrument::Phase::GraphicsRender);
+    render();
+    drawInfoPanel(level, score, highScore);
+    drawDecorations();
+    fullRedraw = false;
+    panelDirty = false;
+    window->present();
+}
+
+void GraphicsDisplay::refresh() {
+    if (fullRedraw) {
+        renderWithInfo(cachedLevel, cachedScore, cachedHighScore);
+        return;
+    }
+
+    Instrument::ScopedTimer timer(Instrument::Phase::GraphicsRender);
+    if (overlayStale) updateOverlay();
+    if (!dirtyRows && !panelDirty) return;
+
+    drawRows(dirtyRows);
+    if (blindMode && (dirtyRows & blindRows(board->getGeometry()))) drawBlindOverlay();
+    if (dirtyRows & separatorRows(board->getGeometry())) drawSeparator();
+    dirtyRows = 0;
+
+    if (panelDirty) {
+        drawInfoPanel(cachedLevel, cachedScore, cachedHighScore);
+        panelDirty = false;
+    }
 
     window->present();
 }
 
+void GraphicsDisplay::processEvents(std::vector<int>& keys) { window->processEvents(keys); }
+
+int GraphicsDisplay::inputFd() const { return window->connectionFd(); }
+
+bool GraphicsDisplay::saveFrame(const std::string& filename, ImageFormat format, int scale) const {
+    if (!offscreen) {
+        std::cerr << "Error: Could not save frame: " << playerName << " is not drawn offscreen\n";
+        return false;
+    }
+    return offscreen->save(filename, format, scale);
+}
@@ -1,17 +1,22 @@
 export module graphicsdisplay;
+import <cstdint>;
 import <memory>;
 import <string>;
+import <vector>;
+import <utility>;
 import observer;
 import board;
 import block;
-import xwindow;
+import canvas;
+import raster;
 import constants;
 
 using namespace GameConstants;
 
 export class GraphicsDisplay : public IObserver {
     Board* board;
-    std::unique_ptr<Xwindow> window;
+    std::unique_ptr<Canvas> window;
+    RasterCanvas* offscreen;             // The window's image when drawn offscreen, else null
     int blockSize;
     int offsetX;
     int offsetY;
@@ -22,17 +27,48 @@ export class GraphicsDisplay : public IObserver {
     int cachedScore;
     int cachedHighScore;
 
+    // Repaint state accumulated from board notifications
+    bool fullRedraw;                     // Whole window must be repainted
+    bool panelDirty;                     // Next/score panel must be repainted
+    bool overlayStale;                   // Piece moved since the last repaint
+    std::uint64_t dirtyRows;             // Bit r set if board row r must be repainted
+    std::uint64_t overlayRows;           // Rows covered by current/ghost piece when last painted
+    std::vector<std::pair<int, int>> ghostCells;
+    std::vector<std::pair<int, int>> pieceCells;
+    char pieceType;
+
     int getColor(char type) const;
     void draw3DBlock(int row, int col, int color);
     void drawGhostBlock(int row, int col, int color);
     void drawEmptyCell(int row, int col);
+    void drawFrame();
+    void updateOverlay();
+    void drawRows(std::uint64_t rows);
+    void drawBlindOverlay();
+    void drawSeparator();
+    void drawInfoPanel(int level, int score, int highScore);
+    void drawDecorations();
 
 public:
-    GraphicsDisplay(Board* b, std::string name = "Player", int width = GRAPHICS_WINDOW_WIDTH, int height = GRAPHICS_WINDOW_HEIGHT);
-    void update() override;
+    // An offscreen display draws into an image in memory instead of an X window
+    GraphicsDisplay(Board* b, std::string name = "Player", bool offscreen = false,
+                    int width = GRAPHICS_WINDOW_WIDTH, int height = GRAPHICS_WINDOW_HEIGHT);
+    void notify(const BoardChange& change) override;
     void setBlindMode(bool blind);
     void setBoard(Board* b);
     void setGameInfo(int level, int score, int highScore);
     void render();
     void renderWithInfo(int level, int score, int highScore);
+
+    // Repaint only the regions dirtied since the last refresh, then present
+    void refresh();
+
+    // Window input: exposes are repainted from the back buffer without a
+    // redraw, key presses are appended to keys (see Xwindow::processEvents)
+    void processEvents(std::vector<int>& keys);
+    int inputFd() const;
+
+    // Write the last frame of an offscreen display to an image file;
+    // prints the reason and returns false on failure
+    bool saveFrame(const std::string& filename, ImageFormat format, int scale = 1) const;
 };
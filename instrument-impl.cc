@@ -0,0 +1,193 @@
+module instrument;
+import <array>;
+import <atomic>;
+import <bit>;
+import <chrono>;
+import <cstdint>;
+import <fstream>;
+import <iostream>;
+import <iomanip>;
+import <memory>;
+import <mutex>;
+import <string>;
+import <string_view>;
+import <vector>;
+
+namespace Instrument {
+    namespace {
+        std::array<Histogram, PHASE_COUNT> phases;
+        std::array<std::atomic<std::uint64_t>, COUNTER_COUNT> counters{};
+        thread_local std::uint64_t threadAllocations = 0;
+
+        const char* const PHASE_NAMES[PHASE_COUNT] = {
+            "command", "matchCommand", "drop", "clearRows", "checkBlockRemoval",
+            "updateEffects", "render", "text compose", "graphics render"
+        };
+
+        const char* const COUNTER_NAMES[COUNTER_COUNT] = {
+            "commands", "drops", "lines cleared", "allocations"
+        };
+
+        std::chrono::steady_clock::time_point traceEpoch;
+
+        // Every thread's trace buffer; locked only when a thread records its
+        // first event and when the trace is written
+        std::mutex traceBuffersMutex;
+        std::vector<std::unique_ptr<TraceBuffer>> traceBuffers;
+
+        TraceBuffer& threadTraceBuffer() {
+            thread_local TraceBuffer* buffer = nullptr;
+            if (!buffer) {
+                std::lock_guard<std::mutex> lock(traceBuffersMutex);
+                traceBuffers.push_back(std::make_unique<TraceBuffer>(static_cast<int>(traceBuffers.size())));
+                buffer = traceBuffers.back().get();
+            }
+            return *buffer;
+        }
+
+        void writeJsonString(std::ostream& out, std::string_view s) {
+            out << '"';
+            for (char c : s) {
+                if (c == '"' || c == '\\') out << '\\';
+                if (static_cast<unsigned char>(c) >= 0x20) out << c;
+            }
+            out << '"';
+        }
+    }
+
+    void Histogram::record(std::uint64_t ns, std::uint64_t allocs) {
+        buckets[std::bit_width(ns)].fetch_add(1, std::memory_order_relaxed);
+        samples.fetch_add(1, std::memory_order_relaxed);
+        totalNs.fetch_add(ns, std::memory_order_relaxed);
+        std::uint64_t seen = maxNs.load(std::memory_order_relaxed);
+        while (ns > seen && !maxNs.compare_exchange_weak(seen, ns, std::memory_order_relaxed)) {}
+        allocations.fetch_add(allocs, std::memory_order_relaxed);
+    }
+
+    void Histogram::clear() {
+        for (auto& bucket : buckets) bucket.store(0, std::memory_order_relaxed);
+        samples.store(0, std::memory_order_relaxed);
+        totalNs.store(0, std::memory_order_relaxed);
+        maxNs.store(0, std::memory_order_relaxed);
+        allocations.store(0, std::memory_order_relaxed);
+    }
+
+    std::uint64_t Histogram::percentile(double p) const {
+        if (count() == 0) return 0;
+
+        std::uint64_t n = count();
+        std::uint64_t rank = static_cast<std::uint64_t>(p * n);
+        if (rank >= n) rank = n - 1;
+
+        std::uint64_t maxSeen = max();
+        std::uint64_t seen = 0;
+        for (int b = 0; b < BUCKETS; ++b) {
+            seen += buckets[b].load(std::memory_order_relaxed);
+            if (seen > rank) {
+                // Bucket 64 would overflow the shift; it is bounded by max anyway
+                std::uint64_t upper = b < 64 ? (std::uint64_t{1} << b) - 1 : maxSeen;
+                return upper < maxSeen ? upper : maxSeen;
+            }
+        }
+        return maxSeen;
+    }
+
+    const Histogram& histogram(Phase phase) { return phases[static_cast<int>(phase)]; }
+
+    std::uint64_t counterValue(Counter counter) {
+        return counters[static_cast<int>(counter)].load(std::memory_order_relaxed);
+    }
+
+    const char* phaseName(Phase phase) { return PHASE_NAMES[static_cast<int>(phase)]; }
+
+    void recordPhase(Phase phase, std::uint64_t ns, std::uint64_t allocs) {
+        phases[static_cast<int>(phase)].record(ns, allocs);
+    }
+
+    void addCount(Counter counter, std::uint64_t n) {
+        counters[static_cast<int>(counter)].fetch_add(n, std::memory_order_relaxed);
+    }
+
+    void recordAllocation() {
+        ++threadAllocations;
+        counters[static_cast<int>(Counter::Allocations)].fetch_add(1, std::memory_order_relaxed);
+    }
+
+    std::uint64_t threadAllocationCount() { return threadAllocations; }
+
+    void reset() {
+        for (auto& h : phases) h.clear();
+        for (auto& c : counters) c.store(0, std::memory_order_relaxed);
+    }
+
+    void printStats(std::ostream& out) {
+        if (!ENABLED) {
+            out << "Instrumentation is disabled; rebuild with 'make INSTRUMENT=1'\n";
+            return;
+        }
+
+        out << std::left << std::setw(24) << "phase" << std::right
+            << std::setw(10) << "calls" << std::setw(12) << "p50 ns" << std::setw(12) << "p99 ns"
+            << std::setw(12) << "max ns" << std::setw(12) << "mean ns" << std::setw(14) << "allocs/call"
+            << "\n";
+        for (int i = 0; i < PHASE_COUNT; ++i) {
+            const Histogram& h = phases[i];
+            double allocsPerCall = h.count() ? static_cast<double>(h.allocationCount()) / h.count() : 0;
+            out << std::left << std::setw(24) << PHASE_NAMES[i] << std::right
+                << std::setw(10) << h.count()
+                << std::setw(12) << h.percentile(0.50)
+                << std::setw(12) << h.percentile(0.99)
+                << std::setw(12) << h.max()
+                << std::setw(12) << h.mean()
+                << std::setw(14) << std::fixed << std::setprecision(2) << allocsPerCall
+                << std::defaultfloat << "\n";
+        }
+
+        out << "\n";
+        for (int i = 0; i < COUNTER_COUNT; ++i) {
+            out << std::left << std::setw(24) << COUNTER_NAMES[i] << std::right
+                << std::setw(10) << counters[i].load(std::memory_order_relaxed) << "\n";
+        }
+        out << "(percentiles are power-of-two bucket upper bounds)\n";
+    }
+
+    void startTrace() {
+        traceEpoch = std::chrono::steady_clock::now();
+        tracingActive = true;
+    }
+
+    void recordTraceEvent(Phase phase, std::string_view detail,
+                          std::chrono::steady_clock::time_point start, std::uint64_t durationNs) {
+        auto sinceEpoch = std::chrono::duration_cast<std::chrono::nanoseconds>(start - traceEpoch);
+        threadTraceBuffer().push({phase, detail, static_cast<std::uint64_t>(sinceEpoch.count()), durationNs});
+    }
+
+    bool writeTrace(const std::string& filename) {
+        tracingActive = false;
+
+        std::ofstream out(filename);
+        if (!out) return false;
+
+        // Chrome trace timestamps are in microseconds
+        out << "{\"displayTimeUnit\": \"ns\", \"traceEvents\": [";
+        bool first = true;
+        std::lock_guard<std::mutex> lock(traceBuffersMutex);
+        for (const auto& buffer : traceBuffers) {
+            std::uint64_t end = buffer->size();
+            std::uint64_t begin = end > TraceBuffer::CAPACITY ? end - TraceBuffer::CAPACITY : 0;
+            for (std::uint64_t i = begin; i < end; ++i) {
+                const TraceEvent& e = buffer->at(i);
+                out << (first ? "\n" : ",\n") << "{\"name\": ";
+                writeJsonString(out, e.detail.empty() ? std::string_view(phaseName(e.phase)) : e.detail);
+                out << ", \"cat\": \"" << phaseName(e.phase) << "\", \"ph\": \"X\""
+                    << ", \"pid\": 1, \"tid\": " << buffer->getThreadIndex()
+                    << std::fixed << std::setprecision(3)
+                    << ", \"ts\": " << e.startNs / 1000.0
+                    << ", \"dur\": " << e.durationNs / 1000.0 << "}";
+                first = false;
+            }
+        }
+        out << "\n]}\n";
+        return static_cast<bool>(out);
+    }
+}
@@ -0,0 +1,170 @@
+export module instrument;
+import <array>;
+import <atomic>;
+import <chrono>;
+import <cstdint>;
+import <iostream>;
+import <string>;
+import <string_view>;
+import <vector>;
+
+// Hot-path timers and counters. Histograms and counters are compiled in
+// only when built with -DBIQUADRIS_INSTRUMENT (make INSTRUMENT=1).
+// Tracing (-trace) works in every build; when it is off a timer costs
+// one branch.
+export namespace Instrument {
+#ifdef BIQUADRIS_INSTRUMENT
+    constexpr bool ENABLED = true;
+#else
+    constexpr bool ENABLED = false;
+#endif
+
+    // Timed phases (nested phases are also counted in their parent)
+    enum class Phase : unsigned char {
+        Command,
+        MatchCommand,
+        Drop,
+        ClearRows,
+        BlockRemoval,
+        EffectUpdate,
+        Render,
+        TextCompose,
+        GraphicsRender,
+        Count
+    };
+
+    enum class Counter : unsigned char {
+        Commands,
+        Drops,
+        LinesCleared,
+        Allocations,
+        Count
+    };
+
+    constexpr int PHASE_COUNT = static_cast<int>(Phase::Count);
+    constexpr int COUNTER_COUNT = static_cast<int>(Counter::Count);
+
+    // Durations bucketed by bit width: bucket b holds [2^(b-1), 2^b) ns.
+    // Search, self-play and host threads record concurrently, so the fields
+    // are relaxed atomics; a report taken while they run may be a few
+    // samples out of step between fields.
+    class Histogram {
+        static constexpr int BUCKETS = 65;
+        std::array<std::atomic<std::uint64_t>, BUCKETS> buckets{};
+        std::atomic<std::uint64_t> samples{0};
+        std::atomic<std::uint64_t> totalNs{0};
+        std::atomic<std::uint64_t> maxNs{0};
+        std::atomic<std::uint64_t> allocations{0};
+
+    public:
+        void record(std::uint64_t ns, std::uint64_t allocs);
+        void clear();
+
+        std::uint64_t count() const { return samples.load(std::memory_order_relaxed); }
+        std::uint64_t max() const { return maxNs.load(std::memory_order_relaxed); }
+        std::uint64_t mean() const {
+            std::uint64_t n = count();
+            return n ? totalNs.load(std::memory_order_relaxed) / n : 0;
+        }
+        std::uint64_t allocationCount() const { return allocations.load(std::memory_order_relaxed); }
+
+        // Upper bound of the bucket holding the p-th fraction of samples
+        std::uint64_t percentile(double p) const;
+    };
+
+    const Histogram& histogram(Phase phase);
+    std::uint64_t counterValue(Counter counter);
+    const char* phaseName(Phase phase);
+
+    void recordPhase(Phase phase, std::uint64_t ns, std::uint64_t allocs);
+    void addCount(Counter counter, std::uint64_t n);
+
+    // Called from the global operator new replacement in instrumented builds
+    void recordAllocation();
+
+    // Allocations made by the calling thread, so a timer is not charged
+    // for other threads' allocations
+    std::uint64_t threadAllocationCount();
+
+    void reset();
+    void printStats(std::ostream& out);
+
+    // One finished span, stored as a Chrome trace complete ("X") event so
+    // overwriting old entries never leaves an unmatched begin or end
+    struct TraceEvent {
+        Phase phase;
+        std::string_view detail;    // Must outlive the trace (e.g. a command name)
+        std::uint64_t startNs;      // Since startTrace()
+        std::uint64_t durationNs;
+    };
+
+    // Fixed-size ring of events owned by one thread. Only that thread writes;
+    // the published count lets writeTrace() read it without locking.
+    class TraceBuffer {
+        std::vector<TraceEvent> events;
+        std::atomic<std::uint64_t> written;
+        int threadIndex;
+
+    public:
+        static constexpr std::size_t CAPACITY = 1 << 16;
+
+        explicit TraceBuffer(int index) : events(CAPACITY), written(0), threadIndex(index) {}
+
+        void push(const TraceEvent& event) {
+            std::uint64_t n = written.load(std::memory_order_relaxed);
+            events[n % CAPACITY] = event;
+            written.store(n + 1, std::memory_order_release);
+        }
+
+        int getThreadIndex() const { return threadIndex; }
+        std::uint64_t size() const { return written.load(std::memory_order_acquire); }
+        const TraceEvent& at(std::uint64_t i) const { return events[i % CAPACITY]; }
+    };
+
+    inline bool tracingActive = false;
+
+    void startTrace();
+    void recordTraceEvent(Phase phase, std::string_view detail,
+                          std::chrono::steady_clock::time_point start, std::uint64_t durationNs);
+
+    // Stops tracing and writes every buffered event as Chrome trace JSON
+    bool writeTrace(const std::string& filename);
+
+    inline void count(Counter counter, std::uint64_t n = 1) {
+        if constexpr (ENABLED) addCount(counter, n);
+    }
+
+    // Times its enclosing scope into the phase's histogram and, while
+    // tracing, records it as a trace span
+    class ScopedTimer {
+        Phase phase;
+        std::string_view detail;
+        bool traced;
+        std::chrono::steady_clock::time_point start;
+        std::uint64_t allocStart;
+
+    public:
+        explicit ScopedTimer(Phase p, std::string_view d = {})
+            : phase(p), detail(d), traced(tracingActive), start(), allocStart(0) {
+            if (!ENABLED && !traced) return;
+            if constexpr (ENABLED) allocStart = threadAllocationCount();
+            start = std::chrono::steady_clock::now();
+        }
+
+        ~ScopedTimer() {
+            if (!ENABLED && !traced) return;
+            auto elapsed = std::chrono::steady_clock::now() - start;
+            std::uint64_t ns = std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count();
+            if constexpr (ENABLED) {
+                recordPhase(phase, ns, threadAllocationCount() - allocStart);
+            }
+            if (traced) recordTraceEvent(phase, detail, start, ns);
+        }
+
+        // Label the span once it is known (e.g. the matched command name)
+        void setDetail(std::string_view d) { detail = d; }
+
+        ScopedTimer(const ScopedTimer&) = delete;
+        ScopedTimer& operator=(const ScopedTimer&) = delete;
+    };
+}
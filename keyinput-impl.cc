@@ -0,0 +1,118 @@
+module;
+#include <poll.h>
+#include <cerrno>
+module keyinput;
+import <array>;
+import <cctype>;
+import <chrono>;
+import <string>;
+import <string_view>;
+import <utility>;
+import <vector>;
+import command;
+import instrument;
+import constants;
+
+using namespace GameConstants;
+
+namespace {
+    constexpr int FORCE_KEY = 'f';
+    constexpr unsigned char CTRL_C = 3;
+    constexpr unsigned char CTRL_D = 4;
+    constexpr unsigned char ESCAPE = 27;
+}
+
+KeyBindings::KeyBindings(CommandInterpreter& interp) : interpreter(interp) {
+    auto bind = [this](int key, std::string_view command, CommandArgs args = {}) {
+        keys[key] = {interpreter.resolve(command), std::move(args)};
+    };
+
+    bind(KEY_LEFT, "left");
+    bind(KEY_RIGHT, "right");
+    bind(KEY_DOWN, "down");
+    bind(KEY_UP, "clockwise");
+    bind('a', "left");
+    bind('d', "right");
+    bind('s', "down");
+    bind('w', "clockwise");
+    bind('x', "clockwise");
+    bind('z', "counterclockwise");
+    bind(' ', "drop");
+    bind('b', "blind");
+    bind('h', "heavy");
+    for (char player = '1'; player <= '9'; ++player) bind(player, "target", {std::string(1, player)});
+
+    ResolvedCommand force = interpreter.resolve("force");
+    for (char block : {I_BLOCK, J_BLOCK, L_BLOCK, O_BLOCK, S_BLOCK, Z_BLOCK, T_BLOCK}) {
+        forceKeys[block] = {force, {std::string(1, block)}};
+        forceKeys[std::tolower(block)] = forceKeys[block];
+    }
+}
+
+std::string_view KeyBindings::press(int key) {
+    if (key < 0 || key >= KEY_CODE_COUNT) return {};
+
+    const Binding* binding = &keys[key];
+    if (forcePending) {
+        // Any key that is not a block cancels the force
+        forcePending = false;
+        if (key >= static_cast<int>(forceKeys.size())) return {};
+        binding = &forceKeys[key];
+    } else if (key == FORCE_KEY) {
+        forcePending = true;
+        return {};
+    } else if (key == 'q' || key == CTRL_C || key == CTRL_D) {
+        quit = true;
+        return {};
+    }
+    if (!binding->command.command) return {};
+
+    Instrument::ScopedTimer timer(Instrument::Phase::Command, binding->command.name);
+    Instrument::count(Instrument::Counter::Commands);
+    interpreter.execute(binding->command, binding->args);
+    return binding->command.name;
+}
+
+bool KeyBindings::quitRequested() const { return quit; }
+
+int TerminalKeys::decode(unsigned char byte) {
+    if (escape == 1) {
+        escape = byte == '[' ? 2 : 0;
+        if (escape) return -1;
+    } else if (escape == 2) {
+        if (std::isdigit(byte) || byte == ';') return -1;   // Modifiers
+        escape = 0;
+        switch (byte) {
+            case 'A': return KEY_UP;
+            case 'B': return KEY_DOWN;
+            case 'C': return KEY_RIGHT;
+            case 'D': return KEY_LEFT;
+            default: return -1;
+        }
+    }
+
+    if (byte == ESCAPE) {
+        escape = 1;
+        return -1;
+    }
+    return byte;
+}
+
+bool waitForInput(int fd, const std::vector<int>& windowFds, std::chrono::nanoseconds timeout) {
+    std::array<pollfd, MAX_PLAYERS + 1> fds;
+    nfds_t count = 0;
+    fds[count++] = {fd, POLLIN, 0};
+    for (int windowFd : windowFds) {
+        if (count < fds.size()) fds[count++] = {windowFd, POLLIN, 0};
+    }
+
+    timespec limit{};
+    if (timeout.count() >= 0) {
+        limit.tv_sec = static_cast<time_t>(timeout.count() / 1'000'000'000);
+        limit.tv_nsec = static_cast<long>(timeout.count() % 1'000'000'000);
+    }
+    int ready = ppoll(fds.data(), count, timeout.count() >= 0 ? &limit : nullptr, nullptr);
+    if (ready < 0 && errno == EINTR) return false;
+    // An error on fd counts as readable, so the caller's read reports it
+    return ready < 0 || (fds[0].revents & (POLLIN | POLLHUP | POLLERR)) != 0;
+}
@@ -0,0 +1,51 @@
+export module keyinput;
+import <array>;
+import <chrono>;
+import <string_view>;
+import <vector>;
+import command;
+import constants;
+
+// Prompt line listing the bindings, for games played from the keyboard
+export constexpr std::string_view KEY_HELP =
+    "Keys: arrows or a/s/d move, w/x rotate, z counter, space drop, "
+    "b/h/f<block> special, 1-9 target, q quit";
+
+// Keyboard play. Every key is bound to a command looked up once, so a key
+// press runs it straight away instead of going through token parsing and
+// prefix matching. Shared by graphics window keys and the real-time mode.
+export class KeyBindings {
+    struct Binding {
+        ResolvedCommand command;
+        CommandArgs args;
+    };
+
+    CommandInterpreter& interpreter;
+    std::array<Binding, GameConstants::KEY_CODE_COUNT> keys;
+    std::array<Binding, 128> forceKeys;     // The block picked by the key after 'f'
+    bool forcePending = false;
+    bool quit = false;
+
+public:
+    explicit KeyBindings(CommandInterpreter& interp);
+
+    // Run the key's command; returns its name, or empty if the key ran none
+    std::string_view press(int key);
+
+    bool quitRequested() const;
+};
+
+// Turns terminal bytes into key codes, decoding the ESC [ A-D arrow sequences
+export class TerminalKeys {
+    int escape = 0;     // Bytes of an arrow sequence seen so far
+
+public:
+    // The key this byte completes, or -1 if none
+    int decode(unsigned char byte);
+};
+
+// Wait until fd has input or one of the windows has events, for at most
+// timeout (forever if negative). Returns true if fd is readable. Drain the
+// windows with Game::processWindowEvents first: events Xlib has already
+// read off a connection do not wake the wait.
+export bool waitForInput(int fd, const std::vector<int>& windowFds, std::chrono::nanoseconds timeout);
@@ -1,17 +1,56 @@
 module level;
+import <array>;
+import <bit>;
+import <cstdint>;
+import <map>;
 import <memory>;
+import <mutex>;
 import <random>;
 import <fstream>;
 import <vector>;
 import <string>;
+import <type_traits>;
 import block;
 import blocks;
 import constants;
+import serial;
 
 using namespace GameConstants;
 
+BlockSequence readBlockSequence(const std::string& filename) {
+    std::ifstream file(filename);
+    auto sequence = std::make_shared<std::vector<char>>();
+
+    char blockType;
+    while (file >> blockType) {
+        sequence->push_back(blockType);
+    }
+    return sequence;
+}
+
+BlockSequence SequenceCache::get(const std::string& filename) {
+    std::lock_guard<std::mutex> lock(mutex);
+    BlockSequence& sequence = sequences[filename];
+    if (!sequence) sequence = readBlockSequence(filename);
+    return sequence;
+}
+
+std::unique_ptr<Block> makeBlock(char type, int levelNumber, int blockId) {
+    switch (type) {
+        case 'I': return std::make_unique<IBlock>(levelNumber, blockId);
+        case 'J': return std::make_unique<JBlock>(levelNumber, blockId);
+        case 'L': return std::make_unique<LBlock>(levelNumber, blockId);
+        case 'O': return std::make_unique<OBlock>(levelNumber, blockId);
+        case 'S': return std::make_unique<SBlock>(levelNumber, blockId);
+        case 'Z': return std::make_unique<ZBlock>(levelNumber, blockId);
+        case 'T': return std::make_unique<TBlock>(levelNumber, blockId);
+        default: return std::make_unique<IBlock>(levelNumber, blockId);
+    }
+}
+
 // Level base class implementations
-Level::Level(int num) : levelNumber(num), randomMode(true), nonRandomIndex(0) {}
+Level::Level(int num)
+    : levelNumber(num), randomMode(true), nonRandomIndex(0), sequenceCache(nullptr), engine(nullptr) {}
 
 int Level::getLevelNumber() const { return levelNumber; }
 
@@ -29,43 +68,89 @@ void Level::setNonRandom(const std::string& filename) {
     loadNonRandomSequence();
 }
 
+void Level::setSequenceCache(SequenceCache* cache) {
+    sequenceCache = cache;
+}
+
 void Level::loadNonRandomSequence() {
-    std::ifstream file(nonRandomFile);
-    nonRandomSequence.clear();
+    nonRandomSequence = sequenceCache ? sequenceCache->get(nonRandomFile) : readBlockSequence(nonRandomFile);
     nonRandomIndex = 0;
-
-    char blockType;
-    while (file >> blockType) {
-        nonRandomSequence.push_back(blockType);
-    }
 }
 
 char Level::getNextNonRandomBlock() {
-    if (nonRandomSequence.empty()) {
+    if (!nonRandomSequence || nonRandomSequence->empty()) {
         nonRandomIndex = 0;
         return 'I';  // Default fallback
     }
-    char block = nonRandomSequence[nonRandomIndex];
-    nonRandomIndex = (nonRandomIndex + 1) % nonRandomSequence.size();
+    char block = (*nonRandomSequence)[nonRandomIndex];
+    nonRandomIndex = (nonRandomIndex + 1) % nonRandomSequence->size();
     return block;
 }
 
 std::unique_ptr<Block> Level::createBlockFromType(char type, int blockId) {
-    switch (type) {
-        case 'I': return std::make_unique<IBlock>(levelNumber, blockId);
-        case 'J': return std::make_unique<JBlock>(levelNumber, blockId);
-        case 'L': return std::make_unique<LBlock>(levelNumber, blockId);
-        case 'O': return std::make_unique<OBlock>(levelNumber, blockId);
-        case 'S': return std::make_unique<SBlock>(levelNumber, blockId);
-        case 'Z': return std::make_unique<ZBlock>(levelNumber, blockId);
-        case 'T': return std::make_unique<TBlock>(levelNumber, blockId);
-        default: return std::make_unique<IBlock>(levelNumber, blockId);
+    return makeBlock(type, levelNumber, blockId);
+}
+
+// The engine is stored as its object representation: it is trivially
+// copyable, and a few kilobytes of memcpy beats the text stream operators.
+// Save files record sizeof(std::mt19937) so another library's layout is refused.
+static_assert(std::is_trivially_copyable_v<std::mt19937>);
+
+void Level::save(ByteWriter& out) const {
+    out.u8(static_cast<std::uint8_t>(levelNumber));
+    out.u8(randomMode);
+    out.str(nonRandomFile);
+    out.u32(static_cast<std::uint32_t>(nonRandomIndex));
+    if (engine) out.bytes(engine, sizeof(*engine));
+}
+
+std::unique_ptr<Level> Level::load(ByteReader& in, SequenceCache* cache, const Level* previous) {
+    int number = in.u8();
+    bool random = in.u8() != 0;
+    std::string file = in.str();
+    std::uint32_t index = in.u32();
+
+    // Constructing from the saved state skips seeding a generator only to overwrite it
+    std::array<unsigned char, sizeof(std::mt19937)> state{};
+    if (number >= 1) in.bytes(state.data(), state.size());
+    std::unique_ptr<Level> level;
+    switch (number) {
+        case 0: level = std::make_unique<Level0>(std::string(), cache); break;
+        case 1: level = std::make_unique<Level1>(std::bit_cast<std::mt19937>(state)); break;
+        case 2: level = std::make_unique<Level2>(std::bit_cast<std::mt19937>(state)); break;
+        case 3: level = std::make_unique<Level3>(std::bit_cast<std::mt19937>(state)); break;
+        case 4: level = std::make_unique<Level4>(std::bit_cast<std::mt19937>(state)); break;
+        default: in.fail(); break;
+    }
+    if (!in.ok()) return nullptr;
+
+    level->sequenceCache = cache;
+    level->randomMode = random;
+    level->nonRandomFile = std::move(file);
+
+    if (!level->nonRandomFile.empty()) {
+        if (previous && previous->nonRandomFile == level->nonRandomFile) {
+            level->nonRandomSequence = previous->nonRandomSequence;
+        } else {
+            level->loadNonRandomSequence();
+        }
+    }
+
+    // The index must point into the sequence (which may have changed on disk)
+    std::size_t length = level->nonRandomSequence ? level->nonRandomSequence->size() : 0;
+    if (index != 0 && index >= length) {
+        in.fail();
+        return nullptr;
     }
+    level->nonRandomIndex = static_cast<int>(index);
+    return level;
 }
 
 // Level0 implementations
-Level0::Level0(const std::string& filename) : Level(0) {
-    setNonRandom(filename);
+Level0::Level0(const std::string& filename, SequenceCache* cache) : Level(0) {
+    sequenceCache = cache;
+    randomMode = false;
+    if (!filename.empty()) setNonRandom(filename);
 }
 
 std::unique_ptr<Block> Level0::generateBlock(int blockId) {
@@ -76,7 +161,9 @@ std::unique_ptr<Block> Level0::generateBlock(int blockId) {
 bool Level0::isHeavy() const { return false; }
 
 // Level1 implementations
-Level1::Level1(unsigned int seed) : Level(1), rng(seed), dist(0, 11) {}
+Level1::Level1(unsigned int seed) : Level(1), rng(seed), dist(0, 11) { engine = &rng; }
+
+Level1::Level1(const std::mt19937& state) : Level(1), rng(state), dist(0, 11) { engine = &rng; }
 
 std::unique_ptr<Block> Level1::generateBlock(int blockId) {
     if (!randomMode) {
@@ -102,7 +189,9 @@ std::unique_ptr<Block> Level1::generateBlock(int blockId) {
 bool Level1::isHeavy() const { return false; }
 
 // Level2 implementations
-Level2::Level2(unsigned int seed) : Level(2), rng(seed), dist(0, 6) {}
+Level2::Level2(unsigned int seed) : Level(2), rng(seed), dist(0, 6) { engine = &rng; }
+
+Level2::Level2(const std::mt19937& state) : Level(2), rng(state), dist(0, 6) { engine = &rng; }
 
 std::unique_ptr<Block> Level2::generateBlock(int blockId) {
     if (!randomMode) {
@@ -130,7 +219,9 @@ std::unique_ptr<Block> Level2::generateBlock(int blockId) {
 bool Level2::isHeavy() const { return false; }
 
 // Level3 implementations
-Level3::Level3(unsigned int seed) : Level(3), rng(seed), dist(0, 8) {}
+Level3::Level3(unsigned int seed) : Level(3), rng(seed), dist(0, 8) { engine = &rng; }
+
+Level3::Level3(const std::mt19937& state) : Level(3), rng(state), dist(0, 8) { engine = &rng; }
 
 std::unique_ptr<Block> Level3::generateBlock(int blockId) {
     if (!randomMode) {
@@ -157,7 +248,9 @@ bool Level3::isHeavy() const { return true; }
 
 // Level4 implementations
 Level4::Level4(unsigned int seed)
-    : Level(4), rng(seed), dist(0, 8) {}
+    : Level(4), rng(seed), dist(0, 8) { engine = &rng; }
+
+Level4::Level4(const std::mt19937& state) : Level(4), rng(state), dist(0, 8) { engine = &rng; }
 
 std::unique_ptr<Block> Level4::generateBlock(int blockId) {
     if (!randomMode) {
@@ -1,21 +1,46 @@
 export module level;
+import <map>;
 import <memory>;
+import <mutex>;
 import <random>;
 import <string>;
 import <vector>;
 import block;
 import constants;
+import serial;
 
 using namespace GameConstants;
 
+// Block types read from a sequence file; shared read-only between levels
+export using BlockSequence = std::shared_ptr<const std::vector<char>>;
+
+// Read a sequence file (empty if it cannot be opened)
+export BlockSequence readBlockSequence(const std::string& filename);
+
+// Sequence files loaded once and shared by every level that asks for them,
+// so many games in one process neither re-read nor duplicate them. Safe to
+// use from several threads.
+export class SequenceCache {
+    std::mutex mutex;
+    std::map<std::string, BlockSequence> sequences;
+
+public:
+    BlockSequence get(const std::string& filename);
+};
+
+// Create a block of the given type ('I' for unknown types)
+export std::unique_ptr<Block> makeBlock(char type, int levelNumber, int blockId);
+
 // Abstract Level class
 export class Level {
 protected:
     int levelNumber;
     bool randomMode;
     std::string nonRandomFile;
-    std::vector<char> nonRandomSequence;
+    BlockSequence nonRandomSequence;
     int nonRandomIndex;
+    SequenceCache* sequenceCache;   // Null reads the file on every load
+    std::mt19937* engine;           // The random levels' generator, saved with the level
 
 public:
     // Constructor
@@ -35,6 +60,7 @@ public:
     // Set random or non-random mode
     void setRandom(bool random);
     void setNonRandom(const std::string& filename);
+    void setSequenceCache(SequenceCache* cache);
 
     // Load non-random sequence from file
     void loadNonRandomSequence();
@@ -44,12 +70,19 @@ public:
 
     // Factory method to create block from type
     std::unique_ptr<Block> createBlockFromType(char type, int blockId);
+
+    // Save file state: level number, mode, sequence file and position, and
+    // the generator state. Loading takes the sequence from `previous` when
+    // it used the same file, so restoring a checkpoint reads no files.
+    // Returns null (and fails the reader) on invalid input.
+    void save(ByteWriter& out) const;
+    static std::unique_ptr<Level> load(ByteReader& in, SequenceCache* cache, const Level* previous);
 };
 
 // Level 0: Reads from sequence file (non-random only)
 export class Level0 : public Level {
 public:
-    Level0(const std::string& filename);
+    Level0(const std::string& filename, SequenceCache* cache = nullptr);
     std::unique_ptr<Block> generateBlock(int blockId) override;
     bool isHeavy() const override;
 };
@@ -61,6 +94,7 @@ export class Level1 : public Level {
 
 public:
     Level1(unsigned int seed = std::random_device{}());
+    explicit Level1(const std::mt19937& state);    // Resume a saved generator
     std::unique_ptr<Block> generateBlock(int blockId) override;
     bool isHeavy() const override;
 };
@@ -72,6 +106,7 @@ export class Level2 : public Level {
 
 public:
     Level2(unsigned int seed = std::random_device{}());
+    explicit Level2(const std::mt19937& state);    // Resume a saved generator
     std::unique_ptr<Block> generateBlock(int blockId) override;
     bool isHeavy() const override;
 };
@@ -83,6 +118,7 @@ export class Level3 : public Level {
 
 public:
     Level3(unsigned int seed = std::random_device{}());
+    explicit Level3(const std::mt19937& state);    // Resume a saved generator
     std::unique_ptr<Block> generateBlock(int blockId) override;
     bool isHeavy() const override;
 };
@@ -94,6 +130,7 @@ export class Level4 : public Level {
 
 public:
     Level4(unsigned int seed = std::random_device{}());
+    explicit Level4(const std::mt19937& state);    // Resume a saved generator
     std::unique_ptr<Block> generateBlock(int blockId) override;
     bool isHeavy() const override;
     std::unique_ptr<Block> createCenterBlock(int blockId) override;
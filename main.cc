@@ -1,19 +1,85 @@
+import <algorithm>;
 import <iostream>;
 import <string>;
 import <cstdlib>;
 import <chrono>;
+import <string_view>;
+import <new>;
+import <cstdint>;
+import <memory>;
+import <vector>;
+import <thread>;
+import <sstream>;
+import <iomanip>;
 import game;
 import command;
+import tokenreader;
+import instrument;
+import aiplayer;
+import search;
+import selfplay;
+import server;
+import matchhost;
+import statsstore;
+import raster;
+import keyinput;
+import realtime;
+import constants;
 
 using namespace std;
 
+// Every heap block is reported to the match host, which holds hosted matches
+// to their memory budgets; instrumented builds also count allocations
+void* operator new(size_t size) {
+    if constexpr (Instrument::ENABLED) Instrument::recordAllocation();
+    void* p = malloc(size ? size : 1);
+    if (!p) throw bad_alloc();
+    HostMemory::allocated(p);
+    return p;
+}
+
+[[gnu::noinline]] void operator delete(void* p) noexcept {
+    HostMemory::freed(p);
+    free(p);
+}
+
+[[gnu::noinline]] void operator delete(void* p, size_t) noexcept {
+    HostMemory::freed(p);
+    free(p);
+}
+
 int main(int argc, char* argv[]) {
+    // Input is read through TokenReader, so iostreams need not stay synced with stdio
+    ios::sync_with_stdio(false);
+
     // Default settings
     bool textOnly = false;
     unsigned int seed = std::chrono::system_clock::now().time_since_epoch().count();
     string scriptFile1 = "biquadris_sequence1.txt";
     string scriptFile2 = "biquadris_sequence2.txt";
     int startLevel = 0;
+    bool printStats = false;
+    string traceFile;
+    int players = GameConstants::NUM_PLAYERS;
+    vector<bool> botSeat(GameConstants::MAX_PLAYERS, false);
+    SearchConfig searchConfig;
+    searchConfig.threads = static_cast<int>(thread::hardware_concurrency()) - 1;
+    int aiTimeMs = 0;
+    string selfPlayFile;
+    uint64_t selfPlayPositions = 10000;
+    int serverPort = -1;
+    int spectatorPort = -1;
+    int hostMatches = 0;
+    int hostThreads = static_cast<int>(thread::hardware_concurrency());
+    uint64_t hostTurns = 1000;
+    string recordPath;
+    int leaderboardSize = 0;
+    bool realtime = false;
+    bool offscreen = false;
+    string framePrefix;
+    ImageFormat frameFormat = ImageFormat::Png;
+    int frameScale = 1;
+    const GameConstants::BoardGeometry* geometry = &GameConstants::CLASSIC_BOARD;
 
     // Parse command-line arguments
     for (int i = 1; i < argc; ++i) {
@@ -31,24 +97,346 @@ int main(int argc, char* argv[]) {
             startLevel = stoi(argv[++i]);
             if (startLevel < 0) startLevel = 0;
             if (startLevel > 4) startLevel = 4;
+        } else if (arg == "-stats") {
+            printStats = true;
+        } else if (arg == "-trace" && i + 1 < argc) {
+            traceFile = argv[++i];
+        } else if (arg.size() > 3 && arg.compare(0, 3, "-ai") == 0 &&
+                   all_of(arg.begin() + 3, arg.end(), [](char c) { return c >= '0' && c <= '9'; })) {
+            // -ai1, -ai2, ... hand that seat to a bot
+            int seat = arg.size() < 6 ? stoi(arg.substr(3)) : 0;
+            if (seat >= 1 && seat <= GameConstants::MAX_PLAYERS) botSeat[seat - 1] = true;
+        } else if (arg == "-players" && i + 1 < argc) {
+            players = clamp(stoi(argv[++i]), GameConstants::NUM_PLAYERS, GameConstants::MAX_PLAYERS);
+        } else if (arg == "-aitime" && i + 1 < argc) {
+            aiTimeMs = stoi(argv[++i]);
+        } else if (arg == "-aithreads" && i + 1 < argc) {
+            searchConfig.threads = stoi(argv[++i]);
+        } else if (arg == "-selfplay" && i + 1 < argc) {
+            selfPlayFile = argv[++i];
+        } else if (arg == "-positions" && i + 1 < argc) {
+            selfPlayPositions = stoull(argv[++i]);
+        } else if (arg == "-server" && i + 1 < argc) {
+            serverPort = stoi(argv[++i]);
+        } else if (arg == "-spectate" && i + 1 < argc) {
+            spectatorPort = stoi(argv[++i]);
+        } else if (arg == "-host" && i + 1 < argc) {
+            hostMatches = stoi(argv[++i]);
+        } else if (arg == "-hostthreads" && i + 1 < argc) {
+            hostThreads = stoi(argv[++i]);
+        } else if (arg == "-turns" && i + 1 < argc) {
+            hostTurns = stoull(argv[++i]);
+        } else if (arg == "-record" && i + 1 < argc) {
+            recordPath = argv[++i];
+        } else if (arg == "-leaderboard" && i + 1 < argc) {
+            leaderboardSize = stoi(argv[++i]);
+        } else if (arg == "-realtime") {
+            realtime = true;
+        } else if (arg == "-offscreen") {
+            offscreen = true;
+        } else if (arg == "-frames" && i + 1 < argc) {
+            framePrefix = argv[++i];
+            offscreen = true;
+        } else if (arg == "-framescale" && i + 1 < argc) {
+            frameScale = max(stoi(argv[++i]), 1);
+        } else if (arg == "-frameformat" && i + 1 < argc) {
+            string format = argv[++i];
+            if (format != "png" && format != "ppm") {
+                cerr << "Error: Unknown frame format " << format << " (png or ppm)\n";
+                return 1;
+            }
+            frameFormat = format == "png" ? ImageFormat::Png : ImageFormat::Ppm;
+        } else if (arg == "-board" && i + 1 < argc) {
+            string name = argv[++i];
+            auto preset = find_if(begin(GameConstants::BOARD_PRESETS), end(GameConstants::BOARD_PRESETS),
+                                  [&name](const GameConstants::BoardGeometry& g) { return name == g.name; });
+            if (preset == end(GameConstants::BOARD_PRESETS)) {
+                cerr << "Error: Unknown board " << name << " (classic, standard or marathon)\n";
+                return 1;
+            }
+            geometry = &*preset;
+        }
+    }
+
+    // Networked, hosted, self-play and recorded matches have two seats
+    if (players != GameConstants::NUM_PLAYERS &&
+        (serverPort >= 0 || hostMatches > 0 || !selfPlayFile.empty() || !recordPath.empty())) {
+        cerr << "Error: -players only applies to local games without -record\n";
+        return 1;
+    }
+
+    // Networked, hosted and self-play matches, and the lookahead search, use the classic board
+    if (*geometry != GameConstants::CLASSIC_BOARD &&
+        (serverPort >= 0 || hostMatches > 0 || !selfPlayFile.empty() || aiTimeMs > 0)) {
+        cerr << "Error: -board " << geometry->name << " only applies to local games without -aitime\n";
+        return 1;
+    }
+
+    // Real-time play reads keys from this terminal
+    if (realtime && (serverPort >= 0 || hostMatches > 0 || !selfPlayFile.empty())) {
+        cerr << "Error: -realtime only applies to local games\n";
+        return 1;
+    }
+
+    // Offscreen graphics replace the X windows of a local game
+    if (offscreen && (textOnly || serverPort >= 0 || hostMatches > 0 || !selfPlayFile.empty())) {
+        cerr << "Error: -offscreen and -frames only apply to local games without -text\n";
+        return 1;
+    }
+    if (!framePrefix.empty() && realtime) {
+        cerr << "Error: -frames does not apply to -realtime\n";
+        return 1;
+    }
+
+    // A turn-based game with a bot in every seat never reads a command, and
+    // restarts itself at game over, so nothing would ever end it
+    if (serverPort < 0 && hostMatches == 0 && selfPlayFile.empty() && !realtime &&
+        all_of(botSeat.begin(), botSeat.begin() + players, [](bool bot) { return bot; })) {
+        cerr << "Error: Every seat is a bot; use -selfplay or -host for bot matches, or -realtime to watch one\n";
+        return 1;
+    }
+
+    // The stats store outlives every game played in this session
+    unique_ptr<StatsStore> stats;
+    if (!recordPath.empty()) {
+        stats = make_unique<StatsStore>(recordPath);
+        if (!stats->open()) return 1;
+    }
+
+    if (leaderboardSize > 0) {
+        if (!stats) {
+            cerr << "Error: -leaderboard needs a store given with -record\n";
+            return 1;
+        }
+        int rank = 0;
+        for (const LeaderboardEntry& entry : stats->leaderboard(leaderboardSize)) {
+            const MatchRecord& match = stats->record(entry.match);
+            cout << ++rank << ". " << entry.score << "  Player " << entry.player + 1
+                 << "  seed " << match.seed << "  level " << static_cast<int>(match.endLevels[entry.player])
+                 << "  lines " << match.linesCleared[entry.player] << "  "
+                 << match.durationMs / 1000.0 << " s\n";
         }
+        return 0;
     }
 
+    // Server mode hosts networked matches instead of a local game
+    if (serverPort >= 0) {
+        ServerConfig config;
+        config.port = serverPort;
+        config.spectatorPort = spectatorPort;
+        config.seed = seed;
+        config.startLevel = startLevel;
+        config.scriptFile1 = scriptFile1;
+        config.scriptFile2 = scriptFile2;
+
+        MatchServer server(config);
+        if (!server.start()) return 1;
+        cout << "Serving matches on port " << server.getPort();
+        if (spectatorPort >= 0) cout << ", spectators on port " << server.getSpectatorPort();
+        cout << endl;
+        server.run();
+        return 0;
+    }
+
+    // Host mode plays many bot matches side by side in this process
+    if (hostMatches > 0) {
+        auto start = chrono::steady_clock::now();
+        vector<MatchResult> results;
+        {
+            MatchHost host(hostThreads);
+            for (int i = 0; i < hostMatches; ++i) {
+                MatchSpec spec;
+                spec.seed = seed + 2 * i;
+                spec.startLevel = startLevel;
+                spec.scriptFile1 = scriptFile1;
+                spec.scriptFile2 = scriptFile2;
+                spec.turnLimit = hostTurns;
+                host.add(spec);
+            }
+            host.waitAll();
+            results = host.takeResults();
+        }
+        chrono::duration<double> elapsed = chrono::steady_clock::now() - start;
+
+        uint64_t turns = 0, games = 0;
+        int64_t peakMemory = 0;
+        int overBudget = 0;
+        for (const MatchResult& result : results) {
+            turns += result.turns;
+            games += result.games;
+            peakMemory = max(peakMemory, result.peakMemory);
+            if (result.status == MatchStatus::OverBudget) ++overBudget;
+        }
+        cout << "Hosted " << results.size() << " matches (" << turns << " turns, " << games
+             << " finished games) in " << elapsed.count() << " s\n"
+             << "Peak match memory " << peakMemory << " bytes, " << overBudget << " over budget\n";
+
+        // Every worker has stopped, so the totals cover all of them
+        if (printStats) Instrument::printStats(cout);
+        return 0;
+    }
+
+    // Self-play is bots on both seats with no display
+    if (!selfPlayFile.empty()) {
+        textOnly = true;
+        botSeat[GameConstants::PLAYER_ONE] = botSeat[GameConstants::PLAYER_TWO] = true;
+    }
+
+    if (!traceFile.empty()) Instrument::startTrace();
+
     // Create game
-    Game game(seed, startLevel, scriptFile1, scriptFile2, textOnly);
+    Game game(seed, startLevel, scriptFile1, scriptFile2, textOnly, nullptr, *geometry, players, offscreen);
+
+    if (stats) {
+        for (int player : {GameConstants::PLAYER_ONE, GameConstants::PLAYER_TWO}) {
+            const SeatTotals& totals = stats->totals(player);
+            game.getScore(player)->restore(totals.highScore, static_cast<int>(totals.wins));
+        }
+        game.setGameOverHandler([&stats](const GameSummary& summary) {
+            MatchRecord record{};
+            record.timestamp = chrono::duration_cast<chrono::seconds>(
+                chrono::system_clock::now().time_since_epoch()).count();
+            record.seed = summary.seed;
+            record.durationMs = static_cast<uint32_t>(summary.duration.count());
+            record.startLevel = static_cast<uint8_t>(summary.startLevel);
+            record.winner = static_cast<uint8_t>(summary.winner);
+            for (int player = 0; player < 2; ++player) {
+                record.scores[player] = summary.scores[player];
+                record.linesCleared[player] = summary.linesCleared[player];
+                record.blocksDropped[player] = summary.blocksDropped[player];
+                record.endLevels[player] = static_cast<uint8_t>(summary.levels[player]);
+            }
+            stats->append(record);     // Prints the reason on failure
+        });
+    }
 
     // Create command interpreter
     CommandInterpreter interpreter(&game);
 
+    // Bot seats play through the same interpreter as typed commands
+    vector<unique_ptr<AIPlayer>> bots;
+    for (int player = 0; player < game.getPlayerCount(); ++player) {
+        if (botSeat[player]) bots.push_back(make_unique<AIPlayer>(&game, &interpreter, player));
+    }
+
+    // -aitime turns on lookahead; bots move one at a time, so they share a searcher
+    LinearEvaluator evaluator;
+    unique_ptr<Searcher> searcher;
+    if (aiTimeMs > 0 && !bots.empty()) {
+        searchConfig.budget = chrono::milliseconds(aiTimeMs);
+        searcher = make_unique<Searcher>(evaluator, searchConfig);
+        for (auto& bot : bots) {
+            bot->setPlanner([&searcher](const Board& board) { return searcher->search(board).placement; });
+        }
+    }
+
+    if (!selfPlayFile.empty()) {
+        SelfPlayWriter writer(selfPlayFile);
+        if (!writer.isOpen()) {
+            cerr << "Error: Could not open self-play file: " << selfPlayFile << "\n";
+            return 1;
+        }
+
+        game.setHeadless(true);
+        TokenReader input(STDIN_FD);    // Bots never read it
+        SelfPlayStats stats = runSelfPlay(game, *bots[0], *bots[1], input, writer, selfPlayPositions);
+        if (!writer.close()) {
+            cerr << "Error: Could not write self-play file: " << selfPlayFile << "\n";
+            return 1;
+        }
+        cout << "Wrote " << stats.decisions << " positions from " << stats.games
+             << " finished games to " << selfPlayFile << "\n";
+
+        if (printStats) Instrument::printStats(cout);
+        if (!traceFile.empty() && !Instrument::writeTrace(traceFile)) {
+            cerr << "Error: Could not write trace file: " << traceFile << "\n";
+        }
+        return 0;
+    }
+
+    if (realtime) {
+        game.setPrompt(KEY_HELP);
+        RealtimeLoop loop(game, interpreter, bots);
+        {
+            RawTerminal terminal(STDIN_FD);
+            game.render();
+            loop.run(STDIN_FD);
+        }
+        cout << "\n";
+
+        if (printStats) {
+            loop.printStats(cout);
+            Instrument::printStats(cout);
+        }
+        if (!traceFile.empty() && !Instrument::writeTrace(traceFile)) {
+            cerr << "Error: Could not write trace file: " << traceFile << "\n";
+        }
+        return 0;
+    }
+
+    // -frames writes every player's window after the initial render and each command
+    uint64_t frameNumber = 0;
+    auto saveFrames = [&]() {
+        if (framePrefix.empty()) return true;
+        for (int player = 0; player < game.getPlayerCount(); ++player) {
+            ostringstream name;
+            name << framePrefix << "p" << player + 1 << "-" << setw(6) << setfill('0') << frameNumber
+                 << (frameFormat == ImageFormat::Png ? ".png" : ".ppm");
+            if (!game.saveFrame(player, name.str(), frameFormat, frameScale)) return false;
+        }
+        ++frameNumber;
+        return true;
+    };
+
     // Initial render
     game.render();
+    if (!saveFrames()) return 1;
+
+    // Keys pressed in a graphics window run their bound commands directly
+    KeyBindings bindings(interpreter);
+    vector<int> windowFds;
+    vector<int> pressed;
+    game.getWindowFds(windowFds);
 
     // Main game loop
-    string input;
+    TokenReader input(STDIN_FD);
+    string_view token;
     cout << "> ";
-    while (game.isGameRunning() && cin >> input) {
-        // Execute command
-        interpreter.executeCommand(input);
+    while (game.isGameRunning()) {
+        AIPlayer* bot = nullptr;
+        for (auto& b : bots) {
+            if (b->shouldAct()) bot = b.get();
+        }
+
+        if (bot) {
+            bot->takeTurn(input);
+        } else {
+            // Flush prompts only when the next read would block, then wait
+            // for a typed command or a key in a window
+            if (!input.ready()) {
+                cout.flush();
+                if (!windowFds.empty()) {
+                    game.processWindowEvents(pressed);
+                    while (pressed.empty() && !waitForInput(STDIN_FD, windowFds, chrono::nanoseconds(-1))) {
+                        game.processWindowEvents(pressed);
+                    }
+                }
+            }
+
+            if (!pressed.empty()) {
+                for (int key : pressed) {
+                    if (!bindings.quitRequested()) bindings.press(key);
+                }
+                pressed.clear();
+                if (bindings.quitRequested()) break;
+            } else {
+                if (!input.next(token)) break;
+
+                // Execute command
+                interpreter.executeCommand(token, input);
+            }
+        }
+        if (!saveFrames()) return 1;
 
         // Check if game ended
         if (!game.isGameRunning()) {
@@ -58,5 +446,10 @@ int main(int argc, char* argv[]) {
         cout << "> ";
     }
 
+    if (printStats) Instrument::printStats(cout);
+    if (!traceFile.empty() && !Instrument::writeTrace(traceFile)) {
+        cerr << "Error: Could not write trace file: " << traceFile << "\n";
+    }
+
     return 0;
 }
@@ -0,0 +1,311 @@
+module;
+#include <malloc.h>
+module matchhost;
+import <algorithm>;
+import <array>;
+import <condition_variable>;
+import <cstdint>;
+import <deque>;
+import <map>;
+import <memory>;
+import <mutex>;
+import <string>;
+import <string_view>;
+import <thread>;
+import <utility>;
+import <vector>;
+import board;
+import level;
+import scorekeeper;
+import game;
+import command;
+import tokenreader;
+import aiplayer;
+import constants;
+
+using namespace GameConstants;
+
+namespace HostMemory {
+    namespace {
+        thread_local Account* active = nullptr;
+    }
+
+    Scope::Scope(Account& account) : previous(active) { active = &account; }
+
+    Scope::~Scope() { active = previous; }
+
+    void allocated(void* p) {
+        if (!active) return;
+        active->used += static_cast<std::int64_t>(malloc_usable_size(p));
+        active->peak = std::max(active->peak, active->used);
+    }
+
+    void freed(void* p) {
+        if (active && p) active->used -= static_cast<std::int64_t>(malloc_usable_size(p));
+    }
+}
+
+namespace {
+    // Interpreter diagnostics go to std::cout, which is not synchronised
+    std::mutex consoleMutex;
+}
+
+struct MatchHost::Worker {
+    std::thread thread;
+    std::size_t load = 0;           // Live matches; guarded by the host mutex
+
+    // Handed over by other threads
+    std::mutex mutex;
+    std::condition_variable wake;
+    struct Post {
+        int id;
+        std::string line;
+        bool close;
+    };
+    std::vector<std::pair<int, MatchSpec>> arrivals;
+    std::vector<Post> posts;
+    bool stopping = false;
+
+    // Owned by the worker thread
+    std::vector<std::unique_ptr<Match>> matches;
+};
+
+struct MatchHost::Match {
+    int id;
+    MatchSpec spec;
+    HostMemory::Account memory;     // Outlives the session, which is freed into it
+
+    struct Session {
+        Game game;
+        CommandInterpreter interpreter;
+        TokenReader input;          // Arguments for bot commands; always empty
+        std::array<std::unique_ptr<AIPlayer>, 2> bots;
+
+        Session(const MatchSpec& spec, SequenceCache& sequences)
+            : game(spec.seed, spec.startLevel, spec.scriptFile1, spec.scriptFile2, true, &sequences),
+              interpreter(&game), input(-1, 1) {
+            game.setHeadless(true);
+            for (int player = 0; player < 2; ++player) {
+                if (spec.bots[player]) bots[player] = std::make_unique<AIPlayer>(&game, &interpreter, player);
+            }
+        }
+
+        int actingPlayer() const {
+            return game.hasPendingEvent() ? game.peekEvent().player : game.getCurrentPlayer();
+        }
+    };
+    std::unique_ptr<Session> session;
+
+    std::deque<std::string> lines;
+    bool closeRequested = false;
+    std::uint64_t turns = 0;
+    std::uint64_t games = 0;
+
+    Match(int matchId, const MatchSpec& s) : id(matchId), spec(s) {}
+};
+
+MatchHost::MatchHost(int workerCount, int turnsPerSlice) : sliceTurns(std::max(1, turnsPerSlice)) {
+    // Built here so no match is charged for the shared table
+    pieceRotations('I');
+
+    workerCount = std::max(1, workerCount);
+    for (int i = 0; i < workerCount; ++i) workers.push_back(std::make_unique<Worker>());
+    for (auto& worker : workers) {
+        Worker* w = worker.get();
+        w->thread = std::thread([this, w] { workerLoop(*w); });
+    }
+}
+
+MatchHost::~MatchHost() {
+    for (auto& worker : workers) {
+        std::lock_guard<std::mutex> lock(worker->mutex);
+        worker->stopping = true;
+        worker->wake.notify_one();
+    }
+    for (auto& worker : workers) worker->thread.join();
+}
+
+int MatchHost::add(const MatchSpec& spec) {
+    // Load shared files now rather than inside some match's budget
+    sequences.get(spec.scriptFile1);
+    sequences.get(spec.scriptFile2);
+
+    Worker* target;
+    int id;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        target = std::min_element(workers.begin(), workers.end(),
+                                  [](const auto& a, const auto& b) { return a->load < b->load; })->get();
+        id = nextMatchId++;
+        owners[id] = target;
+        ++target->load;
+    }
+
+    std::lock_guard<std::mutex> lock(target->mutex);
+    target->arrivals.emplace_back(id, spec);
+    target->wake.notify_one();
+    return id;
+}
+
+bool MatchHost::deliver(int id, std::string line, bool close) {
+    Worker* worker;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = owners.find(id);
+        if (it == owners.end()) return false;
+        worker = it->second;
+    }
+
+    std::lock_guard<std::mutex> lock(worker->mutex);
+    worker->posts.push_back({id, std::move(line), close});
+    worker->wake.notify_one();
+    return true;
+}
+
+bool MatchHost::post(int id, std::string line) { return deliver(id, std::move(line), false); }
+
+bool MatchHost::close(int id) { return deliver(id, std::string(), true); }
+
+std::size_t MatchHost::activeCount() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return owners.size();
+}
+
+void MatchHost::waitAll() {
+    std::unique_lock<std::mutex> lock(mutex);
+    matchEnded.wait(lock, [this] { return owners.empty(); });
+}
+
+std::vector<MatchResult> MatchHost::takeResults() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return std::exchange(results, {});
+}
+
+void MatchHost::workerLoop(Worker& worker) {
+    std::vector<std::pair<int, MatchSpec>> arrivals;
+    std::vector<Worker::Post> posts;
+    bool idle = false;
+
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(worker.mutex);
+            // Sleep only when no match can move without new input
+            if (idle) {
+                worker.wake.wait(lock, [&] {
+                    return worker.stopping || !worker.arrivals.empty() || !worker.posts.empty();
+                });
+            }
+            if (worker.stopping) break;
+            arrivals.swap(worker.arrivals);
+            posts.swap(worker.posts);
+        }
+
+        for (auto& [id, spec] : arrivals) startMatch(worker, id, spec);
+        arrivals.clear();
+
+        for (Worker::Post& post : posts) {
+            auto it = std::find_if(worker.matches.begin(), worker.matches.end(),
+                                   [&](const auto& match) { return match->id == post.id; });
+            if (it == worker.matches.end()) continue;
+            if (post.close) {
+                (*it)->closeRequested = true;
+            } else {
+                (*it)->lines.push_back(std::move(post.line));
+            }
+        }
+        posts.clear();
+
+        idle = true;
+        for (std::size_t i = 0; i < worker.matches.size();) {
+            Match& match = *worker.matches[i];
+            if (runSlice(match)) idle = false;
+
+            MatchStatus status;
+            bool over = true;
+            if (match.spec.memoryBudget && match.memory.used > static_cast<std::int64_t>(match.spec.memoryBudget)) {
+                status = MatchStatus::OverBudget;
+            } else if (match.closeRequested) {
+                status = MatchStatus::Closed;
+            } else if (!match.session->game.isGameRunning() ||
+                       (match.spec.turnLimit && match.turns >= match.spec.turnLimit)) {
+                status = MatchStatus::Finished;
+            } else {
+                over = false;
+            }
+
+            if (!over) {
+                ++i;
+                continue;
+            }
+            retire(worker, match, status);
+            worker.matches[i] = std::move(worker.matches.back());
+            worker.matches.pop_back();
+        }
+    }
+
+    for (auto& match : worker.matches) retire(worker, *match, MatchStatus::Closed);
+    worker.matches.clear();
+}
+
+void MatchHost::startMatch(Worker& worker, int id, const MatchSpec& spec) {
+    auto match = std::make_unique<Match>(id, spec);
+    {
+        HostMemory::Scope scope(match->memory);
+        match->session = std::make_unique<Match::Session>(spec, sequences);
+    }
+    worker.matches.push_back(std::move(match));
+}
+
+bool MatchHost::runSlice(Match& match) {
+    Match::Session& session = *match.session;
+    bool progressed = false;
+
+    for (int turn = 0; turn < sliceTurns && !match.closeRequested && session.game.isGameRunning(); ++turn) {
+        if (match.spec.turnLimit && match.turns >= match.spec.turnLimit) break;
+
+        AIPlayer* bot = session.bots[session.actingPlayer()].get();
+        if (bot) {
+            HostMemory::Scope scope(match.memory);
+            bot->takeTurn(session.input);
+        } else if (!match.lines.empty()) {
+            // Taken out of the queue first: the line was allocated by the
+            // posting thread, so freeing it must not be charged to the match
+            std::string line = std::move(match.lines.front());
+            match.lines.pop_front();
+
+            HostMemory::Scope scope(match.memory);
+            std::lock_guard<std::mutex> lock(consoleMutex);
+            TokenReader reader(-1, line.size() + 1);
+            reader.append(line);
+            std::string_view token;
+            while (reader.next(token) && session.game.isGameRunning()) {
+                session.interpreter.executeCommand(token, reader);
+            }
+        } else {
+            break;
+        }
+
+        ++match.turns;
+        progressed = true;
+        match.games = session.game.getGamesFinished();
+    }
+    return progressed;
+}
+
+void MatchHost::retire(Worker& worker, Match& match, MatchStatus status) {
+    Game& game = match.session->game;
+    MatchResult result{match.id, status, match.turns, match.games,
+                       {game.getScore(PLAYER_ONE)->getCurrentScore(), game.getScore(PLAYER_TWO)->getCurrentScore()},
+                       {game.getScore(PLAYER_ONE)->getHighScore(), game.getScore(PLAYER_TWO)->getHighScore()},
+                       match.memory.peak};
+    {
+        HostMemory::Scope scope(match.memory);
+        match.session.reset();
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    owners.erase(match.id);
+    --worker.load;
+    results.push_back(result);
+    matchEnded.notify_all();
+}
@@ -0,0 +1,118 @@
+export module matchhost;
+import <array>;
+import <condition_variable>;
+import <cstdint>;
+import <deque>;
+import <map>;
+import <memory>;
+import <mutex>;
+import <string>;
+import <thread>;
+import <vector>;
+import level;
+import constants;
+
+using namespace GameConstants;
+
+// Heap accounting for hosted matches. The program's operator new and
+// delete report every block here and it is charged to the match running
+// on the calling thread, if any; elsewhere the cost is one thread-local
+// load. A match only ever runs on its own worker, so a block is freed on
+// the thread that allocated it.
+export namespace HostMemory {
+    struct Account {
+        std::int64_t used = 0;      // Bytes currently held (malloc usable sizes)
+        std::int64_t peak = 0;
+    };
+
+    // Charges the calling thread's allocations to an account while alive
+    class Scope {
+        Account* previous;
+
+    public:
+        explicit Scope(Account& account);
+        ~Scope();
+
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+    };
+
+    void allocated(void* p);
+    void freed(void* p);
+}
+
+export struct MatchSpec {
+    unsigned int seed = 0;
+    int startLevel = 0;
+    std::string scriptFile1 = "biquadris_sequence1.txt";
+    std::string scriptFile2 = "biquadris_sequence2.txt";
+    std::array<bool, 2> bots = {true, true};    // Other seats play lines given to post()
+    std::uint64_t turnLimit = 0;                // Bot turns and posted lines; 0 runs until closed
+    std::size_t memoryBudget = 1 << 20;         // Heap bytes the match may hold; 0 for no limit
+};
+
+export enum class MatchStatus { Finished, Closed, OverBudget };
+
+export struct MatchResult {
+    int id;
+    MatchStatus status;
+    std::uint64_t turns;
+    std::uint64_t games;                // Games that ended in a restart
+    std::array<int, 2> score;
+    std::array<int, 2> highScore;
+    std::int64_t peakMemory;
+};
+
+// Runs many independent matches in one process. Each match is pinned to
+// one worker thread for its whole life, and a worker runs its matches
+// cooperatively: every pass gives each match a slice of a few turns, so a
+// busy match cannot starve the others on its thread. Sequence files and
+// piece rotation tables are loaded once and shared read-only by all of them.
+export class MatchHost {
+    struct Match;
+    struct Worker;
+
+    SequenceCache sequences;
+    std::vector<std::unique_ptr<Worker>> workers;
+    int sliceTurns;
+
+    std::mutex mutex;                       // Guards everything below
+    std::condition_variable matchEnded;
+    std::map<int, Worker*> owners;          // Live match id to its worker
+    std::vector<MatchResult> results;
+    int nextMatchId = 0;
+
+    void workerLoop(Worker& worker);
+    void startMatch(Worker& worker, int id, const MatchSpec& spec);
+    bool runSlice(Match& match);
+    void retire(Worker& worker, Match& match, MatchStatus status);
+    bool deliver(int id, std::string line, bool close);
+
+public:
+    explicit MatchHost(int workerCount = static_cast<int>(std::thread::hardware_concurrency()),
+                       int turnsPerSlice = 4);
+
+    // Closes every running match
+    ~MatchHost();
+
+    MatchHost(const MatchHost&) = delete;
+    MatchHost& operator=(const MatchHost&) = delete;
+
+    // Start a match on the least loaded worker; returns its id
+    int add(const MatchSpec& spec);
+
+    // Queue a command line for a match's human seats; false if it has ended.
+    // Lines run in order, each when the game is waiting on a non-bot seat.
+    bool post(int id, std::string line);
+
+    // End a match after the turn in progress; false if it has already ended
+    bool close(int id);
+
+    std::size_t activeCount();
+
+    // Block until every match added so far has ended
+    void waitAll();
+
+    // Results of matches that ended since the last call
+    std::vector<MatchResult> takeResults();
+};
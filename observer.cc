@@ -1,10 +1,61 @@
 export module observer;
+import <array>;
+import <cstdint>;
+import <utility>;
+import <variant>;
+import constants;
+import effect;
+
+using namespace GameConstants;
+
+// Typed board changes, each carrying only the delta observers need
+
+// Cells were filled in the grid (locked piece or center drop)
+export struct CellsChanged {
+    std::array<std::pair<int, int>, CELLS_PER_BLOCK> cells;  // (row, col)
+    int count;
+};
+
+// Full rows were removed; bit r of rowMask is set if row r was cleared
+// (indices refer to the grid before the clear)
+export struct RowsCleared {
+    std::uint64_t rowMask;
+    int count;
+};
+
+// Current piece moved, rotated, or was replaced
+export struct PieceMoved {
+    char type;
+    int x;
+    int y;
+    int rotation;
+};
+
+// Next piece preview changed
+export struct NextPieceChanged {
+    char type;
+};
+
+// An effect was switched on or off on this board
+export struct EffectToggled {
+    Effect::Type effect;
+    bool active;
+};
+
+// Score of this board's player changed
+export struct ScoreChanged {
+    int score;
+    int delta;
+};
+
+export using BoardChange = std::variant<CellsChanged, RowsCleared, PieceMoved,
+                                        NextPieceChanged, EffectToggled, ScoreChanged>;
 
 // Observer interface - classes that want to be notified of changes
 export class IObserver {
 public:
     virtual ~IObserver() = default;
-    virtual void update() = 0;
+    virtual void notify(const BoardChange& change) = 0;
 };
 
 // Subject interface - classes that notify observers
@@ -13,5 +64,5 @@ public:
     virtual ~ISubject() = default;
     virtual void attach(IObserver* observer) = 0;
     virtual void detach(IObserver* observer) = 0;
-    virtual void notifyObservers() = 0;
+    virtual void notifyObservers(const BoardChange& change) = 0;
 };
@@ -0,0 +1,394 @@
+module;
+#include <cstddef>
+module raster;
+import <algorithm>;
+import <cmath>;
+import <cstdint>;
+import <cstdlib>;
+import <fstream>;
+import <iostream>;
+import <string>;
+import <string_view>;
+import <vector>;
+import canvas;
+import checksum;
+
+namespace {
+  constexpr std::uint32_t rgba(int r, int g, int b) {
+    return static_cast<std::uint32_t>(r) | static_cast<std::uint32_t>(g) << 8 |
+           static_cast<std::uint32_t>(b) << 16 | 0xFF000000u;
+  }
+
+  // The X colour names Xwindow allocates, in Canvas colour order
+  constexpr std::uint32_t PALETTE[Canvas::NUM_COLOURS] = {
+    rgba(255, 255, 255), rgba(0, 0, 0), rgba(255, 0, 0), rgba(0, 255, 0),
+    rgba(0, 0, 255), rgba(0, 255, 255), rgba(255, 255, 0), rgba(255, 0, 255),
+    rgba(255, 165, 0), rgba(165, 42, 42), rgba(0, 100, 0), rgba(0, 139, 139),
+    rgba(25, 25, 112), rgba(0, 0, 128), rgba(65, 105, 225), rgba(0, 0, 205),
+  };
+
+  std::uint32_t colourValue(int colour) {
+    return colour >= 0 && colour < Canvas::NUM_COLOURS ? PALETTE[colour] : PALETTE[Canvas::Black];
+  }
+
+  // 5x7 glyphs for ' ' to '~': 35 bits, top row first, leftmost pixel high
+  constexpr int GLYPH_WIDTH = 5;
+  constexpr int GLYPH_HEIGHT = 7;
+  constexpr int GLYPH_ADVANCE = 6;
+  constexpr std::uint64_t FONT[95] = {
+    0x000000000, 0x108421004, 0x294A00000, 0x295F57D4A, 0x11F4717C4, 0x632222263,   // space ! " # $ %
+    0x32544564D, 0x108800000, 0x088842082, 0x208210888, 0x009575480, 0x0084F9080,   // & ' ( ) * +
+    0x000003088, 0x0000F8000, 0x00000018C, 0x002222200, 0x3A33AE62E, 0x11842108E,   // , - . / 0 1
+    0x3A211111F, 0x7C441062E, 0x08CA97C42, 0x7E1E0862E, 0x1910F462E, 0x7C2222108,   // 2 3 4 5 6 7
+    0x3A317462E, 0x3A317844C, 0x018C03180, 0x018C03088, 0x088882082, 0x001F07C00,   // 8 9 : ; < =
+    0x208208888, 0x3A2111004, 0x3A216D6AE, 0x3A31FC631, 0x7A31F463E, 0x3A308422E,   // > ? @ A B C
+    0x72518C65C, 0x7E10F421F, 0x7E10F4210, 0x3A30BC62F, 0x4631FC631, 0x38842108E,   // D E F G H I
+    0x1C4210A4C, 0x4654C5251, 0x42108421F, 0x4775AC631, 0x4639ACE31, 0x3A318C62E,   // J K L M N O
+    0x7A31F4210, 0x3A318D64D, 0x7A31F5251, 0x3E107043E, 0x7C8421084, 0x46318C62E,   // P Q R S T U
+    0x46318C544, 0x4631AD6AA, 0x462A22A31, 0x463151084, 0x7C222221F, 0x39084210E,   // V W X Y Z [
+    0x020820820, 0x38421084E, 0x115100000, 0x00000001F, 0x208200000, 0x000E0BE2F,   // \ ] ^ _ ` a
+    0x4216CC63E, 0x000E8422E, 0x042D9C62F, 0x000E8FE0E, 0x1928E2108, 0x01F18BC2E,   // b c d e f g
+    0x4216CC631, 0x100C2108E, 0x080610A4C, 0x4212A6292, 0x30842108E, 0x001AAD631,   // h i j k l m
+    0x0016CC631, 0x000E8C62E, 0x001E8FA10, 0x000D9BC21, 0x0016CC210, 0x000E8383E,   // n o p q r s
+    0x211C42126, 0x00118C66D, 0x00118C544, 0x00118D6AA, 0x001151151, 0x00118BC2E,   // t u v w x y
+    0x001F1111F, 0x088441082, 0x108421084, 0x208411088, 0x0008A8800,   // z { | } ~
+  };
+
+  constexpr double PI = 3.14159265358979323846;
+
+  // True if the angle (degrees) lies on the arc from start through extent
+  bool onArc(double angle, int start, int extent) {
+    if (extent >= 360) return true;
+    double offset = std::fmod(angle - start, 360.0);
+    if (offset < 0) offset += 360.0;
+    return offset <= extent;
+  }
+
+  // Deflate output, least significant bit first
+  class BitWriter {
+    std::string& out;
+    std::uint32_t buffer = 0;
+    int count = 0;
+
+   public:
+    explicit BitWriter(std::string& o) : out(o) {}
+
+    void bits(std::uint32_t value, int n) {
+      buffer |= value << count;
+      count += n;
+      while (count >= 8) {
+        out.push_back(static_cast<char>(buffer & 0xFF));
+        buffer >>= 8;
+        count -= 8;
+      }
+    }
+
+    // Huffman codes are sent most significant bit first
+    void code(std::uint32_t value, int n) {
+      std::uint32_t reversed = 0;
+      for (int i = 0; i < n; ++i) reversed |= ((value >> i) & 1) << (n - 1 - i);
+      bits(reversed, n);
+    }
+
+    void flush() {
+      if (count > 0) out.push_back(static_cast<char>(buffer & 0xFF));
+      buffer = 0;
+      count = 0;
+    }
+  };
+
+  constexpr int LENGTH_BASE[29] = {3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+                                   35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258};
+  constexpr int LENGTH_EXTRA[29] = {0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+                                    3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0};
+  constexpr int DISTANCE_BASE[30] = {1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+                                     257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145,
+                                     8193, 12289, 16385, 24577};
+  constexpr int DISTANCE_EXTRA[30] = {0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+                                      7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13};
+  constexpr int MIN_MATCH = 3;
+  constexpr int MAX_MATCH = 258;
+  constexpr std::size_t MAX_DISTANCE = 32768;
+
+  // Fixed Huffman literal/length code for a symbol (RFC 1951 3.2.6)
+  void writeSymbol(BitWriter& out, int symbol) {
+    if (symbol < 144) out.code(0x30 + symbol, 8);
+    else if (symbol < 256) out.code(0x190 + symbol - 144, 9);
+    else if (symbol < 280) out.code(symbol - 256, 7);
+    else out.code(0xC0 + symbol - 280, 8);
+  }
+
+  void writeMatch(BitWriter& out, int length, int distance) {
+    int l = 28;
+    while (LENGTH_BASE[l] > length) --l;
+    writeSymbol(out, 257 + l);
+    out.bits(length - LENGTH_BASE[l], LENGTH_EXTRA[l]);
+
+    int d = 29;
+    while (DISTANCE_BASE[d] > distance) --d;
+    out.code(d, 5);
+    out.bits(distance - DISTANCE_BASE[d], DISTANCE_EXTRA[d]);
+  }
+
+  int matchLength(const std::string& data, std::size_t pos, std::size_t distance) {
+    if (distance > pos || distance > MAX_DISTANCE) return 0;
+    std::size_t limit = std::min<std::size_t>(MAX_MATCH, data.size() - pos);
+    std::size_t n = 0;
+    while (n < limit && data[pos + n] == data[pos + n - distance]) ++n;
+    return static_cast<int>(n);
+  }
+
+  // zlib stream of one fixed-Huffman block. Game frames are flat colour, so
+  // matching only against the previous pixel and the row above finds nearly
+  // every repeat without a hash table.
+  void deflate(std::string& out, const std::string& data, std::size_t rowBytes) {
+    out.push_back(0x78);
+    out.push_back(0x01);
+
+    BitWriter bits(out);
+    bits.bits(1, 1);    // Final block
+    bits.bits(1, 2);    // Fixed Huffman codes
+    std::size_t pos = 0;
+    while (pos < data.size()) {
+      int left = matchLength(data, pos, 4);
+      int up = matchLength(data, pos, rowBytes);
+      int length = std::max(left, up);
+      if (length >= MIN_MATCH) {
+        writeMatch(bits, length, static_cast<int>(up >= left ? rowBytes : 4));
+        pos += length;
+      } else {
+        writeSymbol(bits, static_cast<unsigned char>(data[pos++]));
+      }
+    }
+    writeSymbol(bits, 256);
+    bits.flush();
+
+    std::uint32_t a = 1, b = 0;
+    for (unsigned char c : data) {
+      a = (a + c) % 65521;
+      b = (b + a) % 65521;
+    }
+    std::uint32_t adler = b << 16 | a;
+    for (int shift = 24; shift >= 0; shift -= 8) out.push_back(static_cast<char>(adler >> shift));
+  }
+
+  void putU32(std::string& out, std::uint32_t v) {
+    for (int shift = 24; shift >= 0; shift -= 8) out.push_back(static_cast<char>(v >> shift));
+  }
+
+  // Length, type, data, then the CRC of type and data
+  void writeChunk(std::string& out, const char* type, const std::string& data) {
+    putU32(out, static_cast<std::uint32_t>(data.size()));
+    std::size_t start = out.size();
+    out.append(type, 4);
+    out.append(data);
+    putU32(out, crc32(out.data() + start, out.size() - start));
+  }
+}
+
+RasterCanvas::RasterCanvas(int width, int height)
+    : Canvas(width, height), pixels(static_cast<std::size_t>(width) * height, PALETTE[White]) {}
+
+void RasterCanvas::plot(int x, int y, std::uint32_t value, int lineWidth) {
+  int low = -(lineWidth / 2);
+  for (int py = y + low; py < y + low + lineWidth; ++py) {
+    if (py < 0 || py >= canvas_height) continue;
+    for (int px = x + low; px < x + low + lineWidth; ++px) {
+      if (px >= 0 && px < canvas_width) pixels[static_cast<std::size_t>(py) * canvas_width + px] = value;
+    }
+  }
+}
+
+void RasterCanvas::fillRectangle(int x, int y, int width, int height, int colour) {
+  int x0 = std::max(x, 0), x1 = std::min(x + width, canvas_width);
+  int y0 = std::max(y, 0), y1 = std::min(y + height, canvas_height);
+  if (x0 >= x1) return;
+
+  std::uint32_t value = colourValue(colour);
+  for (int py = y0; py < y1; ++py) {
+    auto row = pixels.begin() + static_cast<std::ptrdiff_t>(py) * canvas_width;
+    std::fill(row + x0, row + x1, value);
+  }
+}
+
+void RasterCanvas::drawString(int x, int y, std::string_view msg, int colour) {
+  std::uint32_t value = colourValue(colour);
+  for (char c : msg) {
+    std::uint64_t glyph = FONT[(c >= ' ' && c <= '~' ? c : '?') - ' '];
+    for (int row = 0; row < GLYPH_HEIGHT; ++row) {
+      for (int col = 0; col < GLYPH_WIDTH; ++col) {
+        int bit = (GLYPH_HEIGHT - 1 - row) * GLYPH_WIDTH + (GLYPH_WIDTH - 1 - col);
+        if (glyph >> bit & 1) plot(x + col, y - GLYPH_HEIGHT + row, value, 1);
+      }
+    }
+    x += GLYPH_ADVANCE;
+  }
+}
+
+// Bresenham, with a square pen for wider lines
+void RasterCanvas::drawLine(int x1, int y1, int x2, int y2, int colour, int lineWidth) {
+  std::uint32_t value = colourValue(colour);
+  int dx = std::abs(x2 - x1), sx = x1 < x2 ? 1 : -1;
+  int dy = -std::abs(y2 - y1), sy = y1 < y2 ? 1 : -1;
+  int error = dx + dy;
+  while (true) {
+    plot(x1, y1, value, lineWidth);
+    if (x1 == x2 && y1 == y2) break;
+    int e2 = 2 * error;
+    if (e2 >= dy) {
+      error += dy;
+      x1 += sx;
+    }
+    if (e2 <= dx) {
+      error += dx;
+      y1 += sy;
+    }
+  }
+}
+
+void RasterCanvas::drawArc(int x, int y, int width, int height, int startAngle, int arcAngle, int colour, int lineWidth) {
+  if (arcAngle < 0) {
+    startAngle += arcAngle;
+    arcAngle = -arcAngle;
+  }
+  arcAngle = std::min(arcAngle, 360);
+
+  // Step finely enough that neighbouring samples touch
+  double rx = width / 2.0, ry = height / 2.0;
+  double cx = x + rx, cy = y + ry;
+  int steps = std::max(8, static_cast<int>(std::ceil((rx + ry) * PI * arcAngle / 360.0)) * 2);
+  std::uint32_t value = colourValue(colour);
+  for (int i = 0; i <= steps; ++i) {
+    double t = (startAngle + static_cast<double>(arcAngle) * i / steps) * PI / 180.0;
+    plot(static_cast<int>(std::lround(cx + rx * std::cos(t))),
+         static_cast<int>(std::lround(cy - ry * std::sin(t))), value, lineWidth);
+  }
+}
+
+// Pixels whose centres lie inside the ellipse and within the angle range
+void RasterCanvas::fillArc(int x, int y, int width, int height, int startAngle, int arcAngle, int colour) {
+  if (width <= 0 || height <= 0) return;
+  if (arcAngle < 0) {
+    startAngle += arcAngle;
+    arcAngle = -arcAngle;
+  }
+
+  double rx = width / 2.0, ry = height / 2.0;
+  double cx = x + rx, cy = y + ry;
+  std::uint32_t value = colourValue(colour);
+  for (int py = std::max(y, 0); py < std::min(y + height, canvas_height); ++py) {
+    for (int px = std::max(x, 0); px < std::min(x + width, canvas_width); ++px) {
+      double dx = (px + 0.5 - cx) / rx, dy = (py + 0.5 - cy) / ry;
+      if (dx * dx + dy * dy > 1.0) continue;
+      double angle = std::atan2(-dy * ry, dx * rx) * 180.0 / PI;
+      if (onArc(angle, startAngle, arcAngle)) pixels[static_cast<std::size_t>(py) * canvas_width + px] = value;
+    }
+  }
+}
+
+// Even-odd scanline fill, sampling pixel centres
+void RasterCanvas::fillPolygon(const CanvasPoint* points, int count, int colour) {
+  if (count < 3) return;
+
+  int top = points[0].y, bottom = points[0].y;
+  for (int i = 1; i < count; ++i) {
+    top = std::min(top, points[i].y);
+    bottom = std::max(bottom, points[i].y);
+  }
+
+  std::uint32_t value = colourValue(colour);
+  std::vector<double> crossings;
+  crossings.reserve(count);
+  for (int py = std::max(top, 0); py <= std::min(bottom, canvas_height - 1); ++py) {
+    double sy = py + 0.5;
+    crossings.clear();
+    for (int i = 0; i < count; ++i) {
+      const CanvasPoint& a = points[i];
+      const CanvasPoint& b = points[(i + 1) % count];
+      if ((a.y <= sy) == (b.y <= sy)) continue;
+      crossings.push_back(a.x + (sy - a.y) * (b.x - a.x) / (b.y - a.y));
+    }
+    std::sort(crossings.begin(), crossings.end());
+
+    for (std::size_t i = 0; i + 1 < crossings.size(); i += 2) {
+      int x0 = std::max(static_cast<int>(std::ceil(crossings[i] - 0.5)), 0);
+      int x1 = std::min(static_cast<int>(std::ceil(crossings[i + 1] - 0.5)), canvas_width);
+      for (int px = x0; px < x1; ++px) pixels[static_cast<std::size_t>(py) * canvas_width + px] = value;
+    }
+  }
+}
+
+void RasterCanvas::present() { ++frames; }
+
+std::uint32_t RasterCanvas::pixel(int x, int y) const {
+  return pixels[static_cast<std::size_t>(y) * canvas_width + x];
+}
+
+const std::vector<std::uint32_t>& RasterCanvas::getPixels() const { return pixels; }
+
+std::uint64_t RasterCanvas::getFrameCount() const { return frames; }
+
+void RasterCanvas::encode(std::string& out, ImageFormat format, int scale) const {
+  scale = std::max(scale, 1);
+  int width = std::max(canvas_width / scale, 1);
+  int height = std::max(canvas_height / scale, 1);
+  int channels = format == ImageFormat::Png ? 4 : 3;
+
+  // Output pixel (x, y) averages the source box at (x * scale, y * scale)
+  auto sample = [&](int x, int y, unsigned char* dest) {
+    std::uint32_t sums[4] = {};
+    int n = 0;
+    for (int sy = y * scale; sy < std::min((y + 1) * scale, canvas_height); ++sy) {
+      for (int sx = x * scale; sx < std::min((x + 1) * scale, canvas_width); ++sx) {
+        std::uint32_t p = pixel(sx, sy);
+        for (int c = 0; c < 4; ++c) sums[c] += p >> (8 * c) & 0xFF;
+        ++n;
+      }
+    }
+    for (int c = 0; c < channels; ++c) dest[c] = static_cast<unsigned char>(sums[c] / n);
+  };
+
+  if (format == ImageFormat::Ppm) {
+    out += "P6\n" + std::to_string(width) + " " + std::to_string(height) + "\n255\n";
+    std::size_t start = out.size();
+    out.resize(start + static_cast<std::size_t>(width) * height * 3);
+    unsigned char* dest = reinterpret_cast<unsigned char*>(out.data() + start);
+    for (int y = 0; y < height; ++y) {
+      for (int x = 0; x < width; ++x, dest += 3) sample(x, y, dest);
+    }
+    return;
+  }
+
+  // Scanlines, each led by filter type 0 (none)
+  std::size_t rowBytes = 1 + static_cast<std::size_t>(width) * 4;
+  std::string raw(rowBytes * height, '\0');
+  for (int y = 0; y < height; ++y) {
+    unsigned char* dest = reinterpret_cast<unsigned char*>(raw.data() + y * rowBytes + 1);
+    for (int x = 0; x < width; ++x, dest += 4) sample(x, y, dest);
+  }
+
+  out.append("\x89PNG\r\n\x1a\n", 8);
+
+  std::string header;
+  putU32(header, static_cast<std::uint32_t>(width));
+  putU32(header, static_cast<std::uint32_t>(height));
+  header += std::string("\x08\x06\x00\x00\x00", 5);     // 8-bit RGBA, deflate, no interlace
+  writeChunk(out, "IHDR", header);
+
+  std::string compressed;
+  deflate(compressed, raw, rowBytes);
+  writeChunk(out, "IDAT", compressed);
+  writeChunk(out, "IEND", {});
+}
+
+bool RasterCanvas::save(const std::string& filename, ImageFormat format, int scale) const {
+  std::string data;
+  encode(data, format, scale);
+
+  std::ofstream file(filename, std::ios::binary);
+  if (!file.write(data.data(), static_cast<std::streamsize>(data.size())) || !file.flush()) {
+    std::cerr << "Error: Could not write image file: " << filename << "\n";
+    return false;
+  }
+  return true;
+}
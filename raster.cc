@@ -0,0 +1,41 @@
+export module raster;
+import <cstdint>;
+import <string>;
+import <string_view>;
+import <vector>;
+import canvas;
+
+export enum class ImageFormat { Png, Ppm };
+
+// Canvas drawn into an RGBA image in memory, so graphics can be rendered,
+// tested and benchmarked without an X server. Colours match the X colour
+// names the window uses; text uses a built-in 5x7 font in place of the
+// server's, with the same 6 pixel advance as the X "fixed" font.
+export class RasterCanvas : public Canvas {
+  std::vector<std::uint32_t> pixels;    // Row-major, packed r | g << 8 | b << 16 | a << 24
+  std::uint64_t frames = 0;
+
+  void plot(int x, int y, std::uint32_t value, int lineWidth);
+
+ public:
+  RasterCanvas(int width, int height);
+
+  void fillRectangle(int x, int y, int width, int height, int colour=Black) override;
+  void drawString(int x, int y, std::string_view msg, int colour=White) override;
+  void drawLine(int x1, int y1, int x2, int y2, int colour, int lineWidth=1) override;
+  void drawArc(int x, int y, int width, int height, int startAngle, int arcAngle, int colour, int lineWidth=1) override;
+  void fillArc(int x, int y, int width, int height, int startAngle, int arcAngle, int colour) override;
+  void fillPolygon(const CanvasPoint* points, int count, int colour) override;
+  void present() override;
+
+  std::uint32_t pixel(int x, int y) const;
+  const std::vector<std::uint32_t>& getPixels() const;
+  std::uint64_t getFrameCount() const;      // Calls to present()
+
+  // Append the image, shrunk by `scale` (each output pixel averages a
+  // scale x scale box) for thumbnails. PNG is 8-bit RGBA; PPM drops alpha.
+  void encode(std::string& out, ImageFormat format, int scale = 1) const;
+
+  // Write the image to a file; prints the reason and returns false on failure
+  bool save(const std::string& filename, ImageFormat format, int scale = 1) const;
+};
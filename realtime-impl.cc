@@ -0,0 +1,160 @@
+module;
+#include <termios.h>
+#include <unistd.h>
+#include <cerrno>
+module realtime;
+import <algorithm>;
+import <array>;
+import <chrono>;
+import <cstdint>;
+import <iostream>;
+import <memory>;
+import <string_view>;
+import <vector>;
+import game;
+import board;
+import level;
+import command;
+import keyinput;
+import tokenreader;
+import aiplayer;
+import instrument;
+import constants;
+
+using namespace GameConstants;
+
+namespace {
+    using Clock = std::chrono::steady_clock;
+
+    constexpr Clock::duration TICK = std::chrono::duration_cast<Clock::duration>(
+        std::chrono::nanoseconds(1'000'000'000 / REALTIME_TICK_HZ));
+}
+
+RawTerminal::RawTerminal(int fd) : fd(fd), saved{} {
+    if (!isatty(fd) || tcgetattr(fd, &saved) != 0) return;
+
+    termios raw = saved;
+    raw.c_lflag &= ~(ICANON | ECHO | ISIG);
+    raw.c_iflag &= ~(IXON | ICRNL);
+    raw.c_cc[VMIN] = 1;
+    raw.c_cc[VTIME] = 0;
+    active = tcsetattr(fd, TCSAFLUSH, &raw) == 0;
+}
+
+RawTerminal::~RawTerminal() {
+    if (active) tcsetattr(fd, TCSAFLUSH, &saved);
+}
+
+bool RawTerminal::isActive() const { return active; }
+
+RealtimeLoop::RealtimeLoop(Game& g, CommandInterpreter& interp,
+                           const std::vector<std::unique_ptr<AIPlayer>>& bots)
+    : game(g), interpreter(interp), bots(bots), bindings(interp),
+      drop(interp.resolve("drop")), botInput(-1, 16) {
+    game.getWindowFds(windowFds);
+    pressed.reserve(64);
+}
+
+// Restart the fall timer at the current player's level
+void RealtimeLoop::resetFall() {
+    int level = std::clamp(game.getCurrentLevel()->getLevelNumber(), MIN_LEVEL, MAX_LEVEL);
+    fallTicks = GRAVITY_TICKS[level];
+}
+
+// One fixed step: bot seats move as soon as it is their turn, otherwise
+// gravity counts down and pulls the piece a row, locking it once it lands
+void RealtimeLoop::step() {
+    ++ticks;
+
+    for (auto& bot : bots) {
+        if (bot->shouldAct()) {
+            bot->takeTurn(botInput);
+            resetFall();
+            return;
+        }
+    }
+
+    if (game.hasPendingEvent() || --fallTicks > 0) return;
+
+    if (game.getCurrentBoard()->moveDown()) {
+        game.render();
+        resetFall();
+    } else {
+        interpreter.execute(drop, {});
+        resetFall();
+    }
+}
+
+// Run the keys read so far; returns how many ran a command
+int RealtimeLoop::applyKeys() {
+    int applied = 0;
+    for (int key : pressed) {
+        if (bindings.quitRequested()) break;
+        std::string_view command = bindings.press(key);
+        if (command.empty()) continue;
+        if (command == "drop") resetFall();
+        ++applied;
+    }
+    pressed.clear();
+    return applied;
+}
+
+void RealtimeLoop::run(int fd) {
+    std::array<unsigned char, 64> buffer;
+    resetFall();
+    std::cout.flush();
+
+    Clock::time_point nextTick = Clock::now() + TICK;
+    while (!bindings.quitRequested() && game.isGameRunning()) {
+        // Sleep until a key arrives or the next step is due
+        game.processWindowEvents(pressed);
+        if (pressed.empty()) {
+            auto wait = std::max(nextTick - Clock::now(), Clock::duration::zero());
+            if (waitForInput(fd, windowFds, wait)) {
+                ssize_t n = read(fd, buffer.data(), buffer.size());
+                if (n < 0 && errno == EINTR) continue;
+                if (n <= 0) break;      // Input ended
+                for (ssize_t i = 0; i < n; ++i) {
+                    int key = terminalKeys.decode(buffer[i]);
+                    if (key >= 0) pressed.push_back(key);
+                }
+            }
+            game.processWindowEvents(pressed);
+        }
+
+        // Keys are applied and shown before the next step
+        if (!pressed.empty()) {
+            Clock::time_point arrived = Clock::now();
+            int applied = applyKeys();
+            std::cout.flush();
+            auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - arrived).count();
+            for (int i = 0; i < applied; ++i) latency.record(static_cast<std::uint64_t>(ns), 0);
+        }
+
+        // Run the steps that are due. After a long stall (a suspended
+        // process, a slow terminal) the missed steps are dropped rather
+        // than replayed in a burst.
+        Clock::time_point now = Clock::now();
+        if (now - nextTick > MAX_CATCH_UP_TICKS * TICK) {
+            lateTicks += static_cast<std::uint64_t>((now - nextTick) / TICK);
+            nextTick = now;
+        }
+        bool stepped = false;
+        while (nextTick <= now && !bindings.quitRequested() && game.isGameRunning()) {
+            if (now - nextTick >= TICK) ++lateTicks;
+            step();
+            nextTick += TICK;
+            stepped = true;
+        }
+        if (stepped) std::cout.flush();
+    }
+}
+
+void RealtimeLoop::printStats(std::ostream& out) const {
+    constexpr std::uint64_t FRAME_US = 1'000'000 / REALTIME_TICK_HZ;
+    out << "Real-time: " << ticks << " steps at " << REALTIME_TICK_HZ << " Hz, " << lateTicks << " late\n"
+        << "Input latency over " << latency.count() << " keys: p50 " << latency.percentile(0.50) / 1000
+        << " us, p99 " << latency.percentile(0.99) / 1000 << " us, max " << latency.max() / 1000
+        << " us, mean " << latency.mean() / 1000 << " us (one frame is " << FRAME_US << " us)\n"
+        << "(percentiles are power-of-two bucket upper bounds)\n";
+}
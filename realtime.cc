@@ -0,0 +1,68 @@
+module;
+#include <termios.h>
+export module realtime;
+import <cstdint>;
+import <iostream>;
+import <memory>;
+import <vector>;
+import game;
+import command;
+import keyinput;
+import tokenreader;
+import aiplayer;
+import instrument;
+
+// Puts a terminal in raw mode (keys arrive as pressed, no echo, Ctrl-C
+// read as a key) for its lifetime. Does nothing if fd is not a terminal,
+// so piped input still works.
+export class RawTerminal {
+    int fd;
+    bool active = false;
+    termios saved;
+
+public:
+    explicit RawTerminal(int fd);
+    ~RawTerminal();
+
+    RawTerminal(const RawTerminal&) = delete;
+    RawTerminal& operator=(const RawTerminal&) = delete;
+
+    bool isActive() const;
+};
+
+// Real-time play: the game steps at REALTIME_TICK_HZ on a fixed timestep
+// and the current piece falls on a level-dependent timer. Keys from the
+// terminal and the graphics windows are read without blocking between
+// steps and applied as soon as they arrive, so a key reaches the screen
+// without waiting for the next step. Keys and gravity run the same
+// commands as typed input, so they follow the same rules; gravity waits
+// while a special action is pending.
+export class RealtimeLoop {
+    Game& game;
+    CommandInterpreter& interpreter;
+    const std::vector<std::unique_ptr<AIPlayer>>& bots;
+    KeyBindings bindings;
+    TerminalKeys terminalKeys;
+    ResolvedCommand drop;           // Gravity locks a landed piece with it
+    TokenReader botInput;           // Bots read no tokens, but take a reader
+    std::vector<int> windowFds;
+    std::vector<int> pressed;       // Keys read in one wake-up
+    int fallTicks = 0;              // Steps until the current piece falls a row
+
+    // Measurements
+    std::uint64_t ticks = 0;
+    std::uint64_t lateTicks = 0;    // Steps run behind schedule, or skipped after a stall
+    Instrument::Histogram latency;  // Key read to frame flushed
+
+    void resetFall();
+    void step();
+    int applyKeys();
+
+public:
+    RealtimeLoop(Game& g, CommandInterpreter& interp, const std::vector<std::unique_ptr<AIPlayer>>& bots);
+
+    // Play until input ends, the quit key is pressed or the game stops
+    void run(int fd);
+
+    void printStats(std::ostream& out) const;
+};
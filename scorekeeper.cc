@@ -38,6 +38,19 @@ public:
         currentScore = 0;
     }
 
+    // Carry a high score and win count over from an earlier session
+    void restore(int savedHighScore, int savedWins) {
+        if (savedHighScore > highScore) highScore = savedHighScore;
+        wins = savedWins;
+    }
+
+    // Restore everything from a saved game
+    void setState(int savedScore, int savedHighScore, int savedWins) {
+        currentScore = savedScore;
+        highScore = savedHighScore;
+        wins = savedWins;
+    }
+
     // Increment win counter
     void incrementWins() {
         wins++;
@@ -0,0 +1,327 @@
+module search;
+import <algorithm>;
+import <array>;
+import <atomic>;
+import <bit>;
+import <chrono>;
+import <condition_variable>;
+import <cstdint>;
+import <deque>;
+import <functional>;
+import <memory>;
+import <mutex>;
+import <string_view>;
+import <thread>;
+import <vector>;
+import board;
+import block;
+import game;
+import aiplayer;
+import constants;
+
+using namespace GameConstants;
+
+namespace {
+    constexpr std::string_view PIECE_ORDER = "IJLOSZT";
+
+    // Value of a line of play that tops out; far below any evaluator score
+    constexpr double GAME_OVER_VALUE = -1.0e6;
+
+    // splitmix64 finalizer
+    std::uint64_t mix(std::uint64_t h) {
+        h ^= h >> 30;
+        h *= 0xbf58476d1ce4e5b9ULL;
+        h ^= h >> 27;
+        h *= 0x94d049bb133111ebULL;
+        h ^= h >> 31;
+        return h;
+    }
+
+    // Four 16-bit rows per word, so a board hashes in a handful of mixes
+    std::uint64_t hashBoard(const BitBoard& board) {
+        std::uint64_t h = 0;
+        for (int row = 0; row < TOTAL_ROWS; row += 4) {
+            std::uint64_t word = 0;
+            for (int i = 0; i < 4 && row + i < TOTAL_ROWS; ++i) {
+                word |= static_cast<std::uint64_t>(board.rows[row + i]) << (16 * i);
+            }
+            h = mix(h ^ word);
+        }
+        return h;
+    }
+
+    // Piece index 7 marks a chance node
+    // Heavy changes which placements are reachable, so it is part of the key
+    std::uint64_t nodeKey(std::uint64_t boardHash, int piece, int depth, int heavyDrops) {
+        return mix(boardHash ^ (static_cast<std::uint64_t>(piece) << 56) ^
+                   (static_cast<std::uint64_t>(depth) << 48) ^ (static_cast<std::uint64_t>(heavyDrops) << 40)) | 1;
+    }
+
+    int pieceIndex(char type) {
+        auto pos = PIECE_ORDER.find(type);
+        return pos == std::string_view::npos ? 0 : static_cast<int>(pos);
+    }
+}
+
+// ThreadPool implementation
+ThreadPool::ThreadPool(int threads) {
+    if (threads < 0) threads = 0;
+    for (int i = 0; i <= threads; ++i) queues.push_back(std::make_unique<Queue>());
+    for (int i = 0; i < threads; ++i) workers.emplace_back([this, i] { workerLoop(i); });
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(wakeMutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (auto& worker : workers) worker.join();
+}
+
+int ThreadPool::size() const { return static_cast<int>(queues.size()); }
+
+bool ThreadPool::runOne(int self) {
+    std::function<void()> task;
+    int count = size();
+    for (int i = 0; i < count && !task; ++i) {
+        Queue& queue = *queues[(self + i) % count];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (queue.tasks.empty()) continue;
+        if (i == 0) {
+            task = std::move(queue.tasks.back());
+            queue.tasks.pop_back();
+        } else {
+            task = std::move(queue.tasks.front());
+            queue.tasks.pop_front();
+        }
+    }
+    if (!task) return false;
+
+    queued.fetch_sub(1, std::memory_order_relaxed);
+    task();
+    if (unfinished.fetch_sub(1) == 1) {
+        std::lock_guard<std::mutex> lock(wakeMutex);
+        finished.notify_all();
+    }
+    return true;
+}
+
+void ThreadPool::workerLoop(int self) {
+    while (true) {
+        if (runOne(self)) continue;
+
+        std::unique_lock<std::mutex> lock(wakeMutex);
+        wake.wait(lock, [this] { return stopping || queued.load() > 0; });
+        if (stopping) return;
+    }
+}
+
+void ThreadPool::parallelFor(int count, const std::function<void(int)>& body) {
+    if (count <= 0) return;
+
+    unfinished += count;
+    queued += count;
+    for (int i = 0; i < count; ++i) {
+        Queue& queue = *queues[i % size()];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        queue.tasks.push_back([&body, i] { body(i); });
+    }
+    {
+        std::lock_guard<std::mutex> lock(wakeMutex);
+    }
+    wake.notify_all();
+
+    // The caller owns the last queue
+    int self = size() - 1;
+    while (runOne(self)) {}
+
+    std::unique_lock<std::mutex> lock(wakeMutex);
+    finished.wait(lock, [this] { return unfinished.load() == 0; });
+}
+
+// TranspositionTable implementation
+TranspositionTable::TranspositionTable(std::uint64_t size) {
+    std::uint64_t capacity = std::bit_ceil(size ? size : 1);
+    entries = std::make_unique<Entry[]>(capacity);
+    mask = capacity - 1;
+}
+
+bool TranspositionTable::probe(std::uint64_t key, double& value) const {
+    const Entry& entry = entries[key & mask];
+    std::uint64_t bits = entry.value.load(std::memory_order_relaxed);
+    if ((entry.check.load(std::memory_order_relaxed) ^ bits) != key) return false;
+    value = std::bit_cast<double>(bits);
+    return true;
+}
+
+void TranspositionTable::store(std::uint64_t key, double value) {
+    Entry& entry = entries[key & mask];
+    std::uint64_t bits = std::bit_cast<std::uint64_t>(value);
+    entry.check.store(key ^ bits, std::memory_order_relaxed);
+    entry.value.store(bits, std::memory_order_relaxed);
+}
+
+void TranspositionTable::clear() {
+    for (std::uint64_t i = 0; i <= mask; ++i) {
+        entries[i].check.store(0, std::memory_order_relaxed);
+        entries[i].value.store(0, std::memory_order_relaxed);
+    }
+}
+
+// Searcher implementation
+struct Searcher::Context {
+    int spawnX;
+    int spawnY;
+    int heavyDrops;                 // Rows each steering command sinks the piece
+    std::chrono::steady_clock::time_point deadline;
+    std::atomic<bool>* stop;
+    std::uint64_t nodes = 0;
+
+    bool expired() {
+        if (stop->load(std::memory_order_relaxed)) return true;
+        if (std::chrono::steady_clock::now() < deadline) return false;
+        stop->store(true, std::memory_order_relaxed);
+        return true;
+    }
+};
+
+Searcher::Searcher(const Evaluator& eval, const SearchConfig& cfg)
+    : evaluator(eval), config(cfg), pool(cfg.threads), table(cfg.tableSize) {
+    for (int i = 0; i < PIECE_TYPES; ++i) {
+        pieces[i] = &pieceRotations(PIECE_ORDER[i]);
+        states[i] = &rotationStates(PIECE_ORDER[i]);
+    }
+}
+
+double Searcher::leafValue(const BitBoard& after, int lines) const {
+    return evaluator.score(after.features(lines)) + (lines >= 2 ? config.specialActionBonus : 0.0);
+}
+
+// Value of the board after a placement that cleared `lines`, with `depth`
+// pieces counted from that placement. knownNext is the next piece, or -1.
+double Searcher::continuation(Context& ctx, const BitBoard& after, int lines, int depth, int knownNext) {
+    if (depth <= 1) return leafValue(after, lines);
+
+    double reward = config.lineReward * lines + (lines >= 2 ? config.specialActionBonus : 0.0);
+    if (knownNext >= 0) return reward + pieceValue(ctx, after, knownNext, depth - 1, -1);
+    return reward + chanceValue(ctx, after, depth - 1);
+}
+
+double Searcher::pieceValue(Context& ctx, const BitBoard& board, int piece, int depth, int knownNext) {
+    if (ctx.expired()) return 0.0;
+
+    // Known pieces are specific to this move; only chance subtrees are shared
+    std::uint64_t key = 0;
+    double cached;
+    if (knownNext < 0) {
+        key = nodeKey(hashBoard(board), piece, depth, ctx.heavyDrops);
+        if (table.probe(key, cached)) return cached;
+    }
+
+    const std::vector<PieceMask>& shapes = *pieces[piece];
+    // Steering only needs simulating when heavy sinks the piece on the way
+    std::vector<Placement> placements =
+        ctx.heavyDrops > 0 ? steeredPlacements(board, shapes, *states[piece], ctx.spawnX, ctx.spawnY, 0, ctx.heavyDrops)
+                           : enumeratePlacements(board, shapes, ctx.spawnX, ctx.spawnY);
+    if (placements.empty()) return GAME_OVER_VALUE;
+
+    struct Child {
+        BitBoard after;
+        int lines;
+        double score;
+    };
+    std::vector<Child> children;
+    children.reserve(placements.size());
+    for (const Placement& p : placements) {
+        ++ctx.nodes;
+        Child child{board, 0, 0.0};
+        child.lines = child.after.place(shapes[p.shape], p.x, p.y);
+        child.score = leafValue(child.after, child.lines);
+        children.push_back(child);
+    }
+
+    double best = GAME_OVER_VALUE;
+    if (depth <= 1) {
+        for (const Child& child : children) best = std::max(best, child.score);
+    } else {
+        // Expand only the placements that look best right now
+        size_t width = std::min(children.size(), static_cast<size_t>(std::max(config.beamWidth, 1)));
+        std::partial_sort(children.begin(), children.begin() + width, children.end(),
+                          [](const Child& a, const Child& b) { return a.score > b.score; });
+        for (size_t i = 0; i < width; ++i) {
+            best = std::max(best, continuation(ctx, children[i].after, children[i].lines, depth, knownNext));
+        }
+    }
+
+    if (knownNext < 0 && !ctx.expired()) table.store(key, best);
+    return best;
+}
+
+// Level generators do not expose their weights, so every type counts equally
+double Searcher::chanceValue(Context& ctx, const BitBoard& board, int depth) {
+    std::uint64_t key = nodeKey(hashBoard(board), PIECE_TYPES, depth, ctx.heavyDrops);
+    double cached;
+    if (table.probe(key, cached)) return cached;
+
+    double total = 0.0;
+    for (int piece = 0; piece < PIECE_TYPES; ++piece) {
+        total += pieceValue(ctx, board, piece, depth, -1);
+        if (ctx.expired()) return 0.0;
+    }
+    double value = total / PIECE_TYPES;
+    table.store(key, value);
+    return value;
+}
+
+SearchResult Searcher::search(const Board& board) {
+    SearchResult result{Placement{-1, 0, 0, 0, 0, 0.0}, 0, 0};
+    const Block* current = board.getCurrentBlock();
+    if (!current) return result;
+
+    const Block* next = board.getNextBlock();
+    int piece = pieceIndex(current->getType());
+    int knownNext = next ? pieceIndex(next->getType()) : -1;
+
+    BitBoard grid = BitBoard::fromBoard(board);
+    // The move actually played is scored where the bot's commands will leave it
+    int heavyDrops = board.getHeavyDrops();
+    std::vector<Placement> roots = steeredPlacements(grid, *pieces[piece], *states[piece], current->getX(),
+                                                     current->getY(), current->getRotationState(), heavyDrops);
+    if (roots.empty()) return result;
+
+    std::vector<BitBoard> afters(roots.size(), grid);
+    for (size_t i = 0; i < roots.size(); ++i) {
+        roots[i].linesCleared = afters[i].place((*pieces[piece])[roots[i].shape], roots[i].x, roots[i].y);
+    }
+
+    std::atomic<bool> stop{false};
+    std::atomic<std::uint64_t> nodes{0};
+    auto deadline = std::chrono::steady_clock::now() + config.budget;
+    Context base{next ? next->getX() : current->getX(), next ? next->getY() : 0, heavyDrops, deadline, &stop};
+    std::vector<double> values(roots.size());
+
+    for (int depth = 1; depth <= std::max(config.maxDepth, 1); ++depth) {
+        // One task per root placement; idle workers steal whole subtrees
+        pool.parallelFor(static_cast<int>(roots.size()), [&](int i) {
+            Context ctx = base;
+            values[i] = continuation(ctx, afters[i], roots[i].linesCleared, depth, knownNext);
+            nodes.fetch_add(ctx.nodes + 1, std::memory_order_relaxed);
+        });
+
+        // The one-piece search always completes; deeper ones only count if they finished
+        if (depth > 1 && stop.load()) break;
+
+        size_t best = 0;
+        for (size_t i = 1; i < roots.size(); ++i) {
+            if (values[i] > values[best]) best = i;
+        }
+        result.placement = roots[best];
+        result.placement.score = values[best];
+        result.depth = depth;
+        if (stop.load()) break;
+    }
+
+    result.nodes = nodes.load();
+    return result;
+}
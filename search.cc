@@ -0,0 +1,111 @@
+export module search;
+import <array>;
+import <atomic>;
+import <chrono>;
+import <condition_variable>;
+import <cstdint>;
+import <deque>;
+import <functional>;
+import <memory>;
+import <mutex>;
+import <thread>;
+import <vector>;
+import board;
+import aiplayer;
+
+// Fixed set of workers, one task deque each. A worker pops its own deque
+// from the back and steals from the front of the others when it runs dry.
+export class ThreadPool {
+    struct Queue {
+        std::mutex mutex;
+        std::deque<std::function<void()>> tasks;
+    };
+
+    std::vector<std::unique_ptr<Queue>> queues;     // Workers, then the calling thread
+    std::vector<std::thread> workers;
+    std::atomic<int> queued{0};                     // Tasks sitting in a deque
+    std::atomic<int> unfinished{0};                 // Tasks not yet completed
+    std::mutex wakeMutex;
+    std::condition_variable wake;                   // Work arrived or shutting down
+    std::condition_variable finished;               // unfinished reached zero
+    bool stopping = false;
+
+    bool runOne(int self);
+    void workerLoop(int self);
+
+public:
+    // threads is the number of extra workers; 0 runs everything on the caller
+    explicit ThreadPool(int threads);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    int size() const;
+
+    // Runs body(0) .. body(count - 1) across the pool. The caller works
+    // through tasks too and returns once all of them have finished.
+    void parallelFor(int count, const std::function<void(int)>& body);
+};
+
+// Shared search cache. Entries are written without locks; each stores
+// key ^ value beside the value so a torn write reads back as a miss.
+export class TranspositionTable {
+    struct Entry {
+        std::atomic<std::uint64_t> check{0};
+        std::atomic<std::uint64_t> value{0};
+    };
+
+    std::unique_ptr<Entry[]> entries;
+    std::uint64_t mask;
+
+public:
+    // Size is rounded up to a power of two
+    explicit TranspositionTable(std::uint64_t size);
+
+    bool probe(std::uint64_t key, double& value) const;
+    void store(std::uint64_t key, double value);
+    void clear();
+};
+
+export struct SearchConfig {
+    int threads = 0;                                // Extra workers; 0 searches on the caller
+    std::chrono::microseconds budget{50000};        // Per-move time budget
+    int maxDepth = 4;                               // Pieces placed along one line of play
+    int beamWidth = 6;                              // Placements expanded per node below the root
+    double lineReward = 0.760666;                   // Value of a line cleared before the leaf
+    double specialActionBonus = 1.0;                // Clearing 2+ rows earns a special action
+    std::uint64_t tableSize = 1 << 18;              // Transposition table entries
+};
+
+export struct SearchResult {
+    Placement placement;
+    int depth;                                      // Deepest iteration that finished in budget
+    std::uint64_t nodes;
+};
+
+// Expectimax over placements for one board. The current and next pieces
+// are known; deeper plies average over the seven piece types. Iterative
+// deepening keeps the best move of the deepest search that finished
+// within the budget.
+export class Searcher {
+    static constexpr int PIECE_TYPES = 7;
+
+    const Evaluator& evaluator;
+    SearchConfig config;
+    std::array<const std::vector<PieceMask>*, PIECE_TYPES> pieces;
+    std::array<const RotationStates*, PIECE_TYPES> states;
+    ThreadPool pool;
+    TranspositionTable table;
+
+    struct Context;
+    double leafValue(const BitBoard& after, int lines) const;
+    double continuation(Context& ctx, const BitBoard& after, int lines, int depth, int knownNext);
+    double pieceValue(Context& ctx, const BitBoard& board, int piece, int depth, int knownNext);
+    double chanceValue(Context& ctx, const BitBoard& board, int depth);
+
+public:
+    explicit Searcher(const Evaluator& eval, const SearchConfig& cfg = {});
+
+    SearchResult search(const Board& board);
+};
@@ -0,0 +1,426 @@
+module;
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+module selfplay;
+import <array>;
+import <condition_variable>;
+import <cstdint>;
+import <cstring>;
+import <deque>;
+import <fstream>;
+import <mutex>;
+import <string>;
+import <thread>;
+import <vector>;
+import board;
+import block;
+import level;
+import scorekeeper;
+import game;
+import aiplayer;
+import tokenreader;
+import constants;
+
+using namespace GameConstants;
+
+namespace {
+    constexpr char FILE_MAGIC[4] = {'B', 'Q', 'S', 'P'};
+    constexpr char CHUNK_MAGIC[4] = {'B', 'Q', 'C', 'K'};
+    constexpr char INDEX_MAGIC[4] = {'B', 'Q', 'I', 'X'};
+
+    std::uint32_t zigzag(std::int32_t v) {
+        return (static_cast<std::uint32_t>(v) << 1) ^ static_cast<std::uint32_t>(v >> 31);
+    }
+
+    std::int32_t unzigzag(std::uint32_t v) {
+        return static_cast<std::int32_t>(v >> 1) ^ -static_cast<std::int32_t>(v & 1);
+    }
+
+    // Column value as stored, before the row XOR transform
+    std::uint32_t columnValue(const DecisionRecord& r, int column) {
+        if (column < TOTAL_ROWS) return r.rows[column];
+        switch (column - TOTAL_ROWS) {
+            case 0: return static_cast<std::uint8_t>(r.current);
+            case 1: return static_cast<std::uint8_t>(r.next);
+            case 2: return r.level;
+            case 3: return r.flags;
+            case 4: return r.player;
+            case 5: return r.rotation;
+            case 6: return zigzag(r.x);
+            case 7: return r.y;
+            default: return zigzag(r.scoreDelta);
+        }
+    }
+
+    void setColumnValue(DecisionRecord& r, int column, std::uint32_t v) {
+        if (column < TOTAL_ROWS) {
+            r.rows[column] = static_cast<std::uint16_t>(v);
+            return;
+        }
+        switch (column - TOTAL_ROWS) {
+            case 0: r.current = static_cast<char>(v); break;
+            case 1: r.next = static_cast<char>(v); break;
+            case 2: r.level = static_cast<std::uint8_t>(v); break;
+            case 3: r.flags = static_cast<std::uint8_t>(v); break;
+            case 4: r.player = static_cast<std::uint8_t>(v); break;
+            case 5: r.rotation = static_cast<std::uint8_t>(v); break;
+            case 6: r.x = static_cast<std::int8_t>(unzigzag(v)); break;
+            case 7: r.y = static_cast<std::uint8_t>(v); break;
+            default: r.scoreDelta = unzigzag(v); break;
+        }
+    }
+
+    void putVarint(std::vector<std::uint8_t>& out, std::uint32_t v) {
+        while (v >= 0x80) {
+            out.push_back(static_cast<std::uint8_t>(v | 0x80));
+            v >>= 7;
+        }
+        out.push_back(static_cast<std::uint8_t>(v));
+    }
+
+    bool getVarint(const std::uint8_t*& p, const std::uint8_t* end, std::uint32_t& v) {
+        v = 0;
+        for (int shift = 0; shift < 35 && p < end; shift += 7) {
+            std::uint8_t byte = *p++;
+            v |= static_cast<std::uint32_t>(byte & 0x7f) << shift;
+            if (!(byte & 0x80)) return true;
+        }
+        return false;
+    }
+
+    // Runs of equal values as (value, run length) varint pairs
+    void encodeColumn(const std::vector<DecisionRecord>& records, int column, std::vector<std::uint8_t>& out) {
+        std::uint32_t previous = 0;
+        std::uint32_t runValue = 0;
+        std::uint32_t runLength = 0;
+        for (const DecisionRecord& r : records) {
+            std::uint32_t value = columnValue(r, column);
+            std::uint32_t stored = column < TOTAL_ROWS ? value ^ previous : value;
+            previous = value;
+
+            if (runLength > 0 && stored == runValue) {
+                ++runLength;
+                continue;
+            }
+            if (runLength > 0) {
+                putVarint(out, runValue);
+                putVarint(out, runLength);
+            }
+            runValue = stored;
+            runLength = 1;
+        }
+        if (runLength > 0) {
+            putVarint(out, runValue);
+            putVarint(out, runLength);
+        }
+    }
+
+    bool decodeColumn(const std::uint8_t* p, const std::uint8_t* end, int column, std::vector<DecisionRecord>& out) {
+        std::uint32_t previous = 0;
+        std::size_t i = 0;
+        while (i < out.size()) {
+            std::uint32_t stored, runLength;
+            if (!getVarint(p, end, stored) || !getVarint(p, end, runLength)) return false;
+            if (runLength == 0 || runLength > out.size() - i) return false;
+            for (std::uint32_t k = 0; k < runLength; ++k, ++i) {
+                std::uint32_t value = column < TOTAL_ROWS ? stored ^ previous : stored;
+                setColumnValue(out[i], column, value);
+                previous = value;
+            }
+        }
+        return p == end;
+    }
+
+    template <typename T>
+    void writePod(std::ofstream& out, const T& value) {
+        out.write(reinterpret_cast<const char*>(&value), sizeof(T));
+    }
+}
+
+std::vector<std::uint8_t> encodeChunk(const std::vector<DecisionRecord>& records) {
+    std::vector<std::uint8_t> body;
+    std::array<std::uint32_t, SELFPLAY_COLUMNS> lengths{};
+    for (int column = 0; column < SELFPLAY_COLUMNS; ++column) {
+        std::size_t before = body.size();
+        encodeColumn(records, column, body);
+        lengths[column] = static_cast<std::uint32_t>(body.size() - before);
+    }
+
+    std::vector<std::uint8_t> chunk(sizeof(lengths) + body.size());
+    std::memcpy(chunk.data(), lengths.data(), sizeof(lengths));
+    std::memcpy(chunk.data() + sizeof(lengths), body.data(), body.size());
+    return chunk;
+}
+
+bool decodeChunk(const std::uint8_t* data, std::size_t size, std::uint32_t count,
+                 std::vector<DecisionRecord>& out) {
+    std::array<std::uint32_t, SELFPLAY_COLUMNS> lengths;
+    if (size < sizeof(lengths)) return false;
+    std::memcpy(lengths.data(), data, sizeof(lengths));
+
+    out.assign(count, DecisionRecord{});
+    const std::uint8_t* p = data + sizeof(lengths);
+    const std::uint8_t* end = data + size;
+    for (int column = 0; column < SELFPLAY_COLUMNS; ++column) {
+        if (lengths[column] > static_cast<std::size_t>(end - p)) return false;
+        if (!decodeColumn(p, p + lengths[column], column, out)) return false;
+        p += lengths[column];
+    }
+    return p == end;
+}
+
+// SelfPlayWriter implementation
+SelfPlayWriter::SelfPlayWriter(const std::string& file, std::size_t records, std::size_t queueChunks)
+    : out(file, std::ios::binary | std::ios::trunc),
+      chunkRecords(records ? records : 1), queueLimit(queueChunks ? queueChunks : 1) {
+    if (!out) return;
+
+    FileHeader header{};
+    std::memcpy(header.magic, FILE_MAGIC, sizeof(header.magic));
+    header.version = SELFPLAY_VERSION;
+    header.columns = SELFPLAY_COLUMNS;
+    writePod(out, header);
+
+    building.reserve(chunkRecords);
+    worker = std::thread([this] { writerLoop(); });
+}
+
+SelfPlayWriter::~SelfPlayWriter() { close(); }
+
+bool SelfPlayWriter::isOpen() const { return out.is_open(); }
+
+std::uint64_t SelfPlayWriter::getRecordCount() const { return recordsAccepted; }
+
+void SelfPlayWriter::write(const DecisionRecord& record) {
+    if (closed || !worker.joinable()) return;
+
+    building.push_back(record);
+    ++recordsAccepted;
+    if (building.size() < chunkRecords) return;
+
+    std::unique_lock<std::mutex> lock(queueMutex);
+    queueSpace.wait(lock, [this] { return queue.size() < queueLimit; });
+    queue.push_back(std::move(building));
+    lock.unlock();
+    queueReady.notify_one();
+
+    building = std::vector<DecisionRecord>();
+    building.reserve(chunkRecords);
+}
+
+void SelfPlayWriter::writerLoop() {
+    while (true) {
+        std::unique_lock<std::mutex> lock(queueMutex);
+        queueReady.wait(lock, [this] { return closing || !queue.empty(); });
+        if (queue.empty()) return;
+
+        std::vector<DecisionRecord> records = std::move(queue.front());
+        queue.pop_front();
+        lock.unlock();
+        queueSpace.notify_one();
+
+        writeChunk(records);
+    }
+}
+
+void SelfPlayWriter::writeChunk(const std::vector<DecisionRecord>& records) {
+    std::vector<std::uint8_t> body = encodeChunk(records);
+
+    ChunkHeader header{};
+    std::memcpy(header.magic, CHUNK_MAGIC, sizeof(header.magic));
+    header.records = static_cast<std::uint32_t>(records.size());
+
+    ChunkIndexEntry entry{};
+    entry.offset = static_cast<std::uint64_t>(out.tellp());
+    entry.firstRecord = recordsWritten;
+    entry.records = header.records;
+    entry.bytes = static_cast<std::uint32_t>(sizeof(header) + body.size());
+
+    writePod(out, header);
+    out.write(reinterpret_cast<const char*>(body.data()), static_cast<std::streamsize>(body.size()));
+    if (!out) failed = true;
+
+    index.push_back(entry);
+    recordsWritten += records.size();
+}
+
+bool SelfPlayWriter::close() {
+    if (closed) return !failed;
+    closed = true;
+    if (!worker.joinable()) return false;
+
+    {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        if (!building.empty()) queue.push_back(std::move(building));
+        closing = true;
+    }
+    queueReady.notify_one();
+    worker.join();
+
+    // Index entries are 8-byte aligned so a mapping can use them in place
+    std::uint64_t offset = static_cast<std::uint64_t>(out.tellp());
+    while (offset % alignof(ChunkIndexEntry) != 0) {
+        out.put('\0');
+        ++offset;
+    }
+    for (const ChunkIndexEntry& entry : index) writePod(out, entry);
+
+    FileTrailer trailer{};
+    trailer.indexOffset = offset;
+    trailer.totalRecords = recordsWritten;
+    trailer.chunkCount = static_cast<std::uint32_t>(index.size());
+    std::memcpy(trailer.magic, INDEX_MAGIC, sizeof(trailer.magic));
+    writePod(out, trailer);
+
+    out.close();
+    if (!out) failed = true;
+    return !failed;
+}
+
+// SelfPlayFile implementation
+SelfPlayFile::~SelfPlayFile() { close(); }
+
+bool SelfPlayFile::open(const std::string& filename) {
+    close();
+
+    int fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+
+    struct stat info;
+    if (fstat(fd, &info) != 0 || static_cast<std::size_t>(info.st_size) < sizeof(FileHeader) + sizeof(FileTrailer)) {
+        ::close(fd);
+        return false;
+    }
+
+    void* mapped = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (mapped == MAP_FAILED) return false;
+
+    data = static_cast<const std::uint8_t*>(mapped);
+    size = static_cast<std::size_t>(info.st_size);
+
+    const FileHeader* header = reinterpret_cast<const FileHeader*>(data);
+    const FileTrailer* tail = reinterpret_cast<const FileTrailer*>(data + size - sizeof(FileTrailer));
+    bool valid = std::memcmp(header->magic, FILE_MAGIC, 4) == 0 &&
+                 header->version == SELFPLAY_VERSION && header->columns == SELFPLAY_COLUMNS &&
+                 std::memcmp(tail->magic, INDEX_MAGIC, 4) == 0 &&
+                 tail->indexOffset % alignof(ChunkIndexEntry) == 0 &&
+                 tail->indexOffset + static_cast<std::uint64_t>(tail->chunkCount) * sizeof(ChunkIndexEntry) ==
+                     size - sizeof(FileTrailer);
+    if (!valid) {
+        close();
+        return false;
+    }
+
+    trailer = tail;
+    entries = reinterpret_cast<const ChunkIndexEntry*>(data + trailer->indexOffset);
+    return true;
+}
+
+void SelfPlayFile::close() {
+    if (data) munmap(const_cast<std::uint8_t*>(data), size);
+    data = nullptr;
+    size = 0;
+    entries = nullptr;
+    trailer = nullptr;
+}
+
+std::uint64_t SelfPlayFile::recordCount() const { return trailer ? trailer->totalRecords : 0; }
+
+std::uint32_t SelfPlayFile::chunkCount() const { return trailer ? trailer->chunkCount : 0; }
+
+const ChunkIndexEntry& SelfPlayFile::chunk(std::uint32_t i) const { return entries[i]; }
+
+bool SelfPlayFile::readChunk(std::uint32_t i, std::vector<DecisionRecord>& out) const {
+    if (i >= chunkCount()) return false;
+
+    const ChunkIndexEntry& entry = entries[i];
+    if (entry.bytes < sizeof(ChunkHeader) || entry.offset + entry.bytes > trailer->indexOffset) return false;
+
+    const ChunkHeader* header = reinterpret_cast<const ChunkHeader*>(data + entry.offset);
+    if (std::memcmp(header->magic, CHUNK_MAGIC, 4) != 0 || header->records != entry.records) return false;
+
+    return decodeChunk(data + entry.offset + sizeof(ChunkHeader), entry.bytes - sizeof(ChunkHeader),
+                       entry.records, out);
+}
+
+// Self-play driver
+SelfPlayStats runSelfPlay(Game& game, AIPlayer& bot1, AIPlayer& bot2, TokenReader& input,
+                          SelfPlayWriter& writer, std::uint64_t decisions, std::uint64_t horizon) {
+    struct Pending {
+        DecisionRecord record;
+        int scoreBefore;
+    };
+
+    SelfPlayStats stats;
+    std::array<AIPlayer*, 2> bots{};
+    bots[bot1.getPlayer()] = &bot1;
+    bots[bot2.getPlayer()] = &bot2;
+
+    std::array<std::deque<Pending>, 2> pending;
+    std::array<int, 2> lastScore{};
+
+    // Settle records beyond the newest `keep` against the player's last known score
+    auto settle = [&](int player, std::size_t keep) {
+        while (pending[player].size() > keep) {
+            Pending& p = pending[player].front();
+            p.record.scoreDelta = lastScore[player] - p.scoreBefore;
+            writer.write(p.record);
+            pending[player].pop_front();
+        }
+    };
+
+    int gamesFinished = game.getGamesFinished();
+
+    while (stats.decisions < decisions && game.isGameRunning()) {
+        if (game.hasPendingEvent()) {
+            bots[game.peekEvent().player]->takeTurn(input);
+            continue;
+        }
+
+        int player = game.getCurrentPlayer();
+        Board* board = game.getBoard(player);
+        const Block* current = board->getCurrentBlock();
+        if (!current) break;
+
+        Placement placement = bots[player]->choosePlacement();
+
+        DecisionRecord record{};
+        record.rows = BitBoard::fromBoard(*board).rows;
+        record.current = current->getType();
+        record.next = board->getNextBlock() ? board->getNextBlock()->getType() : ' ';
+        record.level = static_cast<std::uint8_t>(game.getCurrentLevel()->getLevelNumber());
+        record.flags = (board->hasHeavyEffect() ? DecisionRecord::HEAVY_FLAG : 0) |
+                       (board->hasBlindEffect() ? DecisionRecord::BLIND_FLAG : 0);
+        record.player = static_cast<std::uint8_t>(player);
+        record.rotation = static_cast<std::uint8_t>(placement.rotation);
+        record.x = static_cast<std::int8_t>(placement.x);
+        record.y = static_cast<std::uint8_t>(placement.y);
+        pending[player].push_back({record, game.getScore(player)->getCurrentScore()});
+
+        bots[player]->playPlacement(placement, input);
+        stats.decisions++;
+
+        if (game.getGamesFinished() != gamesFinished) {
+            // Game over: settle against the final scores, including the last
+            // placement's, then start from the restarted game's scores
+            gamesFinished = game.getGamesFinished();
+            const GameSummary& summary = game.getLastSummary();
+            lastScore = {summary.scores[PLAYER_ONE], summary.scores[PLAYER_TWO]};
+            settle(PLAYER_ONE, 0);
+            settle(PLAYER_TWO, 0);
+            lastScore = {game.getScore(PLAYER_ONE)->getCurrentScore(),
+                         game.getScore(PLAYER_TWO)->getCurrentScore()};
+            stats.games++;
+        } else {
+            lastScore[player] = game.getScore(player)->getCurrentScore();
+            settle(player, horizon);
+        }
+    }
+
+    settle(PLAYER_ONE, 0);
+    settle(PLAYER_TWO, 0);
+    return stats;
+}
@@ -0,0 +1,160 @@
+export module selfplay;
+import <array>;
+import <condition_variable>;
+import <cstdint>;
+import <deque>;
+import <fstream>;
+import <mutex>;
+import <string>;
+import <thread>;
+import <vector>;
+import game;
+import aiplayer;
+import tokenreader;
+import constants;
+
+using namespace GameConstants;
+
+// One bot decision. Rows use the RowMask layout (bit c = column c filled).
+export struct DecisionRecord {
+    std::array<std::uint16_t, TOTAL_ROWS> rows;
+    char current;
+    char next;
+    std::uint8_t level;
+    std::uint8_t flags;             // HEAVY_FLAG | BLIND_FLAG
+    std::uint8_t player;
+    std::uint8_t rotation;          // Clockwise turns from the spawn orientation
+    std::int8_t x;                  // Block position of the chosen placement
+    std::uint8_t y;
+    std::int32_t scoreDelta;        // Player's score at game end (or horizon) minus score now
+
+    static constexpr std::uint8_t HEAVY_FLAG = 1;
+    static constexpr std::uint8_t BLIND_FLAG = 2;
+};
+
+// File layout (little-endian hosts):
+//   FileHeader
+//   chunks:  ChunkHeader, u32 byte length per column, column data
+//   padding to 8 bytes, ChunkIndexEntry[chunkCount], FileTrailer
+// The trailer sits at a fixed distance from the end and the index is
+// 8-byte aligned, so a reader can map the file and use both in place.
+export struct FileHeader {
+    char magic[4];                  // "BQSP"
+    std::uint32_t version;
+    std::uint32_t columns;
+    std::uint32_t reserved;
+};
+
+export struct ChunkHeader {
+    char magic[4];                  // "BQCK"
+    std::uint32_t records;
+};
+
+export struct ChunkIndexEntry {
+    std::uint64_t offset;           // File offset of the ChunkHeader
+    std::uint64_t firstRecord;
+    std::uint32_t records;
+    std::uint32_t bytes;            // Header, lengths and column data
+};
+
+export struct FileTrailer {
+    std::uint64_t indexOffset;
+    std::uint64_t totalRecords;
+    std::uint32_t chunkCount;
+    char magic[4];                  // "BQIX"
+};
+
+export constexpr std::uint32_t SELFPLAY_VERSION = 1;
+
+// Columns: one per board row, then current, next, level, flags, player,
+// rotation, x, y, scoreDelta. Each is encoded separately (board rows as
+// XOR against the previous record) and run-length packed as varints.
+export constexpr int SELFPLAY_COLUMNS = TOTAL_ROWS + 9;
+
+// Encode one chunk's columns (without the header); used by the writer and tests
+export std::vector<std::uint8_t> encodeChunk(const std::vector<DecisionRecord>& records);
+
+// Decode `count` records from encodeChunk() output; false if it is malformed
+export bool decodeChunk(const std::uint8_t* data, std::size_t size, std::uint32_t count,
+                        std::vector<DecisionRecord>& out);
+
+// Buffers records into chunks and hands full chunks to a writer thread
+// through a bounded queue. The caller only blocks when the queue is full.
+export class SelfPlayWriter {
+    std::ofstream out;
+    std::size_t chunkRecords;
+    std::size_t queueLimit;
+
+    std::vector<DecisionRecord> building;
+    std::deque<std::vector<DecisionRecord>> queue;
+    std::mutex queueMutex;
+    std::condition_variable queueReady;     // A chunk was queued or closing
+    std::condition_variable queueSpace;     // A chunk was taken off the queue
+    bool closing = false;
+
+    std::uint64_t recordsAccepted = 0;
+
+    // Owned by the writer thread until it is joined
+    std::vector<ChunkIndexEntry> index;
+    std::uint64_t recordsWritten = 0;
+    bool failed = false;
+
+    std::thread worker;
+    bool closed = false;
+
+    void writerLoop();
+    void writeChunk(const std::vector<DecisionRecord>& records);
+
+public:
+    explicit SelfPlayWriter(const std::string& file, std::size_t chunkRecords = 4096,
+                            std::size_t queueChunks = 8);
+    ~SelfPlayWriter();
+
+    SelfPlayWriter(const SelfPlayWriter&) = delete;
+    SelfPlayWriter& operator=(const SelfPlayWriter&) = delete;
+
+    bool isOpen() const;
+    void write(const DecisionRecord& record);
+
+    // Flushes, writes the index and trailer; false on any I/O error
+    bool close();
+
+    // Records passed to write() so far
+    std::uint64_t getRecordCount() const;
+};
+
+// Read-only view of a self-play file through mmap
+export class SelfPlayFile {
+    const std::uint8_t* data = nullptr;
+    std::size_t size = 0;
+    const ChunkIndexEntry* entries = nullptr;
+    const FileTrailer* trailer = nullptr;
+
+public:
+    SelfPlayFile() = default;
+    ~SelfPlayFile();
+
+    SelfPlayFile(const SelfPlayFile&) = delete;
+    SelfPlayFile& operator=(const SelfPlayFile&) = delete;
+
+    // False if the file cannot be mapped or its header, index or trailer is bad
+    bool open(const std::string& filename);
+    void close();
+
+    std::uint64_t recordCount() const;
+    std::uint32_t chunkCount() const;
+    const ChunkIndexEntry& chunk(std::uint32_t i) const;
+    bool readChunk(std::uint32_t i, std::vector<DecisionRecord>& out) const;
+};
+
+export struct SelfPlayStats {
+    std::uint64_t decisions = 0;
+    std::uint64_t games = 0;            // Games that ended in a restart
+};
+
+// Plays bots against each other headlessly and records every placement.
+// A record's score delta is settled when its game ends, or after
+// `horizon` more decisions by the same player, whichever is first.
+export SelfPlayStats runSelfPlay(Game& game, AIPlayer& bot1, AIPlayer& bot2, TokenReader& input,
+                                 SelfPlayWriter& writer, std::uint64_t decisions,
+                                 std::uint64_t horizon = 1000);
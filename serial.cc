@@ -0,0 +1,90 @@
+export module serial;
+import <cstdint>;
+import <cstring>;
+import <string>;
+import <string_view>;
+
+// Little-endian encoding of game state for save files. Both sides are inline
+// so per-turn checkpoints compile down to plain stores and loads.
+export class ByteWriter {
+    std::string& out;
+
+public:
+    explicit ByteWriter(std::string& buffer) : out(buffer) {}
+
+    void u8(std::uint8_t v) { out.push_back(static_cast<char>(v)); }
+
+    void u16(std::uint16_t v) {
+        u8(static_cast<std::uint8_t>(v));
+        u8(static_cast<std::uint8_t>(v >> 8));
+    }
+
+    void u32(std::uint32_t v) {
+        u16(static_cast<std::uint16_t>(v));
+        u16(static_cast<std::uint16_t>(v >> 16));
+    }
+
+    void i8(int v) { u8(static_cast<std::uint8_t>(static_cast<std::int8_t>(v))); }
+    void i32(std::int32_t v) { u32(static_cast<std::uint32_t>(v)); }
+
+    void bytes(const void* data, std::size_t size) { out.append(static_cast<const char*>(data), size); }
+
+    // u16 length, then the characters
+    void str(std::string_view s) {
+        u16(static_cast<std::uint16_t>(s.size()));
+        out.append(s.substr(0, UINT16_MAX));
+    }
+};
+
+// Reads what ByteWriter wrote. Reading past the end yields zeros and marks
+// the reader failed, so callers check ok() once at the end.
+export class ByteReader {
+    std::string_view data;
+    std::size_t pos = 0;
+    bool failed = false;
+
+    bool take(std::size_t size) {
+        if (failed || data.size() - pos < size) {
+            failed = true;
+            return false;
+        }
+        return true;
+    }
+
+public:
+    explicit ByteReader(std::string_view buffer) : data(buffer) {}
+
+    std::uint8_t u8() { return take(1) ? static_cast<std::uint8_t>(data[pos++]) : 0; }
+
+    std::uint16_t u16() {
+        std::uint16_t low = u8();
+        return static_cast<std::uint16_t>(low | u8() << 8);
+    }
+
+    std::uint32_t u32() {
+        std::uint32_t low = u16();
+        return low | static_cast<std::uint32_t>(u16()) << 16;
+    }
+
+    int i8() { return static_cast<std::int8_t>(u8()); }
+    std::int32_t i32() { return static_cast<std::int32_t>(u32()); }
+
+    void bytes(void* dest, std::size_t size) {
+        if (!take(size)) return;
+        std::memcpy(dest, data.data() + pos, size);
+        pos += size;
+    }
+
+    std::string str() {
+        std::size_t size = u16();
+        if (!take(size)) return {};
+        pos += size;
+        return std::string(data.substr(pos - size, size));
+    }
+
+    // Marks the input invalid (a value out of range)
+    void fail() { failed = true; }
+
+    bool ok() const { return !failed; }
+    bool atEnd() const { return pos == data.size(); }
+};
@@ -0,0 +1,457 @@
+module;
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#include <cerrno>
+module server;
+import <array>;
+import <cctype>;
+import <charconv>;
+import <cstdint>;
+import <cstring>;
+import <deque>;
+import <iostream>;
+import <map>;
+import <utility>;
+import <memory>;
+import <string>;
+import <string_view>;
+import <vector>;
+import board;
+import block;
+import level;
+import scorekeeper;
+import game;
+import command;
+import tokenreader;
+import aiplayer;
+import constants;
+
+using namespace GameConstants;
+
+namespace {
+    constexpr std::size_t MAX_LINE = 4096;
+
+    // Largest count a remote player may put before a command. Each repeat
+    // runs on the server thread, so an unbounded count would stall every
+    // match; this still moves a piece across or down the largest board.
+    constexpr int MAX_REMOTE_MULTIPLIER = MAX_TOTAL_ROWS;
+
+    // Commands that touch server files or print to the server's terminal
+    bool isRemoteBlocked(std::string_view command) {
+        return command == "sequence" || command == "s" || command == "norandom" || command == "help" ||
+               command == "h" || command == "stats" || command == "save" || command == "load";
+    }
+}
+
+struct MatchServer::Connection {
+    int fd;
+    bool spectator;
+    std::string in;
+    std::deque<Frame> out;          // Queued frames, shared with other viewers
+    std::size_t outOffset = 0;      // Bytes of out.front() already sent
+    std::size_t outBytes = 0;       // Unsent bytes across out
+    Match* match = nullptr;         // Playing or watching
+    int seat = -1;                  // -1 while watching
+    bool wantWrite = false;
+    bool dead = false;              // Closed after the current batch of events
+
+    Connection(int f, bool watching) : fd(f), spectator(watching) {}
+};
+
+struct MatchServer::Match {
+    int id;
+    Game game;
+    CommandInterpreter interpreter;
+    MatchBroadcast broadcast;       // Observes the game's boards; declared after it
+    std::array<Connection*, 2> seats{};
+    std::vector<Connection*> spectators;
+
+    Match(int matchId, const ServerConfig& config)
+        : id(matchId),
+          game(config.seed + matchId, config.startLevel, config.scriptFile1, config.scriptFile2, true),
+          interpreter(&game), broadcast(game) {
+        game.setHeadless(true);
+    }
+
+    // Seat the game is waiting on: a pending special action, else the current player
+    int actingPlayer() const {
+        return game.hasPendingEvent() ? game.peekEvent().player : game.getCurrentPlayer();
+    }
+};
+
+MatchServer::MatchServer(const ServerConfig& cfg) : config(cfg) {}
+
+MatchServer::~MatchServer() {
+    for (auto& [fd, conn] : connections) close(fd);
+    if (listenFd >= 0) close(listenFd);
+    if (spectatorFd >= 0) close(spectatorFd);
+    if (epollFd >= 0) close(epollFd);
+}
+
+bool MatchServer::listenOn(int port, int& fd, int& bound) {
+    fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        std::cerr << "Error: Could not create socket: " << std::strerror(errno) << "\n";
+        return false;
+    }
+
+    int yes = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(yes));
+
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    addr.sin_port = htons(static_cast<std::uint16_t>(port));
+    if (bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0 || listen(fd, SOMAXCONN) < 0) {
+        std::cerr << "Error: Could not listen on port " << port << ": " << std::strerror(errno) << "\n";
+        return false;
+    }
+
+    socklen_t length = sizeof(addr);
+    getsockname(fd, reinterpret_cast<sockaddr*>(&addr), &length);
+    bound = ntohs(addr.sin_port);
+
+    epoll_event event{};
+    event.events = EPOLLIN;
+    event.data.fd = fd;
+    if (epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &event) < 0) {
+        std::cerr << "Error: Could not create event loop: " << std::strerror(errno) << "\n";
+        return false;
+    }
+    return true;
+}
+
+bool MatchServer::start() {
+    epollFd = epoll_create1(EPOLL_CLOEXEC);
+    if (epollFd < 0) {
+        std::cerr << "Error: Could not create event loop: " << std::strerror(errno) << "\n";
+        return false;
+    }
+    if (!listenOn(config.port, listenFd, boundPort)) return false;
+    return config.spectatorPort < 0 || listenOn(config.spectatorPort, spectatorFd, spectatorBoundPort);
+}
+
+int MatchServer::getPort() const { return boundPort; }
+
+int MatchServer::getSpectatorPort() const { return spectatorBoundPort; }
+
+std::size_t MatchServer::matchCount() const { return matches.size(); }
+
+void MatchServer::stop() { running = false; }
+
+void MatchServer::run() {
+    running = true;
+    std::array<epoll_event, 64> events;
+
+    while (running) {
+        // Wake periodically so stop() takes effect without traffic
+        int n = epoll_wait(epollFd, events.data(), static_cast<int>(events.size()), 250);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            std::cerr << "Error: Event loop failed: " << std::strerror(errno) << "\n";
+            break;
+        }
+
+        for (int i = 0; i < n; ++i) {
+            int fd = events[i].data.fd;
+            if (fd == listenFd || fd == spectatorFd) {
+                acceptConnections(fd, fd == spectatorFd);
+                continue;
+            }
+
+            auto it = connections.find(fd);
+            if (it == connections.end()) continue;
+            Connection& conn = *it->second;
+
+            if (events[i].events & EPOLLIN) handleInput(conn);
+            if (events[i].events & (EPOLLERR | EPOLLHUP)) conn.dead = true;
+            if ((events[i].events & EPOLLOUT) && !conn.dead) flush(conn);
+        }
+
+        // Closing can re-pair an opponent, whose sends may fail in turn
+        std::vector<int> dead;
+        do {
+            dead.clear();
+            for (auto& [fd, conn] : connections) {
+                if (conn->dead) dead.push_back(fd);
+            }
+            for (int fd : dead) closeConnection(fd);
+        } while (!dead.empty());
+    }
+}
+
+void MatchServer::acceptConnections(int listener, bool spectators) {
+    while (true) {
+        int fd = accept4(listener, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) {
+            if (errno == EINTR) continue;
+            return;     // EAGAIN, or out of descriptors until someone leaves
+        }
+
+        // Commands are tiny and latency-sensitive
+        int yes = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &yes, sizeof(yes));
+
+        epoll_event event{};
+        event.events = EPOLLIN;
+        event.data.fd = fd;
+        if (epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &event) < 0) {
+            close(fd);
+            continue;
+        }
+
+        auto conn = std::make_unique<Connection>(fd, spectators);
+        Connection& ref = *conn;
+        connections[fd] = std::move(conn);
+        if (spectators) {
+            sendText(ref, "Send: watch <match id>");
+        } else {
+            pair(ref);
+        }
+    }
+}
+
+void MatchServer::handleInput(Connection& conn) {
+    char buffer[4096];
+    while (true) {
+        ssize_t n = recv(conn.fd, buffer, sizeof(buffer), 0);
+        if (n > 0) {
+            conn.in.append(buffer, static_cast<std::size_t>(n));
+            continue;
+        }
+        if (n < 0 && errno == EINTR) continue;
+        if (n == 0 || (errno != EAGAIN && errno != EWOULDBLOCK)) conn.dead = true;
+        break;
+    }
+
+    std::size_t start = 0;
+    std::size_t newline;
+    while (!conn.dead && (newline = conn.in.find('\n', start)) != std::string::npos) {
+        std::string_view line(conn.in.data() + start, newline - start);
+        if (!line.empty() && line.back() == '\r') line.remove_suffix(1);
+        handleLine(conn, line);
+        start = newline + 1;
+    }
+    conn.in.erase(0, start);
+
+    // Nobody types a line this long
+    if (conn.in.size() > MAX_LINE) conn.dead = true;
+}
+
+void MatchServer::handleLine(Connection& conn, std::string_view line) {
+    if (conn.spectator) {
+        handleWatch(conn, line);
+        return;
+    }
+    if (!conn.match) {
+        sendText(conn, "Waiting for an opponent");
+        return;
+    }
+    Match& match = *conn.match;
+
+    // Arguments (force Z) are read from the same line
+    TokenReader reader(-1, line.size() + 1);
+    reader.append(line);
+
+    std::string_view token;
+    while (reader.next(token)) {
+        if (match.actingPlayer() != conn.seat) {
+            sendText(conn, "Not your turn");
+            break;
+        }
+
+        std::size_t digits = 0;
+        while (digits < token.size() && std::isdigit(static_cast<unsigned char>(token[digits]))) ++digits;
+        int multiplier = 0;
+        if (digits > 0 && (std::from_chars(token.data(), token.data() + digits, multiplier).ec != std::errc() ||
+                           multiplier > MAX_REMOTE_MULTIPLIER)) {
+            sendText(conn, "Count too large (at most " + std::to_string(MAX_REMOTE_MULTIPLIER) + "): " +
+                           std::string(token));
+            break;
+        }
+        if (isRemoteBlocked(match.interpreter.matchCommand(token.substr(digits)))) {
+            sendText(conn, "Command not available over the network: " + std::string(token));
+            break;
+        }
+
+        match.interpreter.executeCommand(token, reader);
+    }
+    broadcastState(match);
+}
+
+void MatchServer::handleWatch(Connection& conn, std::string_view line) {
+    constexpr std::string_view WATCH = "watch ";
+    int id = -1;
+    if (line.substr(0, WATCH.size()) == WATCH && line.size() > WATCH.size() && line.size() < WATCH.size() + 10) {
+        id = 0;
+        for (char c : line.substr(WATCH.size())) {
+            if (!std::isdigit(static_cast<unsigned char>(c))) {
+                id = -1;
+                break;
+            }
+            id = id * 10 + (c - '0');
+        }
+    }
+
+    auto it = id >= 0 ? matches.find(id) : matches.end();
+    if (it == matches.end()) {
+        sendText(conn, "No such match; send: watch <match id>");
+        return;
+    }
+
+    stopWatching(conn);
+    it->second->spectators.push_back(&conn);
+    join(conn, *it->second, SPECTATOR_SEAT);
+}
+
+void MatchServer::stopWatching(Connection& conn) {
+    if (!conn.spectator || !conn.match) return;
+    std::erase(conn.match->spectators, &conn);
+    conn.match = nullptr;
+}
+
+// Hello, then the keyframe and every delta since, so the viewer is current
+void MatchServer::join(Connection& conn, Match& match, std::uint8_t seat) {
+    conn.match = &match;
+    conn.seat = seat == SPECTATOR_SEAT ? -1 : seat;
+
+    send(conn, makeHello(seat, static_cast<std::uint32_t>(match.id)));
+
+    send(conn, match.broadcast.getKeyframe());
+    for (const Frame& delta : match.broadcast.getDeltasSinceKeyframe()) send(conn, delta);
+}
+
+void MatchServer::pair(Connection& conn) {
+    if (!waiting || waiting == &conn) {
+        waiting = &conn;
+        sendText(conn, "Waiting for an opponent");
+        return;
+    }
+
+    int id = nextMatchId++;
+    auto match = std::make_unique<Match>(id, config);
+    match->seats = {waiting, &conn};
+    waiting = nullptr;
+
+    Match& ref = *match;
+    matches[id] = std::move(match);
+    for (int seat = 0; seat < 2; ++seat) join(*ref.seats[seat], ref, static_cast<std::uint8_t>(seat));
+}
+
+void MatchServer::closeConnection(int fd) {
+    auto it = connections.find(fd);
+    if (it == connections.end()) return;
+    Connection& conn = *it->second;
+
+    if (waiting == &conn) waiting = nullptr;
+    stopWatching(conn);
+
+    Connection* opponent = nullptr;
+    if (conn.match) {
+        Match& match = *conn.match;
+        opponent = match.seats[1 - conn.seat];
+        for (Connection* viewer : match.spectators) {
+            viewer->match = nullptr;
+            sendText(*viewer, "Match ended");
+        }
+        matches.erase(match.id);
+    }
+
+    epoll_ctl(epollFd, EPOLL_CTL_DEL, fd, nullptr);
+    close(fd);
+    connections.erase(it);
+
+    if (opponent) {
+        opponent->match = nullptr;
+        opponent->seat = -1;
+        if (!opponent->dead) {
+            sendText(*opponent, "Your opponent left");
+            pair(*opponent);
+        }
+    }
+}
+
+void MatchServer::send(Connection& conn, const Frame& frame) {
+    if (conn.dead) return;
+
+    bool idle = conn.out.empty();
+    conn.out.push_back(frame);
+    conn.outBytes += frame->size();
+
+    // A client that stops reading is dropped rather than buffered forever
+    if (conn.outBytes > config.maxOutput) {
+        conn.dead = true;
+        return;
+    }
+
+    // Backed-up connections are flushed when epoll reports them writable
+    if (idle) flush(conn);
+}
+
+void MatchServer::sendText(Connection& conn, std::string_view text) {
+    send(conn, makeFrame(MessageType::Text, text));
+}
+
+void MatchServer::flush(Connection& conn) {
+    while (!conn.out.empty()) {
+        // Gather queued frames into one call; they stay shared, never copied
+        std::array<iovec, 64> parts;
+        std::size_t count = 0;
+        std::size_t offset = conn.outOffset;
+        for (auto it = conn.out.begin(); it != conn.out.end() && count < parts.size(); ++it, ++count) {
+            parts[count].iov_base = const_cast<char*>((*it)->data() + offset);
+            parts[count].iov_len = (*it)->size() - offset;
+            offset = 0;
+        }
+
+        msghdr message{};
+        message.msg_iov = parts.data();
+        message.msg_iovlen = count;
+        ssize_t n = sendmsg(conn.fd, &message, MSG_NOSIGNAL);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            if (errno != EAGAIN && errno != EWOULDBLOCK) conn.dead = true;
+            break;
+        }
+
+        std::size_t sent = static_cast<std::size_t>(n);
+        conn.outBytes -= sent;
+        while (sent > 0) {
+            std::size_t rest = conn.out.front()->size() - conn.outOffset;
+            if (sent < rest) {
+                conn.outOffset += sent;
+                break;
+            }
+            sent -= rest;
+            conn.out.pop_front();
+            conn.outOffset = 0;
+        }
+        if (!conn.out.empty() && conn.outOffset > 0) break;     // Socket buffer is full
+    }
+
+    // Ask for EPOLLOUT only while output is backed up
+    bool want = !conn.out.empty() && !conn.dead;
+    if (want != conn.wantWrite) {
+        epoll_event event{};
+        event.events = want ? (EPOLLIN | EPOLLOUT) : EPOLLIN;
+        event.data.fd = conn.fd;
+        epoll_ctl(epollFd, EPOLL_CTL_MOD, conn.fd, &event);
+        conn.wantWrite = want;
+    }
+}
+
+void MatchServer::broadcastState(Match& match) {
+    Frame frame = match.broadcast.publish();
+    if (!frame) return;
+
+    for (Connection* seat : match.seats) {
+        if (seat) send(*seat, frame);
+    }
+    for (Connection* viewer : match.spectators) send(*viewer, frame);
+}
@@ -0,0 +1,79 @@
+export module server;
+import <array>;
+import <cstdint>;
+import <map>;
+import <memory>;
+import <string>;
+import <string_view>;
+import <vector>;
+export import broadcast;
+import constants;
+
+using namespace GameConstants;
+
+export struct ServerConfig {
+    int port = 4040;                    // 0 picks a free port
+    int spectatorPort = -1;             // 0 picks a free port, -1 for no spectators
+    unsigned int seed = 0;              // Match n plays with seed + n
+    int startLevel = 0;
+    std::string scriptFile1 = "biquadris_sequence1.txt";
+    std::string scriptFile2 = "biquadris_sequence2.txt";
+    std::size_t maxOutput = 1 << 20;    // Unsent bytes before a client is dropped
+};
+
+// Serves any number of two-player matches from one epoll event loop on a
+// single thread. Connections are paired in arrival order; when a player
+// leaves, the opponent goes back to waiting for a new one.
+//
+// Connections on the spectator port send "watch <match id>" and then get
+// the same frames as the seats: each turn is encoded once and the buffer
+// is queued to every viewer.
+export class MatchServer {
+    struct Connection;
+    struct Match;
+
+    ServerConfig config;
+    int listenFd = -1;
+    int spectatorFd = -1;
+    int epollFd = -1;
+    int boundPort = 0;
+    int spectatorBoundPort = 0;
+    bool running = false;
+    std::map<int, std::unique_ptr<Connection>> connections;    // By socket
+    std::map<int, std::unique_ptr<Match>> matches;             // By match id
+    Connection* waiting = nullptr;
+    int nextMatchId = 0;
+
+    bool listenOn(int port, int& fd, int& bound);
+    void acceptConnections(int fd, bool spectators);
+    void handleInput(Connection& conn);
+    void handleLine(Connection& conn, std::string_view line);
+    void handleWatch(Connection& conn, std::string_view line);
+    void pair(Connection& conn);
+    void join(Connection& conn, Match& match, std::uint8_t seat);
+    void stopWatching(Connection& conn);
+    void closeConnection(int fd);
+
+    void send(Connection& conn, const Frame& frame);
+    void sendText(Connection& conn, std::string_view text);
+    void flush(Connection& conn);
+    void broadcastState(Match& match);
+
+public:
+    explicit MatchServer(const ServerConfig& cfg);
+    ~MatchServer();
+
+    MatchServer(const MatchServer&) = delete;
+    MatchServer& operator=(const MatchServer&) = delete;
+
+    // Bind and listen; prints the reason and returns false on failure
+    bool start();
+    int getPort() const;
+    int getSpectatorPort() const;
+
+    // Serve until stop() is called
+    void run();
+    void stop();
+
+    std::size_t matchCount() const;
+};
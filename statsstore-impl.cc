@@ -0,0 +1,300 @@
+module;
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstddef>
+#include <cstdio>
+module statsstore;
+import <algorithm>;
+import <array>;
+import <cstdint>;
+import <cstring>;
+import <iostream>;
+import <string>;
+import <vector>;
+import checksum;
+
+namespace {
+    constexpr char LOG_MAGIC[4] = {'B', 'Q', 'S', 'L'};
+    constexpr char SNAPSHOT_MAGIC[4] = {'B', 'Q', 'S', 'S'};
+
+    // Best score first; ties keep the older game first
+    bool ranksBefore(const ScoreIndexEntry& a, const ScoreIndexEntry& b) {
+        return a.score != b.score ? a.score > b.score : a.slot < b.slot;
+    }
+
+    std::uint32_t headerCrc(const SnapshotHeader& header) {
+        return crc32(&header, offsetof(SnapshotHeader, crc));
+    }
+
+    bool writeAll(int fd, const void* data, std::size_t size) {
+        const char* p = static_cast<const char*>(data);
+        while (size > 0) {
+            ssize_t n = ::write(fd, p, size);
+            if (n < 0 && errno == EINTR) continue;
+            if (n <= 0) return false;
+            p += n;
+            size -= static_cast<std::size_t>(n);
+        }
+        return true;
+    }
+
+    // Make a rename in the file's directory durable
+    void syncDirectory(const std::string& path) {
+        std::string::size_type slash = path.rfind('/');
+        std::string dir = slash == std::string::npos ? "." : path.substr(0, slash + 1);
+        int fd = ::open(dir.c_str(), O_RDONLY | O_DIRECTORY);
+        if (fd < 0) return;
+        fsync(fd);
+        ::close(fd);
+    }
+}
+
+StatsStore::StatsStore(const std::string& path, std::size_t every, bool sync)
+    : logPath(path + ".log"), snapshotPath(path + ".snap"), compactEvery(every ? every : 1), syncWrites(sync) {}
+
+StatsStore::~StatsStore() { close(); }
+
+bool StatsStore::open() {
+    close();
+    if (!mapSnapshot()) return false;
+    generation = snapshot ? snapshot->generation : 0;
+    if (snapshot) std::copy(snapshot->totals, snapshot->totals + 2, seats.begin());
+    return replayLog();
+}
+
+void StatsStore::close() {
+    if (logFd >= 0) ::close(logFd);
+    logFd = -1;
+    unmapSnapshot();
+    tail.clear();
+    tailIndex.clear();
+    seats = {};
+}
+
+bool StatsStore::mapSnapshot() {
+    int fd = ::open(snapshotPath.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        if (errno == ENOENT) return true;       // Nothing compacted yet
+        std::cerr << "Error: Could not open stats snapshot: " << snapshotPath << "\n";
+        return false;
+    }
+
+    struct stat info;
+    bool valid = fstat(fd, &info) == 0 && static_cast<std::size_t>(info.st_size) >= sizeof(SnapshotHeader);
+    void* data = valid ? mmap(nullptr, info.st_size, PROT_READ, MAP_SHARED, fd, 0) : MAP_FAILED;
+    ::close(fd);
+    if (data != MAP_FAILED) {
+        mapped = static_cast<const std::uint8_t*>(data);
+        mappedSize = static_cast<std::size_t>(info.st_size);
+
+        const SnapshotHeader* header = reinterpret_cast<const SnapshotHeader*>(mapped);
+        valid = std::memcmp(header->magic, SNAPSHOT_MAGIC, 4) == 0 && header->version == STATS_VERSION &&
+                header->crc == headerCrc(*header) &&
+                mappedSize == sizeof(SnapshotHeader) +
+                                  header->matchCount * (sizeof(MatchRecord) + 2 * sizeof(ScoreIndexEntry));
+        if (valid) {
+            snapshot = header;
+            snapshotRecords = reinterpret_cast<const MatchRecord*>(mapped + sizeof(SnapshotHeader));
+            snapshotIndex = reinterpret_cast<const ScoreIndexEntry*>(snapshotRecords + header->matchCount);
+            return true;
+        }
+    }
+
+    unmapSnapshot();
+    std::cerr << "Error: Could not read stats snapshot: " << snapshotPath << "\n";
+    return false;
+}
+
+void StatsStore::unmapSnapshot() {
+    if (mapped) munmap(const_cast<std::uint8_t*>(mapped), mappedSize);
+    mapped = nullptr;
+    mappedSize = 0;
+    snapshot = nullptr;
+    snapshotRecords = nullptr;
+    snapshotIndex = nullptr;
+}
+
+bool StatsStore::startLog(std::uint64_t gen) {
+    if (logFd >= 0) ::close(logFd);
+    logFd = -1;
+
+    // Written aside and renamed, so a crash leaves either log whole
+    std::string temp = logPath + ".tmp";
+    int fd = ::open(temp.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    LogHeader header{};
+    std::memcpy(header.magic, LOG_MAGIC, sizeof(header.magic));
+    header.version = STATS_VERSION;
+    header.generation = gen;
+    bool ok = fd >= 0 && writeAll(fd, &header, sizeof(header)) && fsync(fd) == 0;
+    if (fd >= 0) ::close(fd);
+    if (!ok || std::rename(temp.c_str(), logPath.c_str()) != 0) {
+        std::cerr << "Error: Could not create stats log: " << logPath << "\n";
+        return false;
+    }
+    syncDirectory(logPath);
+
+    logFd = ::open(logPath.c_str(), O_WRONLY | O_APPEND | O_CLOEXEC);
+    return logFd >= 0;
+}
+
+bool StatsStore::replayLog() {
+    int fd = ::open(logPath.c_str(), O_RDWR | O_CLOEXEC);
+    if (fd < 0) return startLog(generation);
+
+    struct stat info;
+    std::vector<std::uint8_t> data;
+    if (fstat(fd, &info) == 0) data.resize(static_cast<std::size_t>(info.st_size));
+    bool readOk = pread(fd, data.data(), data.size(), 0) == static_cast<ssize_t>(data.size());
+
+    LogHeader header{};
+    if (readOk && data.size() >= sizeof(header)) std::memcpy(&header, data.data(), sizeof(header));
+    bool headerOk = std::memcmp(header.magic, LOG_MAGIC, 4) == 0 && header.version == STATS_VERSION;
+
+    // A log that never got its header, or one the snapshot already holds
+    if (readOk && (data.size() < sizeof(header) || (headerOk && header.generation < generation))) {
+        ::close(fd);
+        return startLog(generation);
+    }
+    if (!readOk || !headerOk || header.generation != generation) {
+        ::close(fd);
+        std::cerr << "Error: Could not read stats log: " << logPath << "\n";
+        return false;
+    }
+
+    std::size_t offset = sizeof(header);
+    std::uint64_t base = snapshot ? snapshot->matchCount : 0;
+    while (offset + sizeof(LogEntry) <= data.size()) {
+        LogEntry entry;
+        std::memcpy(&entry, data.data() + offset, sizeof(entry));
+        if (entry.crc != crc32(&entry.record, sizeof(entry.record))) break;
+
+        std::uint32_t slot = static_cast<std::uint32_t>((base + tail.size()) * 2);
+        tail.push_back(entry.record);
+        tailIndex.push_back({entry.record.scores[0], slot});
+        tailIndex.push_back({entry.record.scores[1], slot + 1});
+        addToTotals(entry.record);
+        offset += sizeof(LogEntry);
+    }
+    std::sort(tailIndex.begin(), tailIndex.end(), ranksBefore);
+
+    // Drop a torn or corrupt end so new entries follow good ones
+    if (offset != data.size() && ftruncate(fd, static_cast<off_t>(offset)) != 0) {
+        ::close(fd);
+        std::cerr << "Error: Could not repair stats log: " << logPath << "\n";
+        return false;
+    }
+    ::close(fd);
+
+    logFd = ::open(logPath.c_str(), O_WRONLY | O_APPEND | O_CLOEXEC);
+    if (logFd < 0) {
+        std::cerr << "Error: Could not open stats log: " << logPath << "\n";
+        return false;
+    }
+    return true;
+}
+
+void StatsStore::addToTotals(const MatchRecord& record) {
+    for (int player = 0; player < 2; ++player) {
+        SeatTotals& seat = seats[player];
+        ++seat.games;
+        if (record.winner == player) ++seat.wins;
+        seat.linesCleared += record.linesCleared[player];
+        seat.totalScore += record.scores[player];
+        seat.highScore = std::max(seat.highScore, record.scores[player]);
+    }
+}
+
+bool StatsStore::append(const MatchRecord& record) {
+    if (logFd < 0) return false;
+
+    LogEntry entry{crc32(&record, sizeof(record)), 0, record};
+    if (!writeAll(logFd, &entry, sizeof(entry)) || (syncWrites && fdatasync(logFd) != 0)) {
+        std::cerr << "Error: Could not write stats log: " << logPath << "\n";
+        return false;
+    }
+
+    std::uint32_t slot = static_cast<std::uint32_t>(matchCount() * 2);
+    tail.push_back(record);
+    for (int player = 0; player < 2; ++player) {
+        ScoreIndexEntry scoreEntry{record.scores[player], slot + player};
+        tailIndex.insert(std::upper_bound(tailIndex.begin(), tailIndex.end(), scoreEntry, ranksBefore), scoreEntry);
+    }
+    addToTotals(record);
+
+    return tail.size() < compactEvery || compact();
+}
+
+bool StatsStore::compact() {
+    if (logFd < 0) return false;
+
+    std::uint64_t base = snapshot ? snapshot->matchCount : 0;
+    SnapshotHeader header{};
+    std::memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic));
+    header.version = STATS_VERSION;
+    header.generation = generation + 1;
+    header.matchCount = base + tail.size();
+    std::copy(seats.begin(), seats.end(), header.totals);
+    header.crc = headerCrc(header);
+
+    std::string temp = snapshotPath + ".tmp";
+    int fd = ::open(temp.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    bool ok = fd >= 0 && writeAll(fd, &header, sizeof(header)) &&
+              writeAll(fd, snapshotRecords, base * sizeof(MatchRecord)) &&
+              writeAll(fd, tail.data(), tail.size() * sizeof(MatchRecord));
+
+    // Merge the two sorted indexes, written out a block at a time
+    std::vector<ScoreIndexEntry> block;
+    block.reserve(4096);
+    const ScoreIndexEntry* old = snapshotIndex;
+    const ScoreIndexEntry* oldEnd = snapshotIndex + base * 2;
+    auto recent = tailIndex.begin();
+    while (ok && (old != oldEnd || recent != tailIndex.end())) {
+        bool takeRecent = old == oldEnd || (recent != tailIndex.end() && ranksBefore(*recent, *old));
+        block.push_back(takeRecent ? *recent++ : *old++);
+        if (block.size() == block.capacity()) {
+            ok = writeAll(fd, block.data(), block.size() * sizeof(ScoreIndexEntry));
+            block.clear();
+        }
+    }
+    ok = ok && writeAll(fd, block.data(), block.size() * sizeof(ScoreIndexEntry)) && fsync(fd) == 0;
+    if (fd >= 0) ::close(fd);
+    if (!ok || std::rename(temp.c_str(), snapshotPath.c_str()) != 0) {
+        std::cerr << "Error: Could not write stats snapshot: " << snapshotPath << "\n";
+        return false;
+    }
+    syncDirectory(snapshotPath);
+
+    // The new snapshot holds everything; until the log is replaced it is
+    // simply an older generation and is ignored on open
+    unmapSnapshot();
+    tail.clear();
+    tailIndex.clear();
+    ++generation;
+    if (!mapSnapshot()) return false;
+    return startLog(generation);
+}
+
+std::uint64_t StatsStore::matchCount() const { return (snapshot ? snapshot->matchCount : 0) + tail.size(); }
+
+const MatchRecord& StatsStore::record(std::uint64_t match) const {
+    std::uint64_t base = snapshot ? snapshot->matchCount : 0;
+    return match < base ? snapshotRecords[match] : tail[match - base];
+}
+
+const SeatTotals& StatsStore::totals(int player) const { return seats[player]; }
+
+std::vector<LeaderboardEntry> StatsStore::leaderboard(std::size_t count) const {
+    std::vector<LeaderboardEntry> top;
+    const ScoreIndexEntry* old = snapshotIndex;
+    const ScoreIndexEntry* oldEnd = snapshot ? snapshotIndex + snapshot->matchCount * 2 : snapshotIndex;
+    auto recent = tailIndex.begin();
+    while (top.size() < count && (old != oldEnd || recent != tailIndex.end())) {
+        bool takeRecent = old == oldEnd || (recent != tailIndex.end() && ranksBefore(*recent, *old));
+        const ScoreIndexEntry& entry = takeRecent ? *recent++ : *old++;
+        top.push_back({entry.score, entry.slot & 1, entry.slot >> 1});
+    }
+    return top;
+}
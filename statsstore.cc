@@ -0,0 +1,131 @@
+export module statsstore;
+import <array>;
+import <cstdint>;
+import <string>;
+import <vector>;
+
+// One finished game. Fixed size and layout, so the snapshot can be used
+// in place through a mapping.
+export struct MatchRecord {
+    std::uint64_t timestamp;            // Unix seconds when the game ended
+    std::uint32_t seed;
+    std::uint32_t durationMs;
+    std::int32_t scores[2];
+    std::uint32_t linesCleared[2];
+    std::uint32_t blocksDropped[2];
+    std::uint8_t startLevel;
+    std::uint8_t endLevels[2];
+    std::uint8_t winner;
+    std::uint32_t reserved;
+};
+
+// Running totals for one seat over every recorded game
+export struct SeatTotals {
+    std::uint64_t games;
+    std::uint64_t wins;
+    std::uint64_t linesCleared;
+    std::int64_t totalScore;
+    std::int32_t highScore;
+    std::uint32_t reserved;
+};
+
+export struct LeaderboardEntry {
+    std::int32_t score;
+    std::uint32_t player;
+    std::uint64_t match;                // Index for StatsStore::record()
+};
+
+// Files (little-endian hosts), for a store at <path>:
+//   <path>.log   LogHeader, then LogEntry per game, appended and synced
+//   <path>.snap  SnapshotHeader, MatchRecord[matchCount],
+//                ScoreIndexEntry[2 * matchCount] sorted by score, best first
+// Compaction folds the log into a new snapshot (written aside and renamed
+// over the old one), then starts an empty log with the snapshot's
+// generation. A log from an older generation is already in the snapshot.
+// Only the header is checksummed so opening stays O(1); the body is synced
+// before the rename that publishes it.
+export struct LogHeader {
+    char magic[4];                      // "BQSL"
+    std::uint32_t version;
+    std::uint64_t generation;
+};
+
+export struct LogEntry {
+    std::uint32_t crc;                  // CRC-32 of record
+    std::uint32_t reserved;
+    MatchRecord record;
+};
+
+export struct ScoreIndexEntry {
+    std::int32_t score;
+    std::uint32_t slot;                 // match * 2 + player
+};
+
+export struct SnapshotHeader {
+    char magic[4];                      // "BQSS"
+    std::uint32_t version;
+    std::uint64_t generation;
+    std::uint64_t matchCount;
+    SeatTotals totals[2];
+    std::uint32_t crc;                  // CRC-32 of the header fields above
+    std::uint32_t reserved;
+};
+
+export constexpr std::uint32_t STATS_VERSION = 1;
+
+// Durable match history with per-seat totals and a score leaderboard.
+// Opening maps the snapshot and replays only the log since the last
+// compaction, which is bounded by compactEvery; leaderboard queries merge
+// the snapshot's sorted index with the few games logged since.
+export class StatsStore {
+    std::string logPath;
+    std::string snapshotPath;
+    std::size_t compactEvery;
+    bool syncWrites;
+
+    int logFd = -1;
+    std::uint64_t generation = 0;
+
+    // Mapped snapshot
+    const std::uint8_t* mapped = nullptr;
+    std::size_t mappedSize = 0;
+    const SnapshotHeader* snapshot = nullptr;
+    const MatchRecord* snapshotRecords = nullptr;
+    const ScoreIndexEntry* snapshotIndex = nullptr;
+
+    // Games logged since the snapshot, and their index entries best first
+    std::vector<MatchRecord> tail;
+    std::vector<ScoreIndexEntry> tailIndex;
+    std::array<SeatTotals, 2> seats{};
+
+    bool mapSnapshot();
+    void unmapSnapshot();
+    bool replayLog();
+    bool startLog(std::uint64_t gen);
+    void addToTotals(const MatchRecord& record);
+
+public:
+    explicit StatsStore(const std::string& path, std::size_t compactEvery = 1024, bool syncWrites = true);
+    ~StatsStore();
+
+    StatsStore(const StatsStore&) = delete;
+    StatsStore& operator=(const StatsStore&) = delete;
+
+    // Load (or create) the store; prints the reason and returns false on failure.
+    // A torn entry at the end of the log is dropped.
+    bool open();
+    void close();
+
+    // Log a game, compacting when enough have built up; false on I/O error
+    bool append(const MatchRecord& record);
+
+    // Fold the log into a new snapshot now
+    bool compact();
+
+    std::uint64_t matchCount() const;
+    const MatchRecord& record(std::uint64_t match) const;
+    const SeatTotals& totals(int player) const;
+
+    // The best `count` single-game scores across both seats
+    std::vector<LeaderboardEntry> leaderboard(std::size_t count) const;
+};
@@ -0,0 +1,183 @@
+// Allocation budget test: runs a command script through the real
+// interpreter and fails if any command allocates more than its budget
+//
+// Usage: alloc_test <script> <budget-file> [-seed n] [-startlevel n] [-report]
+//
+// Budget file lines are "<command> <max allocations per execution>", '#'
+// starts a comment. A multiplied command ("3left") may allocate its budget
+// once per repetition. Aliases share the budget of the full name. Every
+// command the script uses must have a budget.
+//
+// The first render and a restart are run before the script and budgeted on
+// their own ("<first-render>" and "restart"), so the cost of sizing the
+// display buffers never lands on whichever command happens to run first.
+import <iostream>;
+import <fstream>;
+import <sstream>;
+import <string>;
+import <string_view>;
+import <map>;
+import <cstdint>;
+import <charconv>;
+import game;
+import command;
+import tokenreader;
+import testsupport;
+
+namespace {
+    // Alias -> the full name its budget is kept under
+    const std::map<std::string_view, std::string_view> ALIASES = {
+        {"cw", "clockwise"},
+        {"ccw", "counterclockwise"},
+        {"h", "help"},
+        {"s", "sequence"},
+    };
+
+    std::string_view budgetName(std::string_view command) {
+        auto alias = ALIASES.find(command);
+        return alias == ALIASES.end() ? command : alias->second;
+    }
+
+    struct Usage {
+        int executions = 0;
+        std::uint64_t worst = 0;    // Most allocations per repetition
+        int worstToken = 0;         // Script token index of the worst case, 0 for the warm-up
+    };
+
+    using UsageMap = std::map<std::string, Usage, std::less<>>;
+
+    void record(UsageMap& usage, std::string_view command, std::uint64_t allocations, int repeat, int tokenIndex) {
+        std::uint64_t perRepeat = (allocations + repeat - 1) / repeat;
+        auto it = usage.find(command);
+        if (it == usage.end()) it = usage.emplace(command, Usage{}).first;
+
+        Usage& u = it->second;
+        u.executions++;
+        if (perRepeat > u.worst || u.executions == 1) {
+            u.worst = perRepeat;
+            u.worstToken = tokenIndex;
+        }
+    }
+
+    bool loadBudgets(const std::string& filename, std::map<std::string, std::uint64_t, std::less<>>& budgets) {
+        std::ifstream in(filename);
+        if (!in) {
+            std::cerr << "Error: Could not open budget file: " << filename << "\n";
+            return false;
+        }
+
+        std::string line;
+        while (std::getline(in, line)) {
+            line = line.substr(0, line.find('#'));
+            std::istringstream fields(line);
+            std::string command;
+            std::uint64_t budget;
+            if (!(fields >> command >> budget)) continue;
+            if (budgetName(command) != command) {
+                std::cerr << "Error: Could not use a budget for alias " << command << "; budget "
+                          << budgetName(command) << " instead\n";
+                return false;
+            }
+            budgets[command] = budget;
+        }
+        return true;
+    }
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 3) {
+        std::cerr << "Usage: alloc_test <script> <budget-file> [-seed n] [-startlevel n] [-report]\n";
+        return 2;
+    }
+
+    std::string scriptFile = argv[1];
+    std::string budgetFile = argv[2];
+    unsigned int seed = 1;
+    int startLevel = 0;
+    bool report = false;
+
+    for (int i = 3; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "-seed" && i + 1 < argc) {
+            seed = std::stoul(argv[++i]);
+        } else if (arg == "-startlevel" && i + 1 < argc) {
+            startLevel = std::stoi(argv[++i]);
+        } else if (arg == "-report") {
+            report = true;
+        }
+    }
+
+    std::map<std::string, std::uint64_t, std::less<>> budgets;
+    if (!loadBudgets(budgetFile, budgets)) return 2;
+
+    TokenReader script(scriptFile);
+    if (!script.isOpen()) {
+        std::cerr << "Error: Could not open script: " << scriptFile << "\n";
+        return 2;
+    }
+
+    // Game output (including rendering) goes to a sink that never allocates
+    NullBuffer sink;
+    std::streambuf* original = std::cout.rdbuf(&sink);
+
+    UsageMap usage;
+    {
+        Game game(seed, startLevel, "biquadris_sequence1.txt", "biquadris_sequence2.txt", true);
+        CommandInterpreter interpreter(&game);
+
+        // Warm-up: pay the one-time costs, then start the script from a fresh game
+        std::uint64_t before = allocationCount();
+        game.render();
+        record(usage, "<first-render>", allocationCount() - before, 1, 0);
+
+        before = allocationCount();
+        interpreter.execute(interpreter.resolve("restart"), {});
+        record(usage, "restart", allocationCount() - before, 1, 0);
+
+        std::string_view token;
+        int tokenIndex = 0;
+        while (game.isGameRunning() && script.next(token)) {
+            ++tokenIndex;
+
+            // Split off the multiplier and resolve the command as the interpreter will;
+            // a count it rejects makes the token invalid
+            size_t digits = token.find_first_not_of("0123456789");
+            if (digits == std::string_view::npos) digits = token.size();
+            int repeat = 1;
+            std::string_view command = interpreter.matchCommand(token.substr(digits));
+            if (digits > 0) {
+                auto [end, error] = std::from_chars(token.data(), token.data() + digits, repeat);
+                if (error != std::errc()) command = {};
+            }
+            if (command.empty()) command = "<invalid>";
+            if (repeat < 1) repeat = 1;
+
+            before = allocationCount();
+            interpreter.executeCommand(token, script);
+            record(usage, budgetName(command), allocationCount() - before, repeat, tokenIndex);
+        }
+    }
+
+    std::cout.rdbuf(original);
+
+    bool failed = false;
+    for (const auto& [command, u] : usage) {
+        auto budget = budgets.find(command);
+        bool over = budget == budgets.end() || u.worst > budget->second;
+        failed = failed || over;
+
+        if (over || report) {
+            std::cout << (over ? "FAIL " : "ok   ") << command << ": " << u.worst << " allocations (";
+            if (u.worstToken == 0) std::cout << "warm-up";
+            else std::cout << "token " << u.worstToken;
+            std::cout << ", " << u.executions << " runs), budget ";
+            if (budget == budgets.end()) std::cout << "missing";
+            else std::cout << budget->second;
+            std::cout << "\n";
+        }
+    }
+
+    std::cout << (failed ? "FAILED" : "PASSED") << ": " << scriptFile << " (seed " << seed
+              << ", level " << startLevel << ")\n";
+    return failed ? 1 : 0;
+}
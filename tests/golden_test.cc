@@ -0,0 +1,799 @@
+// Differential golden-state test: plays seeded random command streams through
+// the real Game/Board/Block engine and through a small reference model of the
+// rules written from scratch below, comparing both players' grid, score,
+// current and next piece after every command. A divergence is shrunk to a
+// minimal command script that reproduces it. Every other stream also saves
+// and reloads the match after each command, so a checkpointed game must play
+// on exactly like one that never stopped. A three-player game then checks
+// that a multiplied drop stops at the drop that eliminates a player.
+//
+// Usage: golden_test [-streams n] [-length n] [-seed n] [-startlevel n] [-out file]
+//
+// The reference model is the spec: a faster engine (bitboards, rotation
+// tables) must keep matching it, including the bounding-box rotation quirk,
+// clearRows ordering and block-removal scoring.
+#include <stdlib.h>
+#include <unistd.h>
+import <iostream>;
+import <fstream>;
+import <sstream>;
+import <string>;
+import <string_view>;
+import <vector>;
+import <array>;
+import <map>;
+import <memory>;
+import <random>;
+import <algorithm>;
+import <utility>;
+import <cctype>;
+import game;
+import board;
+import block;
+import level;
+import scorekeeper;
+import command;
+import tokenreader;
+import constants;
+import testsupport;
+
+using namespace GameConstants;
+
+namespace {
+    const char* const SCRIPT1 = "biquadris_sequence1.txt";
+    const char* const SCRIPT2 = "biquadris_sequence2.txt";
+
+    // Round-trip the engine through Game::save/load after every command
+    bool checkpointEachCommand = false;
+
+    // ---------------------------------------------------------------------
+    // Snapshot compared between engines
+    // ---------------------------------------------------------------------
+
+    struct PlayerState {
+        std::string grid;           // TOTAL_ROWS x BOARD_WIDTH, '.' for empty
+        int score = 0;
+        int highScore = 0;
+        int wins = 0;
+        char currentType = ' ';
+        std::vector<std::pair<int, int>> currentCells;  // Sorted absolute cells
+        char nextType = ' ';
+        bool hashConsistent = true; // Incremental Board::hash() matches a full recompute
+
+        bool operator==(const PlayerState&) const = default;
+    };
+
+    struct GameState {
+        std::array<PlayerState, 2> players;
+        int currentPlayer = 0;
+        bool pendingAction = false;
+
+        bool operator==(const GameState&) const = default;
+    };
+
+    // Human-readable description of the first difference
+    std::string describeDifference(const GameState& real, const GameState& ref) {
+        std::ostringstream out;
+        if (real.currentPlayer != ref.currentPlayer) {
+            out << "current player: engine " << real.currentPlayer + 1
+                << ", reference " << ref.currentPlayer + 1 << "\n";
+        }
+        if (real.pendingAction != ref.pendingAction) {
+            out << "pending special action: engine " << real.pendingAction
+                << ", reference " << ref.pendingAction << "\n";
+        }
+        for (int p = 0; p < 2; ++p) {
+            const PlayerState& a = real.players[p];
+            const PlayerState& b = ref.players[p];
+            std::string who = "player " + std::to_string(p + 1) + " ";
+            if (a.score != b.score || a.highScore != b.highScore || a.wins != b.wins) {
+                out << who << "score/high/wins: engine " << a.score << "/" << a.highScore << "/" << a.wins
+                    << ", reference " << b.score << "/" << b.highScore << "/" << b.wins << "\n";
+            }
+            if (a.hashConsistent != b.hashConsistent) {
+                out << who << "board hash: incremental value differs from a full recompute\n";
+            }
+            if (a.nextType != b.nextType) {
+                out << who << "next piece: engine " << a.nextType << ", reference " << b.nextType << "\n";
+            }
+            if (a.currentType != b.currentType || a.currentCells != b.currentCells) {
+                out << who << "current piece: engine " << a.currentType << " at";
+                for (auto [r, c] : a.currentCells) out << " (" << r << "," << c << ")";
+                out << ", reference " << b.currentType << " at";
+                for (auto [r, c] : b.currentCells) out << " (" << r << "," << c << ")";
+                out << "\n";
+            }
+            if (a.grid != b.grid) {
+                out << who << "grid (engine | reference):\n";
+                for (int row = 0; row < TOTAL_ROWS; ++row) {
+                    out << "  " << a.grid.substr(row * BOARD_WIDTH, BOARD_WIDTH) << " | "
+                        << b.grid.substr(row * BOARD_WIDTH, BOARD_WIDTH) << "\n";
+                }
+            }
+        }
+        return out.str();
+    }
+
+    // ---------------------------------------------------------------------
+    // Real engine, driven through the command interpreter
+    // ---------------------------------------------------------------------
+
+    GameState captureEngine(Game& game) {
+        GameState state;
+        state.currentPlayer = game.getCurrentPlayer();
+        state.pendingAction = game.hasPendingEvent();
+
+        for (int p = 0; p < 2; ++p) {
+            Board* board = game.getBoard(p);
+            ScoreKeeper* score = game.getScore(p);
+            PlayerState& out = state.players[p];
+
+            out.grid.assign(TOTAL_ROWS * BOARD_WIDTH, '.');
+            for (int row = 0; row < TOTAL_ROWS; ++row) {
+                for (int col = 0; col < BOARD_WIDTH; ++col) {
+                    const Cell& cell = board->getCell(row, col);
+                    if (cell.isFilled()) out.grid[row * BOARD_WIDTH + col] = cell.getType();
+                }
+            }
+            out.score = score->getCurrentScore();
+            out.highScore = score->getHighScore();
+            out.wins = score->getWins();
+            if (const Block* current = board->getCurrentBlock()) {
+                out.currentType = current->getType();
+                out.currentCells = current->getAbsoluteCells();
+                std::sort(out.currentCells.begin(), out.currentCells.end());
+            }
+            if (const Block* next = board->getNextBlock()) out.nextType = next->getType();
+            out.hashConsistent = board->hash() == board->computeHash();
+        }
+        return state;
+    }
+
+    // Runs commands one at a time, capturing the state after each
+    std::vector<GameState> runEngine(const std::vector<std::string>& commands,
+                                     unsigned int seed, int startLevel) {
+        std::string text;
+        for (const auto& command : commands) text += command + "\n";
+
+        // The interpreter reads command arguments (force X) from the same reader
+        char path[] = "/tmp/golden_test_XXXXXX";
+        int fd = mkstemp(path);
+        if (fd < 0 || write(fd, text.data(), text.size()) != static_cast<ssize_t>(text.size())) {
+            std::cerr << "Error: Could not write command stream\n";
+            std::exit(2);
+        }
+        lseek(fd, 0, SEEK_SET);
+        unlink(path);
+
+        std::vector<GameState> states;
+        {
+            TokenReader input(fd);
+            Game game(seed, startLevel, SCRIPT1, SCRIPT2, true);
+            CommandInterpreter interpreter(&game);
+
+            std::string checkpoint;
+            std::string_view token;
+            for (size_t i = 0; i < commands.size() && input.next(token); ++i) {
+                interpreter.executeCommand(token, input);
+                if (checkpointEachCommand) {
+                    checkpoint.clear();
+                    game.save(checkpoint);
+                    if (!game.load(checkpoint)) break;  // Shows up as a divergence
+                }
+                states.push_back(captureEngine(game));
+            }
+        }
+        close(fd);
+        return states;
+    }
+
+    // ---------------------------------------------------------------------
+    // Reference model
+    // ---------------------------------------------------------------------
+
+    using Cells = std::vector<std::pair<int, int>>;   // (row, col)
+
+    Cells shapeOf(char type) {
+        switch (type) {
+            case 'I': return {{0, 0}, {0, 1}, {0, 2}, {0, 3}};
+            case 'J': return {{0, 0}, {1, 0}, {1, 1}, {1, 2}};
+            case 'L': return {{1, 0}, {1, 1}, {0, 2}, {1, 2}};
+            case 'O': return {{0, 0}, {0, 1}, {1, 0}, {1, 1}};
+            case 'S': return {{0, 1}, {0, 2}, {1, 0}, {1, 1}};
+            case 'Z': return {{0, 0}, {0, 1}, {1, 1}, {1, 2}};
+            case 'T': return {{0, 1}, {0, 0}, {1, 1}, {0, 2}};
+            default:  return {{0, 0}};
+        }
+    }
+
+    struct RefPiece {
+        char type = ' ';
+        int level = 0;
+        int id = -1;
+        int x = SPAWN_X;
+        int y = SPAWN_Y;
+        Cells cells;
+
+        Cells absolute() const {
+            Cells out;
+            for (auto [r, c] : cells) out.push_back({y + r, x + c});
+            return out;
+        }
+
+        // Rotates within the cells' bounding box, anchored at its bottom-left
+        // corner. O and single blocks never rotate.
+        void rotate(bool clockwise) {
+            if (type == 'O' || type == '*') return;
+            int minRow = cells[0].first, maxRow = cells[0].first;
+            int minCol = cells[0].second, maxCol = cells[0].second;
+            for (auto [r, c] : cells) {
+                minRow = std::min(minRow, r);
+                maxRow = std::max(maxRow, r);
+                minCol = std::min(minCol, c);
+                maxCol = std::max(maxCol, c);
+            }
+            int width = maxCol - minCol + 1;
+            int height = maxRow - minRow + 1;
+            for (auto& [r, c] : cells) {
+                int px = c - minCol;
+                int py = maxRow - r;
+                int nx = clockwise ? py : height - 1 - py;
+                int ny = clockwise ? width - 1 - px : px;
+                c = minCol + nx;
+                r = maxRow - ny;
+            }
+        }
+    };
+
+    struct RefBoard {
+        std::array<std::array<char, BOARD_WIDTH>, TOTAL_ROWS> type{};   // '\0' when empty
+        std::array<std::array<int, BOARD_WIDTH>, TOTAL_ROWS> id{};
+        std::map<int, int> active;      // Locked block id -> level generated
+        std::unique_ptr<Level> level;
+        RefPiece current;
+        RefPiece next;
+        bool hasCurrent = false;
+        bool hasNext = false;
+        int nextId = 0;
+        int sinceClear = 0;
+        bool heavy = false;
+        int score = 0;
+        int highScore = 0;
+        int wins = 0;
+
+        bool valid(const RefPiece& piece) const {
+            for (auto [r, c] : piece.absolute()) {
+                if (r < 0 || r >= TOTAL_ROWS || c < 0 || c >= BOARD_WIDTH) return false;
+                if (type[r][c] && id[r][c] != piece.id) return false;
+            }
+            return true;
+        }
+
+        bool shift(int dx, int dy) {
+            if (!hasCurrent) return false;
+            RefPiece moved = current;
+            moved.x += dx;
+            moved.y += dy;
+            if (!valid(moved)) return false;
+            current = moved;
+            return true;
+        }
+
+        void rotate(bool clockwise) {
+            if (!hasCurrent) return;
+            RefPiece turned = current;
+            turned.rotate(clockwise);
+            if (valid(turned)) current = turned;
+        }
+
+        void addScore(int points) {
+            score += points;
+            if (score > highScore) highScore = score;
+        }
+
+        RefPiece makePiece(char t) {
+            RefPiece piece;
+            piece.type = t;
+            piece.level = level->getLevelNumber();
+            piece.id = nextId++;
+            piece.cells = shapeOf(t);
+            return piece;
+        }
+
+        void place(int r, int c, char t, int blockId) {
+            type[r][c] = t;
+            id[r][c] = blockId;
+        }
+
+        void lock() {
+            for (auto [r, c] : current.absolute()) place(r, c, current.type, current.id);
+            active[current.id] = current.level;
+            hasCurrent = false;
+        }
+
+        int clearRows() {
+            int cleared = 0;
+            for (int row = TOTAL_ROWS - 1; row >= 0; --row) {
+                bool full = true;
+                for (int col = 0; col < BOARD_WIDTH; ++col) full = full && type[row][col];
+                if (!full) continue;
+
+                for (int r = row; r > 0; --r) {
+                    type[r] = type[r - 1];
+                    id[r] = id[r - 1];
+                }
+                type[0].fill('\0');
+                id[0].fill(0);
+                ++cleared;
+                ++row;
+            }
+            return cleared;
+        }
+
+        // Level 4 penalty: a single cell dropped down the center column
+        void dropCenterCell(int blockLevel) {
+            int blockId = nextId++;
+            int col = BOARD_WIDTH / 2;
+            int row = RESERVE_ROWS;
+            for (int r = RESERVE_ROWS; r < TOTAL_ROWS; ++r) {
+                if (type[r][col]) {
+                    row = r - 1;
+                    break;
+                }
+                row = r;
+            }
+            place(row, col, '*', blockId);
+            active[blockId] = blockLevel;
+        }
+
+        // Blocks with no cells left on the grid score (level + 1)^2
+        void removeClearedBlocks() {
+            for (auto it = active.begin(); it != active.end();) {
+                bool present = false;
+                for (int r = 0; r < TOTAL_ROWS && !present; ++r) {
+                    for (int c = 0; c < BOARD_WIDTH && !present; ++c) {
+                        present = type[r][c] && id[r][c] == it->first;
+                    }
+                }
+                if (present) {
+                    ++it;
+                } else {
+                    addScore((it->second + 1) * (it->second + 1));
+                    it = active.erase(it);
+                }
+            }
+        }
+
+        bool nextBlocked() const {
+            for (auto [r, c] : next.absolute()) {
+                if (type[r][c]) return true;
+            }
+            return false;
+        }
+    };
+
+    class RefGame {
+        std::array<RefBoard, 2> boards;
+        int current = PLAYER_ONE;
+        bool pending = false;
+        int pendingPlayer = PLAYER_ONE;
+        unsigned int seed;
+        int startLevel;
+
+        std::unique_ptr<Level> makeLevel(int player, int levelNum) {
+            unsigned int s = seed + (player == PLAYER_ONE ? 0 : 1);
+            switch (levelNum) {
+                case 0: return std::make_unique<Level0>(player == PLAYER_ONE ? SCRIPT1 : SCRIPT2);
+                case 1: return std::make_unique<Level1>(s);
+                case 2: return std::make_unique<Level2>(s);
+                case 3: return std::make_unique<Level3>(s);
+                default: return std::make_unique<Level4>(s);
+            }
+        }
+
+        // Piece generation reuses the real levels; only the type and level matter
+        RefPiece generate(RefBoard& b) {
+            auto block = b.level->generateBlock(b.nextId);
+            RefPiece piece = b.makePiece(block->getType());
+            piece.level = block->getLevelGenerated();
+            return piece;
+        }
+
+        void spawn(RefBoard& b) {
+            if (b.hasNext) {
+                b.current = b.next;
+                b.hasCurrent = true;
+            }
+            b.next = generate(b);
+            b.hasNext = true;
+        }
+
+        void reset() {
+            for (int p = 0; p < 2; ++p) {
+                RefBoard fresh;
+                fresh.highScore = boards[p].highScore;
+                fresh.wins = boards[p].wins;
+                boards[p] = std::move(fresh);
+                boards[p].level = makeLevel(p, startLevel);
+            }
+            current = PLAYER_ONE;
+            pending = false;
+            for (auto& b : boards) {
+                spawn(b);
+                spawn(b);
+            }
+        }
+
+        void heavyDrops() {
+            RefBoard& b = boards[current];
+            int drops = (b.level->isHeavy() ? 1 : 0) + (b.heavy ? HEAVY_EXTRA_DROP : 0);
+            for (int i = 0; i < drops; ++i) b.shift(0, 1);
+        }
+
+        // Returns true if the game ended and restarted
+        bool drop() {
+            RefBoard& b = boards[current];
+            if (b.hasCurrent) {
+                while (b.shift(0, 1)) {}
+                b.lock();
+            }
+
+            int lines = b.clearRows();
+            int levelNum = b.level->getLevelNumber();
+            if (lines > 0) {
+                b.addScore((levelNum + lines) * (levelNum + lines));
+                if (lines >= ROWS_FOR_SPECIAL_ACTION) {
+                    pending = true;
+                    pendingPlayer = current;
+                }
+            }
+
+            if (levelNum == MAX_LEVEL) {
+                if (lines > 0) {
+                    b.sinceClear = 0;
+                } else if (++b.sinceClear >= BLOCKS_BEFORE_CENTER_DROP) {
+                    b.dropCenterCell(levelNum);
+                    b.sinceClear = 0;
+                }
+            }
+
+            b.removeClearedBlocks();
+
+            if (b.nextBlocked()) {
+                boards[current == PLAYER_ONE ? PLAYER_TWO : PLAYER_ONE].wins++;
+                reset();
+                return true;
+            }
+            spawn(b);
+            return false;
+        }
+
+        void changeLevel(int delta) {
+            RefBoard& b = boards[current];
+            int levelNum = b.level->getLevelNumber() + delta;
+            if (levelNum < MIN_LEVEL || levelNum > MAX_LEVEL) return;
+            b.level = makeLevel(current, levelNum);
+        }
+
+        void answer(const std::string& action, char blockType) {
+            if (!pending) return;
+            if (action == "force" && std::string_view("IJLOSZT").find(blockType) == std::string_view::npos) {
+                return;
+            }
+            pending = false;
+            RefBoard& target = boards[pendingPlayer == PLAYER_ONE ? PLAYER_TWO : PLAYER_ONE];
+            if (action == "heavy") {
+                target.heavy = true;
+            } else if (action == "force") {
+                target.current = target.makePiece(blockType);
+                target.hasCurrent = true;
+            }
+            // Blind only changes what is displayed
+        }
+
+    public:
+        RefGame(unsigned int s, int level) : seed(s), startLevel(level) { reset(); }
+
+        void execute(const std::string& line) {
+            std::istringstream in(line);
+            std::string token, arg;
+            in >> token >> arg;
+
+            size_t digits = 0;
+            int multiplier = 0;
+            while (digits < token.size() && std::isdigit(static_cast<unsigned char>(token[digits]))) {
+                multiplier = multiplier * 10 + (token[digits++] - '0');
+            }
+            if (digits == 0) multiplier = 1;
+            std::string name = token.substr(digits);
+
+            bool answers = name == "blind" || name == "heavy" || name == "force";
+            if (pending && !answers) return;
+
+            if (answers) {
+                answer(name, arg.empty() ? '\0' : arg[0]);
+                return;
+            }
+            if (name.size() == 1) {
+                RefBoard& b = boards[current];
+                b.current = b.makePiece(name[0]);
+                b.hasCurrent = true;
+                return;
+            }
+
+            bool restarted = false;
+            for (int i = 0; i < multiplier; ++i) {
+                RefBoard& b = boards[current];
+                if (name == "left") { b.shift(-1, 0); heavyDrops(); }
+                else if (name == "right") { b.shift(1, 0); heavyDrops(); }
+                else if (name == "down") { b.shift(0, 1); heavyDrops(); }
+                else if (name == "clockwise") { b.rotate(true); heavyDrops(); }
+                else if (name == "counterclockwise") { b.rotate(false); heavyDrops(); }
+                else if (name == "levelup") changeLevel(1);
+                else if (name == "leveldown") changeLevel(-1);
+                else if (name == "drop") restarted = drop();
+
+                if (restarted || pending) break;
+            }
+
+            if (name == "drop" && !restarted) {
+                current = current == PLAYER_ONE ? PLAYER_TWO : PLAYER_ONE;
+            }
+        }
+
+        GameState capture() const {
+            GameState state;
+            state.currentPlayer = current;
+            state.pendingAction = pending;
+            for (int p = 0; p < 2; ++p) {
+                const RefBoard& b = boards[p];
+                PlayerState& out = state.players[p];
+                out.grid.assign(TOTAL_ROWS * BOARD_WIDTH, '.');
+                for (int r = 0; r < TOTAL_ROWS; ++r) {
+                    for (int c = 0; c < BOARD_WIDTH; ++c) {
+                        if (b.type[r][c]) out.grid[r * BOARD_WIDTH + c] = b.type[r][c];
+                    }
+                }
+                out.score = b.score;
+                out.highScore = b.highScore;
+                out.wins = b.wins;
+                if (b.hasCurrent) {
+                    out.currentType = b.current.type;
+                    out.currentCells = b.current.absolute();
+                    std::sort(out.currentCells.begin(), out.currentCells.end());
+                }
+                if (b.hasNext) out.nextType = b.next.type;
+            }
+            return state;
+        }
+    };
+
+    // ---------------------------------------------------------------------
+    // Streams, comparison and shrinking
+    // ---------------------------------------------------------------------
+
+    // Mostly whole placements (rotate, shift to a random column, drop) so
+    // rows fill and clear, mixed with arbitrary single commands
+    std::vector<std::string> randomStream(std::mt19937& rng, int length) {
+        struct Weighted { const char* command; int weight; bool multiply; };
+        static const Weighted COMMANDS[] = {
+            {"left", 6, true}, {"right", 6, true}, {"down", 8, true},
+            {"clockwise", 6, true}, {"counterclockwise", 6, true}, {"drop", 6, true},
+            {"levelup", 2, true}, {"leveldown", 2, true},
+            {"I", 1, false}, {"J", 1, false}, {"L", 1, false}, {"O", 1, false},
+            {"S", 1, false}, {"Z", 1, false}, {"T", 1, false},
+            {"blind", 3, false}, {"heavy", 3, false}, {"force", 3, false},
+        };
+        static const char FORCE_TYPES[] = "IJLOSZTX";
+
+        int total = 0;
+        for (const auto& c : COMMANDS) total += c.weight;
+
+        std::vector<std::string> stream;
+        while (static_cast<int>(stream.size()) < length) {
+            if (rng() % 3 != 0) {
+                int turns = static_cast<int>(rng() % NUM_ROTATION_STATES);
+                if (turns > 0) stream.push_back(std::to_string(turns) + "clockwise");
+                int shift = static_cast<int>(rng() % BOARD_WIDTH) - SPAWN_X;
+                if (shift < 0) stream.push_back(std::to_string(-shift) + "left");
+                if (shift > 0) stream.push_back(std::to_string(shift) + "right");
+                stream.push_back("drop");
+                continue;
+            }
+
+            int pick = static_cast<int>(rng() % total);
+            const Weighted* chosen = COMMANDS;
+            while (pick >= chosen->weight) pick -= (chosen++)->weight;
+
+            std::string command;
+            if (chosen->multiply && rng() % 6 == 0) command += std::to_string(rng() % 4);
+            command += chosen->command;
+            if (std::string_view(chosen->command) == "force") {
+                command += ' ';
+                command += FORCE_TYPES[rng() % 8];
+            }
+            stream.push_back(command);
+        }
+        stream.resize(length);
+        return stream;
+    }
+
+    // Index of the first command after which the engines differ, or -1
+    int firstDivergence(const std::vector<std::string>& commands, unsigned int seed, int startLevel,
+                        GameState* realOut = nullptr, GameState* refOut = nullptr) {
+        std::vector<GameState> real = runEngine(commands, seed, startLevel);
+        RefGame ref(seed, startLevel);
+        for (size_t i = 0; i < commands.size(); ++i) {
+            ref.execute(commands[i]);
+            GameState expected = ref.capture();
+            if (i >= real.size() || !(real[i] == expected)) {
+                if (realOut && i < real.size()) *realOut = real[i];
+                if (refOut) *refOut = expected;
+                return static_cast<int>(i);
+            }
+        }
+        return -1;
+    }
+
+    // Delta debugging: drop chunks of commands, then simplify what is left,
+    // as long as the engines still diverge
+    std::vector<std::string> shrink(std::vector<std::string> commands, unsigned int seed, int startLevel) {
+        auto diverges = [&](const std::vector<std::string>& c) {
+            return firstDivergence(c, seed, startLevel) >= 0;
+        };
+
+        size_t chunk = commands.size() / 2;
+        while (chunk >= 1) {
+            bool removed = false;
+            for (size_t start = 0; start < commands.size();) {
+                std::vector<std::string> candidate(commands.begin(), commands.begin() + start);
+                size_t end = std::min(commands.size(), start + chunk);
+                candidate.insert(candidate.end(), commands.begin() + end, commands.end());
+                if (!candidate.empty() && diverges(candidate)) {
+                    commands = std::move(candidate);
+                    removed = true;
+                } else {
+                    start += chunk;
+                }
+            }
+            if (!removed) chunk /= 2;
+        }
+
+        // Strip multipliers that are not needed
+        for (auto& command : commands) {
+            size_t digits = 0;
+            while (digits < command.size() && std::isdigit(static_cast<unsigned char>(command[digits]))) ++digits;
+            if (digits == 0) continue;
+            std::string original = command;
+            command = command.substr(digits);
+            if (!diverges(commands)) command = original;
+        }
+        return commands;
+    }
+
+    // ---------------------------------------------------------------------
+    // Free-for-all elimination
+    // ---------------------------------------------------------------------
+
+    // A multiplied drop that tops a player out of a three-player game must
+    // stop at that drop and pass the turn on. Returns what went wrong, or an
+    // empty string.
+    std::string checkEliminationStopsDrops() {
+        Game game(1, 0, SCRIPT1, SCRIPT2, true, nullptr, CLASSIC_BOARD, 3);
+        CommandInterpreter interpreter(&game);
+        TokenReader input(-1, 64);
+        auto run = [&](std::string_view line) {
+            input.append(line);
+            std::string_view token;
+            while (input.next(token)) interpreter.executeCommand(token, input);
+        };
+
+        // Player one stacks where pieces spawn while the others spread out,
+        // so player one tops out first
+        std::string snapshot;
+        for (int turn = 0; turn < 500 && game.isGameRunning(); ++turn) {
+            if (game.hasPendingEvent()) {
+                run("blind");
+                continue;
+            }
+            if (game.getCurrentPlayer() != PLAYER_ONE) {
+                run(turn % 2 ? "4left drop" : "6right drop");
+                continue;
+            }
+
+            // Find the drop that tops player one out, then replay it multiplied
+            snapshot.clear();
+            game.save(snapshot);
+            int dropped = game.getBlocksDropped(PLAYER_ONE);
+            run("drop");
+            if (!game.isEliminated(PLAYER_ONE)) continue;
+            if (!game.load(snapshot)) return "could not reload the match";
+
+            run("3drop");
+            if (!game.isEliminated(PLAYER_ONE)) return "3drop did not eliminate player 1";
+            if (game.getBlocksDropped(PLAYER_ONE) != dropped + 1) {
+                return "3drop dropped " + std::to_string(game.getBlocksDropped(PLAYER_ONE) - dropped) +
+                       " blocks for the eliminated player 1";
+            }
+            if (game.getCurrentPlayer() != PLAYER_TWO) return "the turn did not pass to player 2";
+            return {};
+        }
+        return "player 1 never topped out";
+    }
+}
+
+int main(int argc, char* argv[]) {
+    int streams = 50;
+    int length = 300;
+    unsigned int seed = 1;
+    int onlyLevel = -1;
+    std::string outFile = "golden_repro.txt";
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "-streams" && i + 1 < argc) {
+            streams = std::stoi(argv[++i]);
+        } else if (arg == "-length" && i + 1 < argc) {
+            length = std::stoi(argv[++i]);
+        } else if (arg == "-seed" && i + 1 < argc) {
+            seed = std::stoul(argv[++i]);
+        } else if (arg == "-startlevel" && i + 1 < argc) {
+            onlyLevel = std::stoi(argv[++i]);
+        } else if (arg == "-out" && i + 1 < argc) {
+            outFile = argv[++i];
+        }
+    }
+
+    // Game output and error messages are not part of the comparison
+    NullBuffer sink;
+    std::streambuf* originalOut = std::cout.rdbuf(&sink);
+    std::streambuf* originalErr = std::cerr.rdbuf(&sink);
+
+    int checked = 0;
+    for (int level = MIN_LEVEL; level <= MAX_LEVEL; ++level) {
+        if (onlyLevel >= 0 && level != onlyLevel) continue;
+
+        std::mt19937 rng(seed * 31 + level);
+        for (int s = 0; s < streams; ++s) {
+            unsigned int gameSeed = rng();
+            std::vector<std::string> commands = randomStream(rng, length);
+            checkpointEachCommand = s % 2 == 1;
+            int at = firstDivergence(commands, gameSeed, level);
+            ++checked;
+            if (at < 0) continue;
+
+            // Shrink to a minimal reproducer and report it
+            commands.resize(at + 1);
+            commands = shrink(commands, gameSeed, level);
+            GameState real, ref;
+            int last = firstDivergence(commands, gameSeed, level, &real, &ref);
+
+            std::cout.rdbuf(originalOut);
+            std::cerr.rdbuf(originalErr);
+
+            std::ofstream out(outFile);
+            for (const auto& command : commands) out << command << "\n";
+
+            std::cout << "FAILED: engine and reference diverge (start level " << level
+                      << ", seed " << gameSeed << ") after command " << last + 1 << " of "
+                      << commands.size() << ":\n";
+            for (const auto& command : commands) std::cout << "  " << command << "\n";
+            if (checkpointEachCommand) std::cout << "(saving and reloading the match after every command)\n";
+            std::cout << describeDifference(real, ref);
+            std::cout << "Reproduce: ./biquadris -text -seed " << gameSeed << " -startlevel " << level
+                      << " < " << outFile << "\n";
+            return 1;
+        }
+    }
+
+    std::string elimination = checkEliminationStopsDrops();
+
+    std::cout.rdbuf(originalOut);
+    std::cerr.rdbuf(originalErr);
+    if (!elimination.empty()) {
+        std::cout << "FAILED: multiplied drop in a three-player game: " << elimination << "\n";
+        return 1;
+    }
+    std::cout << "PASSED: " << checked << " streams of " << length << " commands match the reference\n";
+    return 0;
+}
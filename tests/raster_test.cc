@@ -0,0 +1,194 @@
+// Rendering golden test: draws primitives into an offscreen canvas and
+// checks pixels and encoded bytes, then renders a seeded game through the
+// offscreen graphics display and compares the saved frames against
+// recorded checksums. A change to the rasterizer, the font, the encoders
+// or the display layout shows up here; if it was intended, update the
+// recorded values from the output.
+//
+// Usage: raster_test [-out prefix]
+//
+// On a mismatch the frames are kept as <prefix>.ppm and <prefix>.png.
+#include <stdio.h>
+import <iostream>;
+import <fstream>;
+import <sstream>;
+import <string>;
+import <string_view>;
+import <cstdint>;
+import game;
+import command;
+import tokenreader;
+import canvas;
+import raster;
+import constants;
+import testsupport;
+
+using namespace GameConstants;
+using namespace std::literals;
+
+namespace {
+    constexpr std::uint32_t WHITE = 0xFFFFFFFF;
+    constexpr std::uint32_t RED = 0xFF0000FF;
+    constexpr std::uint32_t BLUE = 0xFFFF0000;
+
+    // A 2x2 image: red, blue / white, black. The PNG bytes were checked
+    // once by decompressing them with zlib.
+    constexpr std::string_view TINY_PPM = "P6\n2 2\n255\n\xff\x00\x00\x00\x00\xff\xff\xff\xff\x00\x00\x00"sv;
+    constexpr std::string_view TINY_PNG =
+        "\x89PNG\r\n\x1a\n"
+        "\x00\x00\x00\x0d" "IHDR\x00\x00\x00\x02\x00\x00\x00\x02\x08\x06\x00\x00\x00\x72\xb6\x0d\x24"
+        "\x00\x00\x00\x19" "IDAT\x78\x01\x63\xf8\xcf\xc0\xf0\x9f\x81\xe1\xff\x7f\x86\xff\xff\xff\x03\x19\x0c\xff\x01"
+        "\x4e\xc3\x08\xf8\xcd\xa7\xfb\x1a"
+        "\x00\x00\x00\x00" "IEND\xae\x42\x60\x82"sv;
+
+    // Black left half, white right half, shrunk by 2
+    constexpr std::string_view THUMB_PPM = "P6\n2 1\n255\n\x00\x00\x00\xff\xff\xff"sv;
+
+    // Seeded game rendered for the frame checksums
+    constexpr const char* GAME_COMMANDS = "right drop cw 2left drop levelup I 3right drop levelup drop";
+    constexpr std::uint64_t FRAME_PPM_HASH = 0x4df07225803f3539;
+    constexpr std::uint64_t FRAME_PNG_HASH = 0x049ffba64923f388;
+
+    int failures = 0;
+
+    void check(bool ok, std::string_view what) {
+        if (ok) return;
+        std::cout << "FAIL " << what << "\n";
+        ++failures;
+    }
+
+    std::uint64_t fnv1a(std::string_view bytes) {
+        std::uint64_t h = 0xcbf29ce484222325ull;
+        for (unsigned char c : bytes) h = (h ^ c) * 0x100000001b3ull;
+        return h;
+    }
+
+    std::string toHex(std::string_view bytes) {
+        static constexpr char DIGITS[] = "0123456789abcdef";
+        std::string out;
+        for (unsigned char c : bytes) {
+            out += "\\x";
+            out += DIGITS[c >> 4];
+            out += DIGITS[c & 0xF];
+        }
+        return out;
+    }
+
+    // Compare encoder output with its recorded bytes, printing the actual
+    // bytes on a mismatch
+    void checkBytes(std::string_view actual, std::string_view expected, std::string_view what) {
+        if (actual == expected) return;
+        std::cout << "FAIL " << what << ": got \"" << toHex(actual) << "\"\n";
+        ++failures;
+    }
+
+    std::string readFile(const std::string& filename) {
+        std::ifstream in(filename, std::ios::binary);
+        std::ostringstream bytes;
+        bytes << in.rdbuf();
+        return bytes.str();
+    }
+
+    void checkPrimitives() {
+        RasterCanvas canvas(32, 24);
+        check(canvas.pixel(0, 0) == WHITE, "a new canvas is white");
+
+        canvas.fillRectangle(2, 3, 4, 5, Canvas::Red);
+        check(canvas.pixel(2, 3) == RED && canvas.pixel(5, 7) == RED, "fillRectangle covers its area");
+        check(canvas.pixel(6, 7) == WHITE && canvas.pixel(5, 8) == WHITE, "fillRectangle stops at its edge");
+
+        canvas.drawLine(10, 0, 19, 9, Canvas::Blue);
+        check(canvas.pixel(10, 0) == BLUE && canvas.pixel(15, 5) == BLUE && canvas.pixel(19, 9) == BLUE,
+              "drawLine covers both ends and the diagonal");
+        check(canvas.pixel(11, 0) == WHITE, "drawLine is one pixel wide");
+
+        canvas.fillArc(20, 12, 10, 10, 0, 360, Canvas::Red);
+        check(canvas.pixel(25, 17) == RED, "fillArc fills the centre");
+        check(canvas.pixel(20, 12) == WHITE, "fillArc leaves the box corners");
+
+        CanvasPoint triangle[3] = {{0, 23}, {8, 23}, {0, 15}};
+        canvas.fillPolygon(triangle, 3, Canvas::Blue);
+        check(canvas.pixel(1, 22) == BLUE, "fillPolygon fills the inside");
+        check(canvas.pixel(7, 16) == WHITE, "fillPolygon leaves the outside");
+
+        // "I" is a bar with serifs, drawn in the seven rows above the baseline
+        RasterCanvas text(8, 10);
+        text.drawString(1, 8, "I", Canvas::Black);
+        check(text.pixel(3, 1) != WHITE && text.pixel(3, 4) != WHITE && text.pixel(3, 7) != WHITE,
+              "drawString draws the stem");
+        check(text.pixel(1, 4) == WHITE && text.pixel(3, 0) == WHITE && text.pixel(3, 8) == WHITE,
+              "drawString stays inside the glyph");
+    }
+
+    void checkEncoders() {
+        RasterCanvas canvas(2, 2);
+        canvas.fillRectangle(0, 0, 1, 1, Canvas::Red);
+        canvas.fillRectangle(1, 0, 1, 1, Canvas::Blue);
+        canvas.fillRectangle(1, 1, 1, 1, Canvas::Black);
+
+        std::string ppm;
+        canvas.encode(ppm, ImageFormat::Ppm);
+        checkBytes(ppm, TINY_PPM, "PPM bytes");
+
+        std::string png;
+        canvas.encode(png, ImageFormat::Png);
+        checkBytes(png, TINY_PNG, "PNG bytes");
+
+        // A thumbnail averages each scale x scale box
+        RasterCanvas big(4, 2);
+        big.fillRectangle(0, 0, 2, 2, Canvas::Black);
+        std::string thumb;
+        big.encode(thumb, ImageFormat::Ppm, 2);
+        checkBytes(thumb, THUMB_PPM, "PPM thumbnail");
+    }
+
+    void checkGame(const std::string& prefix) {
+        std::string ppmFile = prefix + ".ppm";
+        std::string pngFile = prefix + ".png";
+        {
+            NullBuffer sink;
+            std::streambuf* original = std::cout.rdbuf(&sink);
+            Game game(5, 0, "biquadris_sequence1.txt", "biquadris_sequence2.txt", false, nullptr,
+                      CLASSIC_BOARD, NUM_PLAYERS, true);
+            CommandInterpreter interpreter(&game);
+            TokenReader input(-1, 256);
+            input.append(GAME_COMMANDS);
+            game.render();
+            std::string_view token;
+            while (input.next(token)) interpreter.executeCommand(token, input);
+            std::cout.rdbuf(original);
+
+            check(game.saveFrame(0, ppmFile, ImageFormat::Ppm) && game.saveFrame(0, pngFile, ImageFormat::Png),
+                  "saving the frames");
+        }
+
+        std::uint64_t ppmHash = fnv1a(readFile(ppmFile));
+        std::uint64_t pngHash = fnv1a(readFile(pngFile));
+        bool matched = ppmHash == FRAME_PPM_HASH && pngHash == FRAME_PNG_HASH;
+        if (!matched) {
+            std::cout << "FAIL game frame: PPM 0x" << std::hex << ppmHash << ", PNG 0x" << pngHash << std::dec
+                      << " (frames kept in " << ppmFile << " and " << pngFile << ")\n";
+            ++failures;
+            return;
+        }
+        remove(ppmFile.c_str());
+        remove(pngFile.c_str());
+    }
+}
+
+int main(int argc, char* argv[]) {
+    std::string prefix = "raster_frame";
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "-out" && i + 1 < argc) prefix = argv[++i];
+    }
+
+    checkPrimitives();
+    checkEncoders();
+    checkGame(prefix);
+
+    std::cout << (failures ? "FAILED" : "PASSED") << ": rendering";
+    if (failures) std::cout << " (" << failures << " checks)";
+    std::cout << "\n";
+    return failures ? 1 : 0;
+}
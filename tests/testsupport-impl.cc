@@ -0,0 +1,23 @@
+module testsupport;
+import <cstdint>;
+import <cstdlib>;
+import <new>;
+
+namespace {
+    std::uint64_t allocations = 0;
+}
+
+std::uint64_t allocationCount() { return allocations; }
+
+// Replacement functions must belong to the global module
+extern "C++" {
+    void* operator new(std::size_t size) {
+        ++allocations;
+        if (void* p = std::malloc(size ? size : 1)) return p;
+        throw std::bad_alloc();
+    }
+
+    // Kept out of line so GCC does not pair the inlined free() with a new-expression
+    [[gnu::noinline]] void operator delete(void* p) noexcept { std::free(p); }
+    [[gnu::noinline]] void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+}
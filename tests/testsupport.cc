@@ -0,0 +1,16 @@
+export module testsupport;
+import <cstdint>;
+import <iostream>;
+
+// Helpers shared by the tests and benchmarks. Linking testsupport-impl.o
+// replaces the global operator new with one that counts allocations.
+
+// Heap allocations made through operator new since the program started
+export std::uint64_t allocationCount();
+
+// Discards output without allocating, so rendering is still measured
+export class NullBuffer : public std::streambuf {
+protected:
+    int overflow(int c) override { return c; }
+    std::streamsize xsputn(const char*, std::streamsize n) override { return n; }
+};
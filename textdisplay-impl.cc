@@ -1,31 +1,82 @@
 module textdisplay;
+import <cstdint>;
 import <iostream>;
 import <vector>;
 import <string>;
+import <utility>;
+import <variant>;
+import <bit>;
 import observer;
+import effect;
 import board;
+import instrument;
 import block;
 import constants;
 
 using namespace GameConstants;
 
+namespace {
+    constexpr std::uint64_t rowBit(int row) { return std::uint64_t{1} << row; }
+
+    // Rows covered by the blind effect (blind boundaries are relative to the visible area)
+    constexpr std::uint64_t blindRows(const BoardGeometry& geometry) {
+        return (rowBit(geometry.reserve + geometry.blindRowEnd + 1) - 1) &
+               ~(rowBit(geometry.reserve + geometry.blindRowStart) - 1);
+    }
+
+    constexpr std::uint64_t allRows(const BoardGeometry& geometry) { return rowBit(geometry.totalRows()) - 1; }
+}
+
 TextDisplay::TextDisplay(Board* b, std::ostream& os)
-    : board(b), out(os), blindMode(false) {}
+    : board(b), out(os), blindMode(false), rowCache(b->getGeometry().totalRows()),
+      previewCache(NEXT_PREVIEW_ROWS), dirtyRows(allRows(b->getGeometry())), overlayRows(0),
+      pieceType(' '), overlayStale(true), previewStale(true) {}
+
+void TextDisplay::notify(const BoardChange& change) {
+    if (auto* cells = std::get_if<CellsChanged>(&change)) {
+        for (int i = 0; i < cells->count; ++i) {
+            dirtyRows |= rowBit(cells->cells[i].first);
+        }
+        overlayStale = true;  // Ghost may land differently on the new cells
+    }
+    else if (auto* rows = std::get_if<RowsCleared>(&change)) {
+        // Every row at or above the lowest cleared row has shifted
+        dirtyRows |= rowBit(std::bit_width(rows->rowMask)) - 1;
+        overlayStale = true;
+    }
+    else if (std::holds_alternative<PieceMoved>(change)) {
+        overlayStale = true;
+    }
+    else if (std::holds_alternative<NextPieceChanged>(change)) {
+        previewStale = true;
+    }
+    else if (auto* effect = std::get_if<EffectToggled>(&change)) {
+        if (effect->effect == Effect::Type::Blind) setBlindMode(effect->active);
+    }
+}
 
-void TextDisplay::update() {
-    // Update is called when board changes, but we render on demand
+void TextDisplay::markAllDirty() {
+    rowCache.resize(board->getGeometry().totalRows());
+    dirtyRows = allRows(board->getGeometry());
+    overlayStale = true;
+    previewStale = true;
 }
 
 void TextDisplay::setBlindMode(bool blind) {
+    if (blindMode == blind) return;
     blindMode = blind;
+    dirtyRows |= blindRows(board->getGeometry());
 }
 
 void TextDisplay::setBoard(Board* b) {
     board = b;
+    blindMode = board->hasBlindEffect();
+    markAllDirty();
 }
 
 void TextDisplay::render() {
     const auto& grid = board->getGrid();
+    const BoardGeometry& geometry = board->getGeometry();
     Block* current = board->getCurrentBlock();
 
     // Create a copy of the grid to overlay current block
@@ -37,7 +88,7 @@ void TextDisplay::render() {
         for (const auto& cell : ghostCells) {
             int row = cell.first;
             int col = cell.second;
-            if (row >= 0 && row < TOTAL_ROWS && col >= 0 && col < BOARD_WIDTH) {
+            if (row >= 0 && row < geometry.totalRows() && col >= 0 && col < geometry.width) {
                 display[row][col].setType('~');
                 display[row][col].setFilled(true);
             }
@@ -50,22 +101,22 @@ void TextDisplay::render() {
         for (const auto& cell : cells) {
             int row = cell.first;
             int col = cell.second;
-            if (row >= 0 && row < TOTAL_ROWS && col >= 0 && col < BOARD_WIDTH) {
+            if (row >= 0 && row < geometry.totalRows() && col >= 0 && col < geometry.width) {
                 display[row][col].setType(current->getType());
                 display[row][col].setFilled(true);
             }
         }
     }
 
-    // Print the entire board including reserve rows (all 18 rows)
-    for (int row = 0; row < TOTAL_ROWS; ++row) {
-        for (int col = 0; col < BOARD_WIDTH; ++col) {
+    // Print the entire board including reserve rows (all 18 rows on the classic board)
+    for (int row = 0; row < geometry.totalRows(); ++row) {
+        for (int col = 0; col < geometry.width; ++col) {
             // Apply blind effect if active (only on visible rows)
-            // Blind boundaries are 0-indexed from visible area, so add RESERVE_ROWS offset
+            // Blind boundaries are 0-indexed from visible area, so add the reserve offset
             if (blindMode &&
-                row >= RESERVE_ROWS + BLIND_ROW_START &&
-                row <= RESERVE_ROWS + BLIND_ROW_END &&
-                col >= BLIND_COL_START && col <= BLIND_COL_END) {
+                row >= geometry.reserve + geometry.blindRowStart &&
+                row <= geometry.reserve + geometry.blindRowEnd &&
+                col >= geometry.blindColStart && col <= geometry.blindColEnd) {
                 out << '?';
             } else if (display[row][col].isFilled()) {
                 char cellType = display[row][col].getType();
@@ -80,14 +131,14 @@ void TextDisplay::render() {
         }
         out << '\n';
     }
-    out << std::string(BOARD_WIDTH, '-') << '\n';
+    out << std::string(geometry.width, '-') << '\n';
 }
 
 void TextDisplay::renderWithInfo(int level, int score, int highScore) {
     out << "Level: " << level << '\n';
     out << "Score: " << score << '\n';
     out << "Hi Score: " << highScore << '\n';
-    out << std::string(BOARD_WIDTH, '-') << '\n';
+    out << std::string(board->getGeometry().width, '-') << '\n';
 
     render();
 
@@ -104,98 +155,98 @@ void TextDisplay::renderWithInfo(int level, int score, int highScore) {
     }
 }
 
-std::string TextDisplay::getBlockColor(char type) const {
-    const std::string CYAN = "\033[36m";
-    const std::string BLUE = "\033[34m";
-    const std::string ORANGE = "\033[38;5;208m";
-    const std::string YELLOW = "\033[33m";
-    const std::string GREEN = "\033[32m";
-    const std::string RED = "\033[31m";
-    const std::string MAGENTA = "\033[35m";
-    const std::string WHITE = "\033[37m";
-    const std::string RESET = "\033[0m";
-
+const char* TextDisplay::getBlockColor(char type) const {
     switch (type) {
-        case 'I': return CYAN;
-        case 'J': return BLUE;
-        case 'L': return ORANGE;
-        case 'O': return YELLOW;
-        case 'S': return GREEN;
-        case 'Z': return RED;
-        case 'T': return MAGENTA;
-        case '*': return WHITE;
-        default: return RESET;
+        case 'I': return "\033[36m";        // Cyan
+        case 'J': return "\033[34m";        // Blue
+        case 'L': return "\033[38;5;208m";  // Orange
+        case 'O': return "\033[33m";        // Yellow
+        case 'S': return "\033[32m";        // Green
+        case 'Z': return "\033[31m";        // Red
+        case 'T': return "\033[35m";        // Magenta
+        case '*': return "\033[37m";        // White
+        default: return "\033[0m";
     }
 }
 
-std::string TextDisplay::renderBoardRow(int row) const {
-    const std::string BOLD = "\033[1m";
-    const std::string RED = "\033[31m";
-    const std::string RESET = "\033[0m";
-    const std::string DIM = "\033[2m";
-
-    const auto& grid = board->getGrid();
-    Block* current = board->getCurrentBlock();
+void TextDisplay::refreshRows() const {
+    Instrument::ScopedTimer timer(Instrument::Phase::TextCompose);
+    constexpr const char* BOLD = "\033[1m";
+    constexpr const char* RED = "\033[31m";
+    constexpr const char* RESET = "\033[0m";
+    constexpr const char* DIM = "\033[2m";
+    const BoardGeometry& geometry = board->getGeometry();
 
-    // Create display grid with current block overlaid
-    auto display = grid;
+    // Recompute the current/ghost overlay; rows it left or entered need rebuilding
+    if (overlayStale) {
+        Block* current = board->getCurrentBlock();
+        ghostCells.clear();
+        pieceCells.clear();
+        if (current) {
+            ghostCells = board->getGhostPosition();
+            pieceCells = current->getAbsoluteCells();
+            pieceType = current->getType();
+        }
 
-    // Overlay ghost piece first (use '~' as marker)
-    if (current) {
-        auto ghostCells = board->getGhostPosition();
+        std::uint64_t rows = 0;
         for (const auto& cell : ghostCells) {
-            int r = cell.first;
-            int c = cell.second;
-            if (r >= 0 && r < TOTAL_ROWS && c >= 0 && c < BOARD_WIDTH) {
-                display[r][c].setType('~');
-                display[r][c].setFilled(true);
-            }
+            if (cell.first >= 0 && cell.first < geometry.totalRows()) rows |= rowBit(cell.first);
+        }
+        for (const auto& cell : pieceCells) {
+            if (cell.first >= 0 && cell.first < geometry.totalRows()) rows |= rowBit(cell.first);
         }
+        dirtyRows |= rows | overlayRows;
+        overlayRows = rows;
+        overlayStale = false;
     }
 
-    // Overlay current block (overwrites ghost if at same position)
-    if (current) {
-        auto cells = current->getAbsoluteCells();
-        for (const auto& cell : cells) {
-            int r = cell.first;
-            int c = cell.second;
-            if (r >= 0 && r < TOTAL_ROWS && c >= 0 && c < BOARD_WIDTH) {
-                display[r][c].setType(current->getType());
-                display[r][c].setFilled(true);
+    const auto& grid = board->getGrid();
+    for (int row = 0; row < geometry.totalRows(); ++row) {
+        if (!(dirtyRows & rowBit(row))) continue;
+
+        std::string& result = rowCache[row];
+        result.clear();
+        for (int col = 0; col < geometry.width; ++col) {
+            // Current block overwrites the ghost, which overwrites the grid
+            char type = grid[row][col].isFilled() ? grid[row][col].getType() : EMPTY_CELL;
+            for (const auto& cell : ghostCells) {
+                if (cell.first == row && cell.second == col) type = '~';
+            }
+            for (const auto& cell : pieceCells) {
+                if (cell.first == row && cell.second == col) type = pieceType;
             }
-        }
-    }
 
-    std::string result;
-    for (int col = 0; col < BOARD_WIDTH; ++col) {
-        if (blindMode &&
-            row >= RESERVE_ROWS + BLIND_ROW_START &&
-            row <= RESERVE_ROWS + BLIND_ROW_END &&
-            col >= BLIND_COL_START && col <= BLIND_COL_END) {
-            result += BOLD + RED + "? " + RESET;
-        }
-        else if (display[row][col].isFilled()) {
-            char type = display[row][col].getType();
-            if (type == '~') {
+            if (blindMode &&
+                row >= geometry.reserve + geometry.blindRowStart &&
+                row <= geometry.reserve + geometry.blindRowEnd &&
+                col >= geometry.blindColStart && col <= geometry.blindColEnd) {
+                result.append(BOLD).append(RED).append("? ").append(RESET);
+            }
+            else if (type == '~') {
                 // Ghost piece - render as dimmed outline
-                result += DIM + "□ " + RESET;
-            } else {
-                result += BOLD + getBlockColor(type) + "█ " + RESET;
+                result.append(DIM).append("□ ").append(RESET);
+            }
+            else if (type != EMPTY_CELL) {
+                result.append(BOLD).append(getBlockColor(type)).append("█ ").append(RESET);
+            }
+            else {
+                result += "· ";
             }
-        }
-        else {
-            result += "· ";
         }
     }
+    dirtyRows = 0;
+}
 
-    return result;
+const std::string& TextDisplay::renderBoardRow(int row) const {
+    if (dirtyRows || overlayStale) refreshRows();
+    return rowCache[row];
 }
 
-std::vector<std::string> TextDisplay::renderNextBlockPreview() const {
-    const std::string BOLD = "\033[1m";
-    const std::string RESET = "\033[0m";
+void TextDisplay::refreshPreview() const {
+    Instrument::ScopedTimer timer(Instrument::Phase::TextCompose);
+    constexpr const char* BOLD = "\033[1m";
+    constexpr const char* RESET = "\033[0m";
 
-    std::vector<std::string> preview(NEXT_PREVIEW_ROWS);
     Block* next = board->getNextBlock();
 
     std::vector<std::string> grid(NEXT_PREVIEW_ROWS, std::string(NEXT_PREVIEW_COLS, ' '));
@@ -210,17 +261,21 @@ std::vector<std::string> TextDisplay::renderNextBlockPreview() const {
     }
 
     for (int row = 0; row < NEXT_PREVIEW_ROWS; row++) {
-        std::string line;
+        std::string& line = previewCache[row];
+        line.clear();
         for (int col = 0; col < NEXT_PREVIEW_COLS; col++) {
             if (grid[row][col] != ' ') {
-                line += BOLD + getBlockColor(grid[row][col]) + "█ " + RESET;
+                line.append(BOLD).append(getBlockColor(grid[row][col])).append("█ ").append(RESET);
             }
             else {
                 line += "  ";
             }
         }
-        preview[row] = line;
     }
+    previewStale = false;
+}
 
-    return preview;
+const std::vector<std::string>& TextDisplay::renderNextBlockPreview() const {
+    if (previewStale) refreshPreview();
+    return previewCache;
 }
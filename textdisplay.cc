@@ -1,7 +1,9 @@
 export module textdisplay;
+import <cstdint>;
 import <iostream>;
 import <vector>;
 import <string>;
+import <utility>;
 import observer;
 import board;
 import block;
@@ -14,17 +16,31 @@ export class TextDisplay : public IObserver {
     std::ostream& out;
     bool blindMode;
 
-    std::string getBlockColor(char type) const;
+    // Rendered rows are cached and rebuilt only when a notification dirties them
+    mutable std::vector<std::string> rowCache;
+    mutable std::vector<std::string> previewCache;
+    mutable std::uint64_t dirtyRows;     // Bit r set if row r must be rebuilt
+    mutable std::uint64_t overlayRows;   // Rows covered by current/ghost piece when last built
+    mutable std::vector<std::pair<int, int>> ghostCells;
+    mutable std::vector<std::pair<int, int>> pieceCells;
+    mutable char pieceType;
+    mutable bool overlayStale;           // Piece moved since the last rebuild
+    mutable bool previewStale;
+
+    const char* getBlockColor(char type) const;
+    void markAllDirty();
+    void refreshRows() const;
+    void refreshPreview() const;
 
 public:
     TextDisplay(Board* b, std::ostream& os = std::cout);
-    void update() override;
+    void notify(const BoardChange& change) override;
     void setBlindMode(bool blind);
     void setBoard(Board* b);
     void render();
     void renderWithInfo(int level, int score, int highScore);
 
     // Methods for side-by-side rendering
-    std::string renderBoardRow(int row) const;
-    std::vector<std::string> renderNextBlockPreview() const;
+    const std::string& renderBoardRow(int row) const;
+    const std::vector<std::string>& renderNextBlockPreview() const;
 };
@@ -0,0 +1,105 @@
+module;
+#include <fcntl.h>
+#include <unistd.h>
+#include <cerrno>
+module tokenreader;
+import <string>;
+import <string_view>;
+import <vector>;
+import <algorithm>;
+
+namespace {
+    bool isSpace(char c) {
+        return c == ' ' || c == '\n' || c == '\t' || c == '\r' || c == '\v' || c == '\f';
+    }
+}
+
+TokenReader::TokenReader(int fd, size_t bufferSize)
+    : fd(fd), ownsFd(false), eof(false), buffer(bufferSize), begin(0), end(0) {}
+
+TokenReader::TokenReader(const std::string& filename, size_t bufferSize)
+    : fd(open(filename.c_str(), O_RDONLY)), ownsFd(true), eof(false),
+      buffer(bufferSize), begin(0), end(0) {}
+
+TokenReader::~TokenReader() {
+    if (ownsFd && fd >= 0) close(fd);
+}
+
+bool TokenReader::isOpen() const { return fd >= 0; }
+
+// Append more input after the buffered bytes; returns false at end of input
+bool TokenReader::fill() {
+    if (eof || fd < 0) return false;
+
+    // Move the partial token to the front so the read has room
+    if (begin > 0) {
+        std::copy(buffer.begin() + begin, buffer.begin() + end, buffer.begin());
+        end -= begin;
+        begin = 0;
+    }
+    // A token longer than the whole buffer needs a bigger buffer
+    if (end == buffer.size()) {
+        buffer.resize(buffer.size() * 2);
+    }
+
+    ssize_t n;
+    do {
+        n = read(fd, buffer.data() + end, buffer.size() - end);
+    } while (n < 0 && errno == EINTR);
+
+    if (n <= 0) {
+        eof = true;
+        return false;
+    }
+    end += n;
+    return true;
+}
+
+void TokenReader::skipWhitespace() {
+    while (begin < end && isSpace(buffer[begin])) {
+        ++begin;
+    }
+}
+
+bool TokenReader::ready() {
+    skipWhitespace();
+    return begin < end;
+}
+
+bool TokenReader::next(std::string_view& token) {
+    skipWhitespace();
+    while (begin == end) {
+        begin = end = 0;
+        if (!fill()) return false;
+        skipWhitespace();
+    }
+
+    size_t tokenEnd = begin;
+    while (true) {
+        while (tokenEnd < end && !isSpace(buffer[tokenEnd])) {
+            ++tokenEnd;
+        }
+        if (tokenEnd < end) break;
+
+        // Token runs to the end of the buffer; read more unless input ended
+        size_t offset = tokenEnd - begin;
+        bool more = fill();
+        tokenEnd = begin + offset;
+        if (!more) break;
+    }
+
+    token = std::string_view(buffer.data() + begin, tokenEnd - begin);
+    begin = tokenEnd;
+    return true;
+}
+
+void TokenReader::append(std::string_view text) {
+    if (begin > 0) {
+        std::copy(buffer.begin() + begin, buffer.begin() + end, buffer.begin());
+        end -= begin;
+        begin = 0;
+    }
+    if (buffer.size() - end < text.size()) buffer.resize(end + text.size());
+    std::copy(text.begin(), text.end(), buffer.begin() + end);
+    end += text.size();
+}
@@ -0,0 +1,43 @@
+export module tokenreader;
+import <string>;
+import <string_view>;
+import <vector>;
+
+// Standard input file descriptor
+export constexpr int STDIN_FD = 0;
+
+// Reads whitespace-separated tokens straight from a file descriptor
+// (stdin, file or pipe) through a large buffer, bypassing iostreams.
+// Tokens are views into the buffer and stay valid until the next call to next().
+export class TokenReader {
+    int fd;
+    bool ownsFd;
+    bool eof;
+    std::vector<char> buffer;
+    size_t begin;   // First unconsumed byte
+    size_t end;     // One past the last buffered byte
+
+    bool fill();
+    void skipWhitespace();
+
+public:
+    static constexpr size_t DEFAULT_BUFFER_SIZE = 1 << 16;
+
+    explicit TokenReader(int fd, size_t bufferSize = DEFAULT_BUFFER_SIZE);
+    explicit TokenReader(const std::string& filename, size_t bufferSize = DEFAULT_BUFFER_SIZE);
+    ~TokenReader();
+    TokenReader(const TokenReader&) = delete;
+    TokenReader& operator=(const TokenReader&) = delete;
+
+    bool isOpen() const;
+
+    // True if a token can be returned without blocking on a read
+    bool ready();
+
+    // Read the next token; returns false at end of input
+    bool next(std::string_view& token);
+
+    // Queue text to be read before anything from the file descriptor. A
+    // reader on fd -1 reads only appended text (network command lines).
+    void append(std::string_view text);
+};
@@ -1,16 +1,19 @@
 module;
 #include <X11/Xlib.h>
 #include <X11/Xutil.h>
+#include <X11/keysym.h>
 module xwindow;
 import <iostream>;
 import <cstdlib>;
 import <string>;
+import <string_view>;
+import <vector>;
+import canvas;
 import constants;
 
 using namespace std;
 
-Xwindow::Xwindow(int width, int height)
-    : window_width(width), window_height(height) {
+Xwindow::Xwindow(int width, int height) : Canvas(width, height) {
 
   d = XOpenDisplay(NULL);
   if (d == NULL) {
@@ -63,166 +66,75 @@ void Xwindow::fillRectangle(int x, int y, int width, int height, int colour) {
   XFillRectangle(d, pixmap, gc, x, y, width, height);
 }
 
-void Xwindow::drawString(int x, int y, string msg) {
-  XSetForeground(d, gc, colours[White]);
-  XDrawString(d, pixmap, gc, x, y, msg.c_str(), msg.length());
-}
-
-void Xwindow::drawStringBlack(int x, int y, string msg) {
-  XSetForeground(d, gc, colours[Black]);
-  XDrawString(d, pixmap, gc, x, y, msg.c_str(), msg.length());
-  XSetForeground(d, gc, colours[White]);
+void Xwindow::drawString(int x, int y, string_view msg, int colour) {
+  XSetForeground(d, gc, colours[colour]);
+  XDrawString(d, pixmap, gc, x, y, msg.data(), msg.length());
 }
 
-void Xwindow::drawStringBlackBold(int x, int y, string msg) {
-  XSetForeground(d, gc, colours[White]);
-  XDrawString(d, pixmap, gc, x, y, msg.c_str(), msg.length());
-  XDrawString(d, pixmap, gc, x + 1, y, msg.c_str(), msg.length());
-  XDrawString(d, pixmap, gc, x, y + 1, msg.c_str(), msg.length());
-  XDrawString(d, pixmap, gc, x + 1, y + 1, msg.c_str(), msg.length());
-  XSetForeground(d, gc, colours[White]);
+void Xwindow::drawLine(int x1, int y1, int x2, int y2, int colour, int lineWidth) {
+  XSetForeground(d, gc, colours[colour]);
+  if (lineWidth != 1) XSetLineAttributes(d, gc, lineWidth, LineSolid, CapRound, JoinRound);
+  XDrawLine(d, pixmap, gc, x1, y1, x2, y2);
+  if (lineWidth != 1) XSetLineAttributes(d, gc, 1, LineSolid, CapButt, JoinMiter);
 }
 
-void Xwindow::present() {
-  XCopyArea(d, pixmap, w, gc, 0, 0, window_width, window_height, 0, 0);
-  XFlush(d);
+void Xwindow::drawArc(int x, int y, int width, int height, int startAngle, int arcAngle, int colour, int lineWidth) {
+  XSetForeground(d, gc, colours[colour]);
+  if (lineWidth != 1) XSetLineAttributes(d, gc, lineWidth, LineSolid, CapRound, JoinRound);
+  XDrawArc(d, pixmap, gc, x, y, width, height, startAngle * 64, arcAngle * 64);
+  if (lineWidth != 1) XSetLineAttributes(d, gc, 1, LineSolid, CapButt, JoinMiter);
 }
 
-void Xwindow::setWindowTitle(string title) {
-  XStoreName(d, w, title.c_str());
-  XFlush(d);
+void Xwindow::fillArc(int x, int y, int width, int height, int startAngle, int arcAngle, int colour) {
+  XSetForeground(d, gc, colours[colour]);
+  XFillArc(d, pixmap, gc, x, y, width, height, startAngle * 64, arcAngle * 64);
 }
 
-void Xwindow::drawLogo(int x, int y, int width, int height) {
-  using namespace GameConstants;
-  
-  int blockWidth = width / LOGO_NUM_LETTERS;
-  
-  for (int i = 0; i < LOGO_NUM_LETTERS; i++) {
-    int blockX = x + i * blockWidth;
-    
-    XSetForeground(d, gc, colours[LOGO_COLORS[i]]);
-    XFillRectangle(d, pixmap, gc, blockX, y, blockWidth - LOGO_BLOCK_BORDER, height);
-    
-    XSetForeground(d, gc, colours[White]);
-    XDrawRectangle(d, pixmap, gc, blockX, y, blockWidth - LOGO_BLOCK_BORDER, height);
-    
-    string letter(1, LOGO_TEXT[i]);
-    int textX = blockX + blockWidth / 2 - LOGO_TEXT_X_OFFSET;
-    int textY = y + height / 2 + LOGO_TEXT_Y_OFFSET;
-    XDrawString(d, pixmap, gc, textX, textY, letter.c_str(), 1);
+void Xwindow::fillPolygon(const CanvasPoint* points, int count, int colour) {
+  vector<XPoint> corners(count);
+  for (int i = 0; i < count; ++i) {
+    corners[i].x = static_cast<short>(points[i].x);
+    corners[i].y = static_cast<short>(points[i].y);
   }
-  
-  XSetForeground(d, gc, colours[White]);
+  XSetForeground(d, gc, colours[colour]);
+  XFillPolygon(d, pixmap, gc, corners.data(), count, Convex, CoordModeOrigin);
 }
 
-void Xwindow::drawArrowKeys(int x, int y, int keySize) {
-  int gap = 5;
-  
-  int centerX = x + keySize + gap;
-  XSetForeground(d, gc, colours[Black]);
-  XFillArc(d, pixmap, gc, centerX, y, keySize, keySize, 0, 360 * 64);
-  XSetForeground(d, gc, colours[White]);
-  XDrawArc(d, pixmap, gc, centerX, y, keySize, keySize, 0, 360 * 64);
-  
-  XPoint upTriangle[3];
-  upTriangle[0].x = centerX + keySize/2;
-  upTriangle[0].y = y + 10;
-  upTriangle[1].x = centerX + keySize/2 - 8;
-  upTriangle[1].y = y + 22;
-  upTriangle[2].x = centerX + keySize/2 + 8;
-  upTriangle[2].y = y + 22;
-  XFillPolygon(d, pixmap, gc, upTriangle, 3, Convex, CoordModeOrigin);
-  
-  int centerY = y + keySize + gap;
-  XSetForeground(d, gc, colours[Black]);
-  XFillArc(d, pixmap, gc, centerX, centerY + keySize + gap, keySize, keySize, 0, 360 * 64);
-  XSetForeground(d, gc, colours[White]);
-  XDrawArc(d, pixmap, gc, centerX, centerY + keySize + gap, keySize, keySize, 0, 360 * 64);
-  
-  int downY = centerY + keySize + gap;
-  XPoint downTriangle[3];
-  downTriangle[0].x = centerX + keySize/2;
-  downTriangle[0].y = downY + 25;
-  downTriangle[1].x = centerX + keySize/2 - 8;
-  downTriangle[1].y = downY + 13;
-  downTriangle[2].x = centerX + keySize/2 + 8;
-  downTriangle[2].y = downY + 13;
-  XFillPolygon(d, pixmap, gc, downTriangle, 3, Convex, CoordModeOrigin);
-  
-  XSetForeground(d, gc, colours[Black]);
-  XFillArc(d, pixmap, gc, x, centerY, keySize, keySize, 0, 360 * 64);
-  XSetForeground(d, gc, colours[White]);
-  XDrawArc(d, pixmap, gc, x, centerY, keySize, keySize, 0, 360 * 64);
-  
-  XPoint leftTriangle[3];
-  leftTriangle[0].x = x + 10;
-  leftTriangle[0].y = centerY + keySize/2;
-  leftTriangle[1].x = x + 22;
-  leftTriangle[1].y = centerY + keySize/2 - 8;
-  leftTriangle[2].x = x + 22;
-  leftTriangle[2].y = centerY + keySize/2 + 8;
-  XFillPolygon(d, pixmap, gc, leftTriangle, 3, Convex, CoordModeOrigin);
-  
-  int rightX = centerX + keySize + gap;
-  XSetForeground(d, gc, colours[Black]);
-  XFillArc(d, pixmap, gc, rightX, centerY, keySize, keySize, 0, 360 * 64);
-  XSetForeground(d, gc, colours[White]);
-  XDrawArc(d, pixmap, gc, rightX, centerY, keySize, keySize, 0, 360 * 64);
-  
-  XPoint rightTriangle[3];
-  rightTriangle[0].x = rightX + 25;
-  rightTriangle[0].y = centerY + keySize/2;
-  rightTriangle[1].x = rightX + 13;
-  rightTriangle[1].y = centerY + keySize/2 - 8;
-  rightTriangle[2].x = rightX + 13;
-  rightTriangle[2].y = centerY + keySize/2 + 8;
-  XFillPolygon(d, pixmap, gc, rightTriangle, 3, Convex, CoordModeOrigin);
-  
-  XSetForeground(d, gc, colours[White]);
+void Xwindow::present() {
+  XCopyArea(d, pixmap, w, gc, 0, 0, canvas_width, canvas_height, 0, 0);
+  XFlush(d);
 }
 
-void Xwindow::drawRoundedRectangle(int x, int y, int width, int height, int radius, int color) {
-  XSetForeground(d, gc, colours[color]);
-  
-  int diameter = radius * 2;
-  int lineWidth = 2;
-  XSetLineAttributes(d, gc, lineWidth, LineSolid, CapRound, JoinRound);
-  
-  XDrawLine(d, pixmap, gc, x + radius + 1, y, x + width - radius - 1, y);
-  XDrawLine(d, pixmap, gc, x + width, y + radius + 1, x + width, y + height - radius - 1);
-  XDrawLine(d, pixmap, gc, x + width - radius - 1, y + height, x + radius + 1, y + height);
-  XDrawLine(d, pixmap, gc, x, y + height - radius - 1, x, y + radius + 1);
-  
-  XDrawArc(d, pixmap, gc, x, y, diameter, diameter, 90 * 64, 90 * 64);
-  XDrawArc(d, pixmap, gc, x + width - diameter, y, diameter, diameter, 0, 90 * 64);
-  XDrawArc(d, pixmap, gc, x + width - diameter, y + height - diameter, diameter, diameter, 270 * 64, 90 * 64);
-  XDrawArc(d, pixmap, gc, x, y + height - diameter, diameter, diameter, 180 * 64, 90 * 64);
-  
-  XSetLineAttributes(d, gc, 1, LineSolid, CapButt, JoinMiter);
-  XSetForeground(d, gc, colours[White]);
-}
+void Xwindow::processEvents(vector<int>& keys) {
+  using namespace GameConstants;
 
-void Xwindow::drawTetrisBackground(int width, int height) {
-  int blockSize = 25;
-  int colors[] = {MidnightBlue, NavyBlue, RoyalBlue, MediumBlue};
-  
-  for (int y = 0; y < height; y += blockSize) {
-    for (int x = 0; x < width; x += blockSize) {
-      int colorIndex = ((x / blockSize) + (y / blockSize) * 3) % 4;
-      XSetForeground(d, gc, colours[colors[colorIndex]]);
-      XFillRectangle(d, pixmap, gc, x, y, blockSize, blockSize);
+  while (XPending(d) > 0) {
+    XEvent event;
+    XNextEvent(d, &event);
+
+    if (event.type == Expose) {
+      const XExposeEvent& e = event.xexpose;
+      XCopyArea(d, pixmap, w, gc, e.x, e.y, e.width, e.height, e.x, e.y);
+    } else if (event.type == KeyPress) {
+      char text[8];
+      KeySym sym;
+      int length = XLookupString(&event.xkey, text, sizeof text, &sym, nullptr);
+      switch (sym) {
+        case XK_Left: keys.push_back(KEY_LEFT); break;
+        case XK_Right: keys.push_back(KEY_RIGHT); break;
+        case XK_Up: keys.push_back(KEY_UP); break;
+        case XK_Down: keys.push_back(KEY_DOWN); break;
+        default:
+          if (length == 1) keys.push_back(static_cast<unsigned char>(text[0]));
+      }
     }
   }
-  
-  int patternOffset = blockSize / 2;
-  for (int y = patternOffset; y < height; y += blockSize * 2) {
-    for (int x = patternOffset; x < width; x += blockSize * 2) {
-      int colorIndex = ((x / (blockSize * 2)) + (y / (blockSize * 2)) * 3) % 4;
-      XSetForeground(d, gc, colours[colors[colorIndex]]);
-      XFillRectangle(d, pixmap, gc, x, y, blockSize, blockSize);
-    }
-  }
-  
-  XSetForeground(d, gc, colours[White]);
+  XFlush(d);
+}
+
+int Xwindow::connectionFd() const { return ConnectionNumber(d); }
+
+void Xwindow::setWindowTitle(string title) {
+  XStoreName(d, w, title.c_str());
+  XFlush(d);
 }
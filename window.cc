@@ -3,38 +3,35 @@ module;
 export module xwindow;
 import <iostream>;
 import <string>;
+import <string_view>;
+import <vector>;
+export import canvas;
 
-export class Xwindow {
+// Canvas shown in an X window; drawing goes to a pixmap that present() copies
+export class Xwindow : public Canvas {
   Display *d;
   Window w;
   int s;
   GC gc;
-  unsigned long colours[16];
+  unsigned long colours[NUM_COLOURS];
   Pixmap pixmap;
-  int window_width, window_height;
-
-  static constexpr const char* LOGO_TEXT = "BIQUADRIS";
-  static constexpr int LOGO_NUM_LETTERS = 9;
 
  public:
   Xwindow(int width=500, int height=500);
   ~Xwindow();
-  Xwindow(const Xwindow&) = delete;
-  Xwindow &operator=(const Xwindow&) = delete;
 
-  enum {White=0, Black, Red, Green, Blue, Cyan, Yellow, Magenta, Orange, Brown, DarkGreen, DarkCyan, MidnightBlue, NavyBlue, RoyalBlue, MediumBlue};
-  
-  static constexpr int LOGO_COLORS[9] = {Red, Orange, Brown, DarkGreen, DarkCyan, Blue, Magenta, Magenta, Red};
+  void fillRectangle(int x, int y, int width, int height, int colour=Black) override;
+  void drawString(int x, int y, std::string_view msg, int colour=White) override;
+  void drawLine(int x1, int y1, int x2, int y2, int colour, int lineWidth=1) override;
+  void drawArc(int x, int y, int width, int height, int startAngle, int arcAngle, int colour, int lineWidth=1) override;
+  void fillArc(int x, int y, int width, int height, int startAngle, int arcAngle, int colour) override;
+  void fillPolygon(const CanvasPoint* points, int count, int colour) override;
+  void present() override;
+  void setWindowTitle(std::string title) override;
 
-  void fillRectangle(int x, int y, int width, int height, int colour=Black);
-  void drawString(int x, int y, std::string msg);
-  void drawStringBlack(int x, int y, std::string msg);
-  void drawStringBlackBold(int x, int y, std::string msg);
-  void present();
-  void setWindowTitle(std::string title);
-  void drawLogo(int x, int y, int width, int height);
-  void drawArrowKeys(int x, int y, int keySize);
-  void drawTetrisBackground(int width, int height);
-  void drawRoundedRectangle(int x, int y, int width, int height, int radius, int color);
+  // Handle queued events without blocking. An expose copies the uncovered
+  // area back from the pixmap, which always holds the last frame; key
+  // presses are appended to keys as KEY_* codes or characters.
+  void processEvents(std::vector<int>& keys) override;
+  int connectionFd() const override;
 };
-